@@ -0,0 +1,239 @@
+#include <cctype>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+#include "Report.h"
+
+namespace {
+
+/**
+ * Just enough of a JSON parser for reading back results, going through the
+ * text with the members of Result picked out by name
+ */
+class Reader {
+public:
+  explicit Reader(std::string text) : m_text(std::move(text)) {}
+
+  std::vector<Result> results() {
+    std::vector<Result> results;
+    object([&](const std::string &key) {
+      if (key != "workloads") {
+        skipValue();
+        return;
+      }
+      array([&]() { results.push_back(result()); });
+    });
+    skipSpace();
+    if (m_pos != m_text.size()) {
+      fail("extra text at the end");
+    }
+    return results;
+  }
+
+private:
+  std::string m_text;
+  size_t m_pos = 0;
+
+  [[noreturn]] void fail(const std::string &what) {
+    throw std::runtime_error("Bad benchmark results, " + what + " at " +
+                             std::to_string(m_pos));
+  }
+
+  void skipSpace() {
+    while (m_pos < m_text.size() &&
+           std::isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+      m_pos++;
+    }
+  }
+  char peek() {
+    skipSpace();
+    return m_pos < m_text.size() ? m_text[m_pos] : '\0';
+  }
+  void expect(char c) {
+    if (peek() != c) {
+      fail(std::string("expected '") + c + "'");
+    }
+    m_pos++;
+  }
+
+  /**
+   * Steps over the comma if there is another member or element
+   */
+  bool more() {
+    if (peek() != ',') {
+      return false;
+    }
+    m_pos++;
+    return true;
+  }
+
+  template <typename F> void object(F &&member) {
+    expect('{');
+    if (peek() == '}') {
+      m_pos++;
+      return;
+    }
+    do {
+      std::string key = string();
+      expect(':');
+      member(key);
+    } while (more());
+    expect('}');
+  }
+
+  template <typename F> void array(F &&element) {
+    expect('[');
+    if (peek() == ']') {
+      m_pos++;
+      return;
+    }
+    do {
+      element();
+    } while (more());
+    expect(']');
+  }
+
+  std::string string() {
+    expect('"');
+    std::string text;
+    while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+      // Escapes are kept as the character after the backslash, names never
+      // have anything fancier in them
+      if (m_text[m_pos] == '\\') {
+        m_pos++;
+      }
+      if (m_pos < m_text.size()) {
+        text += m_text[m_pos++];
+      }
+    }
+    expect('"');
+    return text;
+  }
+
+  /**
+   * The text of a number, left for the caller to convert to the type it
+   * wants
+   */
+  std::string number() {
+    skipSpace();
+    size_t start = m_pos;
+    while (m_pos < m_text.size() &&
+           (std::isdigit(static_cast<unsigned char>(m_text[m_pos])) ||
+            std::string("+-.eE").find(m_text[m_pos]) != std::string::npos)) {
+      m_pos++;
+    }
+    if (start == m_pos) {
+      fail("expected a number");
+    }
+    return m_text.substr(start, m_pos - start);
+  }
+
+  void skipValue() {
+    char c = peek();
+    if (c == '{') {
+      object([&](const std::string &) { skipValue(); });
+    } else if (c == '[') {
+      array([&]() { skipValue(); });
+    } else if (c == '"') {
+      string();
+    } else if (std::isalpha(static_cast<unsigned char>(c))) {
+      // true, false and null
+      while (m_pos < m_text.size() &&
+             std::isalpha(static_cast<unsigned char>(m_text[m_pos]))) {
+        m_pos++;
+      }
+    } else {
+      number();
+    }
+  }
+
+  Result result() {
+    Result r;
+    std::map<std::string, double *> reals = {
+        {"seconds", &r.seconds},
+        {"generationsPerSecond", &r.generationsPerSecond},
+        {"cellsPerSecond", &r.cellsPerSecond},
+        {"nsPerChunkStep", &r.nsPerChunkStep}};
+    std::map<std::string, uint64_t *> counts = {
+        {"generations", &r.generations},
+        {"chunkSteps", &r.chunkSteps},
+        {"peakRssBytes", &r.peakRssBytes},
+        {"population", &r.population}};
+
+    object([&](const std::string &key) {
+      try {
+        if (key == "name") {
+          r.name = string();
+        } else if (reals.count(key)) {
+          *reals[key] = std::stod(number());
+        } else if (counts.count(key)) {
+          *counts[key] = std::stoull(number());
+        } else {
+          skipValue();
+        }
+      } catch (const std::logic_error &) {
+        // From stod() and stoull()
+        fail("\"" + key + "\" isn't a number");
+      }
+    });
+    return r;
+  }
+};
+
+} // namespace
+
+namespace Report {
+
+void writeJson(std::ostream &out, const std::vector<Result> &results) {
+  std::ios_base::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision(8);
+
+  out << "{\n  \"workloads\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &r = results[i];
+    out << (i ? "," : "") << "\n    {\n"
+        << "      \"name\": \"" << r.name << "\",\n"
+        << "      \"generations\": " << r.generations << ",\n"
+        << "      \"seconds\": " << r.seconds << ",\n"
+        << "      \"generationsPerSecond\": " << r.generationsPerSecond
+        << ",\n"
+        << "      \"cellsPerSecond\": " << r.cellsPerSecond << ",\n"
+        << "      \"nsPerChunkStep\": " << r.nsPerChunkStep << ",\n"
+        << "      \"chunkSteps\": " << r.chunkSteps << ",\n"
+        << "      \"peakRssBytes\": " << r.peakRssBytes << ",\n"
+        << "      \"population\": " << r.population << "\n"
+        << "    }";
+  }
+  out << "\n  ]\n}\n";
+
+  out.precision(precision);
+  out.flags(flags);
+}
+
+std::vector<Result> readJson(std::istream &in) {
+  Reader reader(std::string(std::istreambuf_iterator<char>(in), {}));
+  return reader.results();
+}
+
+std::vector<Regression> compare(const std::vector<Result> &results,
+                                const std::vector<Result> &baseline,
+                                double tolerance) {
+  std::vector<Regression> regressions;
+  for (const Result &r : results) {
+    for (const Result &b : baseline) {
+      if (b.name == r.name &&
+          r.generationsPerSecond <
+              b.generationsPerSecond * (1 - tolerance)) {
+        regressions.push_back(
+            {r.name, b.generationsPerSecond, r.generationsPerSecond});
+      }
+    }
+  }
+  return regressions;
+}
+
+} // namespace Report
@@ -0,0 +1,63 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "UpdateProfiler.h"
+
+/**
+ * What came out of timing one workload
+ */
+struct Result {
+  std::string name;
+  uint64_t generations = 0;
+  double seconds = 0;
+  double generationsPerSecond = 0;
+  // Area of the bounding box at the end for every generation, how fast a
+  // plain grid of the whole pattern would have to go to keep up
+  double cellsPerSecond = 0;
+  // Time per chunk update() stepped, 0 if it never stepped any
+  double nsPerChunkStep = 0;
+  uint64_t chunkSteps = 0;
+  // Peak resident memory of the whole process by the end of the workload
+  uint64_t peakRssBytes = 0;
+  uint64_t population = 0;
+  // Time spent in each phase of GameBoard::update() and in all of it, only
+  // in builds with GAME_OF_LIFE_PROFILE and not saved in the JSON
+  std::array<uint64_t, UpdatePhase::COUNT + 1> phaseNanos{};
+};
+
+/**
+ * Reading and writing results as JSON, an object with a "workloads" array
+ * of one object per Result with the same names as its members
+ */
+namespace Report {
+
+void writeJson(std::ostream &out, const std::vector<Result> &results);
+/**
+ * Reads back what writeJson() wrote, members it doesn't know are skipped.
+ * Throws std::runtime_error if it isn't JSON laid out like that.
+ */
+std::vector<Result> readJson(std::istream &in);
+
+/**
+ * A workload that got slower than its baseline
+ */
+struct Regression {
+  std::string name;
+  double baseline;
+  double current;
+};
+
+/**
+ * Workloads whose generations per second dropped by more than tolerance
+ * (0.1 for 10%) from the baseline, ones missing from either side are left
+ * out
+ */
+std::vector<Regression> compare(const std::vector<Result> &results,
+                                const std::vector<Result> &baseline,
+                                double tolerance);
+
+} // namespace Report
@@ -0,0 +1,151 @@
+#include <array>
+#include <bit>
+#include <random>
+#include <sstream>
+
+#include "Workloads.h"
+#include "io/Rle.h"
+
+namespace {
+
+std::unique_ptr<GameBoard> fromRle(const char *rle) {
+  auto board = std::make_unique<GameBoard>();
+  std::istringstream in(rle);
+  Rle::read(in, *board);
+  return board;
+}
+
+/**
+ * A torus of size x size with each cell alive with chance density
+ */
+std::unique_ptr<GameBoard> soup(int32_t size, double density,
+                                uint32_t seed) {
+  auto board =
+      std::make_unique<GameBoard>(LifeEngine::Topology::Torus, size, size);
+  std::mt19937 rng(seed);
+  std::bernoulli_distribution alive(density);
+
+  size_t stride = LifeEngine::regionStride(size);
+  std::vector<uint64_t> bits(stride * size, 0);
+  for (int32_t y = 0; y < size; y++) {
+    for (int32_t x = 0; x < size; x++) {
+      if (alive(rng)) {
+        bits[y * stride + x / 64] |= uint64_t(1) << (x % 64);
+      }
+    }
+  }
+  board->setRegion(0, 0, size, size, bits.data());
+  return board;
+}
+
+/**
+ * Calls f with every live cell of size x size cells of still lifes spread
+ * out on an 8 x 8 grid so none of them touch, the kind of field a soup
+ * leaves behind once it settles
+ */
+template <typename F> void forEachAshCell(int32_t size, uint32_t seed, F f) {
+  // Each one fits in 4 x 4, a row a string
+  static constexpr std::array<std::array<const char *, 4>, 6> k_stillLifes{{
+      {"oo..", "oo..", "....", "...."},
+      {".oo.", "o..o", ".oo.", "...."},
+      {".oo.", "o..o", ".o.o", "..o."},
+      {"oo..", "o.o.", ".o..", "...."},
+      {".o..", "o.o.", ".o..", "...."},
+      {"oo..", "o.o.", ".oo.", "...."},
+  }};
+
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<size_t> pick(0, k_stillLifes.size() - 1);
+  for (int32_t ty = 0; ty < size; ty += 8) {
+    for (int32_t tx = 0; tx < size; tx += 8) {
+      const auto &shape = k_stillLifes[pick(rng)];
+      for (int32_t y = 0; y < 4; y++) {
+        for (int32_t x = 0; x < 4; x++) {
+          if (shape[y][x] == 'o') {
+            f(tx + 2 + x, ty + 2 + y);
+          }
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+namespace Workloads {
+
+std::vector<Workload> all() {
+  std::vector<Workload> workloads;
+
+  workloads.push_back(
+      {"r-pentomino", "R-pentomino until it settles into 116 cells", 1103,
+       [] { return fromRle("x = 3, y = 3\nb2o$2o$bo!\n"); }, 116});
+
+  workloads.push_back(
+      {"gosper-gun", "Gosper glider gun and its stream of gliders", 6000,
+       [] {
+         return fromRle("x = 36, y = 9\n24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b"
+                        "2o12b2o$2o8bo5bo3b2o$2o8bo3bob2o4bobo$10bo5bo7bo$"
+                        "11bo3bo$12b2o!\n");
+       },
+       // 36 cells for the gun and 5 more for each glider it has let go of
+       36 + 5 * (6000 / 30)});
+
+  workloads.push_back(
+      {"line-growth",
+       "One cell high line that grows forever as two switch engines", 6000,
+       [] { return fromRle("x = 39, y = 1\n8ob5o3b3o6b7ob5o!\n"); },
+       std::nullopt});
+
+  for (int density : {10, 35, 60}) {
+    workloads.push_back({"soup-" + std::to_string(density),
+                         "1024 x 1024 torus of " + std::to_string(density) +
+                             "% random soup",
+                         200,
+                         [density] {
+                           return soup(1024, density / 100.0, density);
+                         },
+                         std::nullopt});
+  }
+
+  // Nothing in it ever changes so it ends with what it starts with
+  uint64_t ashCells = 0;
+  forEachAshCell(2048, 7, [&](int32_t, int32_t) { ashCells++; });
+  workloads.push_back({"ash-field",
+                       "2048 x 2048 cells of still lifes that never change",
+                       10000,
+                       [] {
+                         auto board = std::make_unique<GameBoard>();
+                         forEachAshCell(2048, 7, [&](int32_t x, int32_t y) {
+                           board->setPoint(x, y, true);
+                         });
+                         return board;
+                       },
+                       ashCells});
+
+  return workloads;
+}
+
+uint64_t population(GameBoard &board) {
+  std::optional<LifeEngine::Bounds> bounds = board.getBounds();
+  if (!bounds) {
+    return 0;
+  }
+
+  uint64_t count = 0;
+  int32_t width = static_cast<int32_t>(bounds->maxX - bounds->minX + 1);
+  size_t stride = LifeEngine::regionStride(width);
+  std::vector<uint64_t> bits(stride);
+  // A row at a time so a pattern that grew a long way doesn't need one huge
+  // bitmap
+  for (int64_t y = bounds->minY; y <= bounds->maxY; y++) {
+    board.getRegion(static_cast<int32_t>(bounds->minX),
+                    static_cast<int32_t>(y), width, 1, bits.data());
+    for (uint64_t word : bits) {
+      count += std::popcount(word);
+    }
+  }
+  return count;
+}
+
+} // namespace Workloads
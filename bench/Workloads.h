@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "GameBoard.h"
+
+/**
+ * One thing for the benchmarks to time, a board set up with a pattern and
+ * how many generations to run it for.
+ *
+ * Patterns with a known population at the end have it in expected, so a
+ * benchmark that got faster by getting the wrong answer doesn't count.
+ */
+struct Workload {
+  std::string name;
+  std::string description;
+  uint32_t generations;
+  std::function<std::unique_ptr<GameBoard>()> make;
+  std::optional<uint64_t> expected;
+};
+
+namespace Workloads {
+
+/**
+ * The standard set, roughly smallest to biggest so the peak memory of each
+ * one is mostly its own
+ */
+std::vector<Workload> all();
+
+/**
+ * Live cells of a board, counted out of a region bitmap of its bounds
+ */
+uint64_t population(GameBoard &board);
+
+} // namespace Workloads
@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+// After windows.h
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "Report.h"
+#include "Workloads.h"
+
+namespace {
+
+/**
+ * Most memory the process has had resident at once so far
+ */
+uint64_t peakRssBytes() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                            sizeof(counters))) {
+    return 0;
+  }
+  return counters.PeakWorkingSetSize;
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  return uint64_t(usage.ru_maxrss);
+#else
+  // Kilobytes everywhere else
+  return uint64_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+Result run(const Workload &workload, uint32_t threads) {
+  std::unique_ptr<GameBoard> board = workload.make();
+  board->setThreadCount(threads);
+  uint64_t steppedBefore = board->getSteppedChunks();
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < workload.generations; i++) {
+    board->update();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  Result r;
+  r.name = workload.name;
+  r.generations = workload.generations;
+  r.seconds = elapsed.count();
+  r.generationsPerSecond = r.generations / r.seconds;
+  r.chunkSteps = board->getSteppedChunks() - steppedBefore;
+  r.nsPerChunkStep = r.chunkSteps ? r.seconds * 1e9 / r.chunkSteps : 0;
+  if (std::optional<LifeEngine::Bounds> bounds = board->getBounds()) {
+    double area = double(bounds->maxX - bounds->minX + 1) *
+                  double(bounds->maxY - bounds->minY + 1);
+    r.cellsPerSecond = area * r.generationsPerSecond;
+  }
+  r.population = Workloads::population(*board);
+  r.peakRssBytes = peakRssBytes();
+  r.phaseNanos = board->getProfiler().totals();
+  return r;
+}
+
+void usage() {
+  std::cerr
+      << "Usage: GameOfLifeBench [options]\n"
+         "  --json PATH        write the results to PATH as JSON, - for "
+         "stdout\n"
+         "  --baseline PATH    compare against results saved with --json\n"
+         "  --tolerance F      slowdown allowed against the baseline, "
+         "default 0.15\n"
+         "  --only NAME        only run the workload called NAME\n"
+         "  --threads N        threads each board updates on, default 1\n"
+         "  --repeat N         runs of each workload to keep the fastest "
+         "of, default 3\n"
+         "  --list             list the workloads and exit\n"
+         "  --help             show this and exit\n";
+}
+
+} // namespace
+
+/**
+ * Runs the standard workloads headless on a GameBoard and prints how fast
+ * each one went. With a baseline it exits with 1 if any of them got slower
+ * than the tolerance allows, and with 2 if a pattern came out wrong.
+ */
+int main(int argc, char **argv) {
+  std::string jsonPath, baselinePath, only;
+  double tolerance = 0.15;
+  uint32_t threads = 1;
+  uint32_t repeat = 3;
+  bool list = false;
+
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      auto value = [&]() -> std::string {
+        if (i + 1 >= argc) {
+          throw std::invalid_argument(arg + " needs a value");
+        }
+        return argv[++i];
+      };
+
+      if (arg == "--json") {
+        jsonPath = value();
+      } else if (arg == "--baseline") {
+        baselinePath = value();
+      } else if (arg == "--tolerance") {
+        tolerance = std::stod(value());
+      } else if (arg == "--only") {
+        only = value();
+      } else if (arg == "--threads") {
+        threads = static_cast<uint32_t>(std::stoul(value()));
+      } else if (arg == "--repeat") {
+        repeat = std::max(1, std::stoi(value()));
+      } else if (arg == "--list") {
+        list = true;
+      } else if (arg == "--help") {
+        usage();
+        return EXIT_SUCCESS;
+      } else {
+        throw std::invalid_argument("Unknown option " + arg);
+      }
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  std::vector<Workload> workloads = Workloads::all();
+  if (list) {
+    for (const Workload &w : workloads) {
+      std::cout << std::left << std::setw(14) << w.name << w.description
+                << '\n';
+    }
+    return EXIT_SUCCESS;
+  }
+
+  // With the JSON on stdout the table goes to stderr so it doesn't get in
+  // the way
+  std::ostream &table = jsonPath == "-" ? std::cerr : std::cout;
+  table << std::left << std::setw(14) << "workload" << std::right
+        << std::setw(12) << "gens/s" << std::setw(14) << "Mcells/s"
+        << std::setw(12) << "ns/chunk" << std::setw(10) << "RSS MiB"
+        << std::setw(12) << "population" << '\n';
+
+  std::vector<Result> results;
+  bool wrong = false;
+  for (const Workload &w : workloads) {
+    if (!only.empty() && w.name != only) {
+      continue;
+    }
+
+    // The fastest run is the one with the least noise from everything else
+    // going on
+    Result r = run(w, threads);
+    for (uint32_t i = 1; i < repeat; i++) {
+      Result again = run(w, threads);
+      if (again.seconds < r.seconds) {
+        r = again;
+      }
+    }
+    r.peakRssBytes = peakRssBytes();
+    results.push_back(r);
+    table << std::left << std::setw(14) << r.name << std::right
+          << std::fixed << std::setprecision(1) << std::setw(12)
+          << r.generationsPerSecond << std::setw(14)
+          << r.cellsPerSecond / 1e6 << std::setw(12) << r.nsPerChunkStep
+          << std::setw(10) << r.peakRssBytes / (1024.0 * 1024.0)
+          << std::setw(12) << r.population << '\n';
+    if constexpr (UpdateProfiler::k_enabled) {
+      // Share of the update each phase took
+      table << "  ";
+      for (uint32_t p = 0; p < UpdatePhase::COUNT; p++) {
+        table << ' ' << UpdatePhase::k_names[p] << ' '
+              << 100.0 * r.phaseNanos[p] /
+                     std::max<uint64_t>(r.phaseNanos[UpdatePhase::COUNT], 1)
+              << '%';
+      }
+      table << '\n';
+    }
+
+    if (w.expected && r.population != *w.expected) {
+      std::cerr << w.name << " ended with " << r.population
+                << " cells instead of " << *w.expected << '\n';
+      wrong = true;
+    }
+  }
+  table << std::defaultfloat << std::setprecision(6);
+
+  if (jsonPath == "-") {
+    Report::writeJson(std::cout, results);
+  } else if (!jsonPath.empty()) {
+    std::ofstream out(jsonPath);
+    Report::writeJson(out, results);
+    if (!out) {
+      std::cerr << "Couldn't write " << jsonPath << '\n';
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (wrong) {
+    return 2;
+  }
+
+  if (!baselinePath.empty()) {
+    std::ifstream in(baselinePath);
+    if (!in) {
+      std::cerr << "Couldn't read " << baselinePath << '\n';
+      return EXIT_FAILURE;
+    }
+
+    std::vector<Report::Regression> regressions;
+    try {
+      regressions =
+          Report::compare(results, Report::readJson(in), tolerance);
+    } catch (const std::runtime_error &e) {
+      std::cerr << baselinePath << ": " << e.what() << '\n';
+      return EXIT_FAILURE;
+    }
+
+    for (const Report::Regression &r : regressions) {
+      std::cerr << r.name << " slowed down from " << r.baseline << " to "
+                << r.current << " generations/s\n";
+    }
+    if (!regressions.empty()) {
+      return 1;
+    }
+    table << "No slowdowns past " << tolerance * 100 << "% against "
+          << baselinePath << '\n';
+  }
+
+  return EXIT_SUCCESS;
+}
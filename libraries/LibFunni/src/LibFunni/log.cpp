@@ -0,0 +1,307 @@
+// log.cpp : The ring buffers and writer thread behind funni::Logger
+//
+
+#include "pch.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "log.h"
+
+namespace funni::detail {
+
+namespace {
+
+// How long the writer sleeps when every ring was empty. Log calls never wake
+// it up, that would cost them a lock.
+constexpr auto k_idleWait = std::chrono::milliseconds(5);
+
+// Reads one argument the way LogBackend::encode() wrote it and appends it to
+// line, returns where the next one starts
+const std::byte *appendArg(std::string &line, const std::byte *arg) {
+  ArgType type;
+  std::memcpy(&type, arg++, 1);
+  auto read = [&](auto &value) {
+    std::memcpy(&value, arg, sizeof(value));
+    arg += sizeof(value);
+  };
+
+  char text[32];
+  switch (type) {
+  case ArgType::Int: {
+    int64_t v;
+    read(v);
+    std::snprintf(text, sizeof(text), "%lld", static_cast<long long>(v));
+    break;
+  }
+  case ArgType::Uint: {
+    uint64_t v;
+    read(v);
+    std::snprintf(text, sizeof(text), "%llu",
+                  static_cast<unsigned long long>(v));
+    break;
+  }
+  case ArgType::Float: {
+    double v;
+    read(v);
+    std::snprintf(text, sizeof(text), "%g", v);
+    break;
+  }
+  case ArgType::Bool: {
+    uint8_t v;
+    read(v);
+    std::snprintf(text, sizeof(text), "%s", v ? "true" : "false");
+    break;
+  }
+  case ArgType::Char: {
+    char v;
+    read(v);
+    line += v;
+    return arg;
+  }
+  case ArgType::String: {
+    uint32_t size;
+    read(size);
+    line.append(reinterpret_cast<const char *>(arg), size);
+    return arg + size;
+  }
+  case ArgType::Pointer: {
+    uintptr_t v;
+    read(v);
+    std::snprintf(text, sizeof(text), "0x%llx",
+                  static_cast<unsigned long long>(v));
+    break;
+  }
+  }
+  line += text;
+  return arg;
+}
+
+} // namespace
+
+LogRing::LogRing(uint32_t thread, size_t capacity)
+    : m_bytes(std::make_unique<std::byte[]>(std::bit_ceil(capacity))),
+      m_mask(std::bit_ceil(capacity) - 1), m_thread(thread) {}
+
+bool LogRing::tryPush(const std::byte *record, size_t size) {
+  uint64_t head = m_head.load(std::memory_order_relaxed);
+  if (head + size - m_cachedTail > m_mask + 1) {
+    m_cachedTail = m_tail.load(std::memory_order_acquire);
+    if (head + size - m_cachedTail > m_mask + 1) {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
+
+  copyIn(head, record, size);
+  m_head.store(head + size, std::memory_order_release);
+  return true;
+}
+
+void LogRing::copyIn(uint64_t at, const std::byte *from, size_t size) {
+  // In two pieces when it goes past the end and around to the start
+  size_t start = at & m_mask;
+  size_t first = std::min(size, m_mask + 1 - start);
+  std::memcpy(m_bytes.get() + start, from, first);
+  std::memcpy(m_bytes.get(), from + first, size - first);
+}
+
+void LogRing::copyOut(uint64_t at, std::byte *to, size_t size) const {
+  size_t start = at & m_mask;
+  size_t first = std::min(size, m_mask + 1 - start);
+  std::memcpy(to, m_bytes.get() + start, first);
+  std::memcpy(to + first, m_bytes.get(), size - first);
+}
+
+LogBackend &LogBackend::instance() {
+  static LogBackend backend;
+  return backend;
+}
+
+LogBackend::LogBackend() : m_epoch(std::chrono::steady_clock::now()) {}
+
+LogBackend::~LogBackend() { stop(); }
+
+bool LogBackend::start(std::ostream &out) {
+  std::lock_guard lock(m_mutex);
+  if (m_running) {
+    return true;
+  }
+
+  m_out = &out;
+  m_running = true;
+  m_stopping = false;
+  m_writer = std::thread(&LogBackend::run, this);
+  return true;
+}
+
+bool LogBackend::start(const std::string &path) {
+  std::lock_guard lock(m_mutex);
+  if (m_running) {
+    return true;
+  }
+
+  auto file = std::make_unique<std::ofstream>(path);
+  if (!*file) {
+    return false;
+  }
+  m_file = std::move(file);
+  m_out = m_file.get();
+  m_running = true;
+  m_stopping = false;
+  m_writer = std::thread(&LogBackend::run, this);
+  return true;
+}
+
+void LogBackend::stop() {
+  {
+    std::lock_guard lock(m_mutex);
+    if (!m_running || m_stopping) {
+      return;
+    }
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+  m_writer.join();
+
+  std::lock_guard lock(m_mutex);
+  m_running = false;
+  m_file.reset();
+  m_out = nullptr;
+}
+
+uint16_t LogBackend::addTag(const std::string &tag) {
+  std::lock_guard lock(m_mutex);
+  auto found = std::find(m_tags.begin(), m_tags.end(), tag);
+  if (found != m_tags.end()) {
+    return static_cast<uint16_t>(found - m_tags.begin());
+  }
+  if (m_tags.size() >= k_maxTags) {
+    throw std::length_error("Too many log tags, " + tag + " would be " +
+                            std::to_string(k_maxTags + 1));
+  }
+  m_tags.push_back(tag);
+  return static_cast<uint16_t>(m_tags.size() - 1);
+}
+
+LogBackend::ThreadLog &LogBackend::threadLog() {
+  thread_local ThreadLog log;
+  if (!log.ring) {
+    // Only the first time a thread logs
+    std::lock_guard lock(m_mutex);
+    log.ring = std::make_shared<LogRing>(m_threadCount++, k_ringBytes);
+    m_rings.push_back(log.ring);
+  }
+  return log;
+}
+
+LogBackend::ThreadLog::~ThreadLog() {
+  if (ring) {
+    ring->closed.store(true, std::memory_order_release);
+  }
+}
+
+void LogBackend::append(std::vector<std::byte> &to, const void *from,
+                        size_t size) {
+  size_t at = to.size();
+  to.resize(at + size);
+  std::memcpy(to.data() + at, from, size);
+}
+
+void LogBackend::run() {
+  std::unique_lock lock(m_mutex);
+  while (!m_stopping) {
+    lock.unlock();
+    bool any = drainAll();
+    lock.lock();
+    if (!any) {
+      m_wake.wait_for(lock, k_idleWait, [this]() { return m_stopping; });
+    }
+  }
+
+  // Whatever got logged before stop() was called
+  lock.unlock();
+  drainAll();
+}
+
+bool LogBackend::drainAll() {
+  // Copies so log calls can make new rings and loggers while this writes
+  std::vector<std::shared_ptr<LogRing>> rings;
+  {
+    std::lock_guard lock(m_mutex);
+    rings = m_rings;
+  }
+
+  size_t written = 0;
+  for (const std::shared_ptr<LogRing> &ring : rings) {
+    // Checked first, anything the thread logged before it exited is in the
+    // ring by then
+    bool closed = ring->closed.load(std::memory_order_acquire);
+    written += ring->drain(
+        [&](const RecordHeader &header, const std::byte *args) {
+          write(*ring, header, args);
+        },
+        m_record);
+
+    if (uint64_t dropped = ring->takeDropped()) {
+      m_line.clear();
+      m_line += "W/funni: thread " + std::to_string(ring->thread()) +
+                " dropped " + std::to_string(dropped) +
+                " log records, its ring was full\n";
+      *m_out << m_line;
+      written++;
+    }
+
+    if (closed) {
+      std::lock_guard lock(m_mutex);
+      m_rings.erase(std::find(m_rings.begin(), m_rings.end(), ring));
+    }
+  }
+
+  if (written) {
+    m_out->flush();
+  }
+  return written > 0;
+}
+
+void LogBackend::write(const LogRing &ring, const RecordHeader &header,
+                       const std::byte *args) {
+  char prefix[64];
+  std::snprintf(prefix, sizeof(prefix), "[%.6f t%u] %c/",
+                static_cast<double>(header.nanos) / 1e9, ring.thread(),
+                header.level);
+  m_line = prefix;
+  if (header.tag >= m_writerTags.size()) {
+    // A logger made since the last time. Its tag was added before anything
+    // was logged with it, so it is there now.
+    std::lock_guard lock(m_mutex);
+    m_writerTags.insert(m_writerTags.end(),
+                        m_tags.begin() + m_writerTags.size(), m_tags.end());
+  }
+  m_line += m_writerTags[header.tag];
+  m_line += ": ";
+
+  uint32_t left = header.args;
+  for (const char *c = header.format; *c; c++) {
+    if (c[0] == '{' && c[1] == '}' && left > 0) {
+      args = appendArg(m_line, args);
+      left--;
+      c++;
+    } else {
+      m_line += *c;
+    }
+  }
+  // More arguments than {}, they still go on the end
+  for (; left > 0; left--) {
+    m_line += ' ';
+    args = appendArg(m_line, args);
+  }
+
+  m_line += '\n';
+  *m_out << m_line;
+}
+
+} // namespace funni::detail
@@ -1,54 +1,294 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
-// TODO: super unfinished, need to verify the behavior of this juvenile
-// metaprogramming monstrosity
 namespace funni {
 
+// A log call only copies its arguments into a ring buffer of the thread it is
+// on, nothing gets formatted or written there. One writer thread shared by
+// every logger empties the rings, formats the records and writes them out, so
+// a hot loop that logs never waits on the terminal or a file.
+//
+// Formats use {} for each argument in order, like "stepped {} chunks in {}
+// ms". The format is kept by pointer and only read on the writer thread, so
+// it has to be a string literal (or live as long as the logger). Arguments can
+// be any number, bool, char, pointer or string, strings get copied.
+
+namespace detail {
+
+enum class ArgType : uint8_t { Int, Uint, Float, Bool, Char, String, Pointer };
+
+// What starts every record in a ring, followed by its arguments as an ArgType
+// byte and the value each
+struct RecordHeader {
+  // Bytes of the whole record, header included
+  uint32_t size;
+  uint16_t tag;
+  char level;
+  uint8_t args;
+  uint64_t nanos;
+  const char *format;
+};
+
+// Single producer single consumer ring of bytes. The thread that owns it
+// pushes whole records and the writer thread takes them back out, neither
+// ever locks or waits. A record that doesn't fit is dropped and counted.
+class LogRing {
+public:
+  explicit LogRing(uint32_t thread, size_t capacity);
+
+  LogRing(const LogRing &) = delete;
+  const LogRing &operator=(const LogRing &) = delete;
+
+  // Producer side
+  bool tryPush(const std::byte *record, size_t size);
+
+  // Consumer side, calls f(header, args) for every record in the ring and
+  // returns how many there were
+  template <typename F> size_t drain(F &&f, std::vector<std::byte> &buffer);
+  uint64_t takeDropped() { return m_dropped.exchange(0); }
+
+  uint32_t thread() const { return m_thread; }
+  // Set once the thread that owns it has exited, the writer gets rid of the
+  // ring once it is empty
+  std::atomic<bool> closed{false};
+
+private:
+  void copyIn(uint64_t at, const std::byte *from, size_t size);
+  void copyOut(uint64_t at, std::byte *to, size_t size) const;
+
+  std::unique_ptr<std::byte[]> m_bytes;
+  size_t m_mask;
+  uint32_t m_thread;
+  // Each side's position on its own cache line along with its copy of the
+  // other side's, which only gets loaded again when the ring looks full or
+  // empty
+  alignas(64) std::atomic<uint64_t> m_head{0};
+  uint64_t m_cachedTail = 0;
+  std::atomic<uint64_t> m_dropped{0};
+  alignas(64) std::atomic<uint64_t> m_tail{0};
+};
+
+// The writer thread and every thread's ring, one for the whole program
+class LogBackend {
+public:
+  // Bytes in each thread's ring
+  static constexpr size_t k_ringBytes = 64 * 1024;
+  // Different tags there can be, each record keeps its tag in 16 bits
+  static constexpr size_t k_maxTags = 65536;
+
+  static LogBackend &instance();
+  ~LogBackend();
+
+  // Starts the writer on out (or a file at path), false if the file can't be
+  // opened. Does nothing if it is already going.
+  bool start(std::ostream &out);
+  bool start(const std::string &path);
+  // Writes out everything logged so far and stops the writer
+  void stop();
+
+  // Id of a tag for records, the same one for the same tag. Throws
+  // std::length_error past k_maxTags different ones.
+  uint16_t addTag(const std::string &tag);
+
+  template <typename... Args>
+  void push(uint16_t tag, char level, const char *format,
+            const Args &...args);
+
+private:
+  LogBackend();
+
+  // This thread's ring and the bytes a record is put together in before it
+  // goes into it
+  struct ThreadLog {
+    std::shared_ptr<LogRing> ring;
+    std::vector<std::byte> scratch;
+    ~ThreadLog();
+  };
+  ThreadLog &threadLog();
+
+  template <typename T> static void encode(std::vector<std::byte> &to,
+                                           const T &arg);
+  static void append(std::vector<std::byte> &to, const void *from,
+                     size_t size);
+
+  void run();
+  // Takes everything out of the rings and writes it, false if there was
+  // nothing
+  bool drainAll();
+  void write(const LogRing &ring, const RecordHeader &header,
+             const std::byte *args);
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::vector<std::shared_ptr<LogRing>> m_rings;
+  std::vector<std::string> m_tags;
+  uint32_t m_threadCount = 0;
+  std::thread m_writer;
+  bool m_running = false;
+  bool m_stopping = false;
+  std::unique_ptr<std::ostream> m_file;
+  std::ostream *m_out = nullptr;
+  std::chrono::steady_clock::time_point m_epoch;
+  // Only touched by the writer, m_writerTags is copied from m_tags when a
+  // record has a tag it doesn't have yet
+  std::vector<std::string> m_writerTags;
+  std::vector<std::byte> m_record;
+  std::string m_line;
+};
+
+template <typename F>
+size_t LogRing::drain(F &&f, std::vector<std::byte> &buffer) {
+  uint64_t tail = m_tail.load(std::memory_order_relaxed);
+  uint64_t head = m_head.load(std::memory_order_acquire);
+  size_t count = 0;
+
+  while (tail != head) {
+    RecordHeader header;
+    copyOut(tail, reinterpret_cast<std::byte *>(&header), sizeof(header));
+    buffer.resize(header.size - sizeof(header));
+    copyOut(tail + sizeof(header), buffer.data(), buffer.size());
+    f(header, buffer.data());
+    tail += header.size;
+    count++;
+  }
+
+  m_tail.store(tail, std::memory_order_release);
+  return count;
+}
+
+template <typename... Args>
+void LogBackend::push(uint16_t tag, char level, const char *format,
+                      const Args &...args) {
+  static_assert(sizeof...(Args) < 256, "Too many log arguments");
+
+  ThreadLog &log = threadLog();
+  std::vector<std::byte> &record = log.scratch;
+  record.resize(sizeof(RecordHeader));
+  (encode(record, args), ...);
+
+  RecordHeader header;
+  header.size = static_cast<uint32_t>(record.size());
+  header.tag = tag;
+  header.level = level;
+  header.args = static_cast<uint8_t>(sizeof...(Args));
+  header.nanos = static_cast<uint64_t>(
+      (std::chrono::steady_clock::now() - m_epoch).count());
+  header.format = format;
+  std::memcpy(record.data(), &header, sizeof(header));
+
+  log.ring->tryPush(record.data(), record.size());
+}
+
+template <typename T>
+void LogBackend::encode(std::vector<std::byte> &to, const T &arg) {
+  auto put = [&](ArgType type, const auto &value) {
+    append(to, &type, 1);
+    append(to, &value, sizeof(value));
+  };
+
+  if constexpr (std::is_same_v<T, bool>) {
+    put(ArgType::Bool, uint8_t(arg));
+  } else if constexpr (std::is_same_v<T, char>) {
+    put(ArgType::Char, arg);
+  } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+    if constexpr (std::is_signed_v<T>) {
+      put(ArgType::Int, int64_t(arg));
+    } else {
+      put(ArgType::Uint, uint64_t(arg));
+    }
+  } else if constexpr (std::is_floating_point_v<T>) {
+    put(ArgType::Float, double(arg));
+  } else if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+    std::string_view text;
+    if constexpr (std::is_pointer_v<T>) {
+      text = arg ? std::string_view(arg) : std::string_view("(null)");
+    } else {
+      text = arg;
+    }
+    put(ArgType::String, uint32_t(text.size()));
+    append(to, text.data(), text.size());
+  } else if constexpr (std::is_pointer_v<T>) {
+    put(ArgType::Pointer, reinterpret_cast<uintptr_t>(arg));
+  } else {
+    static_assert(!sizeof(T), "Can't log this type");
+  }
+}
+
+} // namespace detail
+
 // class selects from one of two explicit template instantiations of an
-// implementation for each public method used for generating a log event I...
-// think this is all compile time and therefore when a stub is selected it can
-// be excluded from the binary by optimization
+// implementation for each public method used for generating a log event. A
+// level that is turned off is an empty function and its calls compile away,
+// arguments and all
 
 template <bool enD, bool enI, bool enW, bool enE> class Logger {
 public:
-  Logger(const std::string &tag) { m_tag = tag; }
+  // Throws std::length_error if there are already k_maxTags different tags
+  // in detail::LogBackend
+  Logger(const std::string &tag)
+      : m_tag(tag), m_tagId(detail::LogBackend::instance().addTag(tag)) {}
   ~Logger() = default;
 
   Logger(const Logger &) = delete;
   const Logger &operator=(const Logger &) = delete;
 
-  bool Start() {
-
-    std::cout << "testing logging STARTED" << '\n';
-    // TODO: launch a new process that writes logs to shell/file
-    return true;
+  // Starts the writer thread shared by all loggers, on stdout or a file.
+  // Anything logged before it started is written once it does, as long as it
+  // fit in the rings. False if the file can't be opened.
+  bool Start() { return detail::LogBackend::instance().start(std::cout); }
+  bool Start(const std::string &path) {
+    return detail::LogBackend::instance().start(path);
   }
+  // Writes out everything logged so far and stops the writer
+  void Stop() { detail::LogBackend::instance().stop(); }
 
-  void logd() { 
-    if (!enD) return;
-    std::cout << "testing logging d" << '\n';
+  template <typename... Args>
+  void logd(const char *format, const Args &...args) {
+    if constexpr (enD) {
+      detail::LogBackend::instance().push(m_tagId, 'D', format, args...);
+    }
   }
 
-  void logi() { 
-    if (!enI) return;
-    std::cout << "testing logging i" << '\n';
+  template <typename... Args>
+  void logi(const char *format, const Args &...args) {
+    if constexpr (enI) {
+      detail::LogBackend::instance().push(m_tagId, 'I', format, args...);
+    }
   }
 
-  void logw() { 
-    if (!enW) return;
-    std::cout << "testing logging w" << '\n'; 
+  template <typename... Args>
+  void logw(const char *format, const Args &...args) {
+    if constexpr (enW) {
+      detail::LogBackend::instance().push(m_tagId, 'W', format, args...);
+    }
   }
 
-  void loge() { 
-    if (!enE) return;
-    std::cout << "testing logging e" << '\n';
+  template <typename... Args>
+  void loge(const char *format, const Args &...args) {
+    if constexpr (enE) {
+      detail::LogBackend::instance().push(m_tagId, 'E', format, args...);
+    }
   }
 
+  const std::string &tag() const { return m_tag; }
+
 private:
   std::string m_tag;
+  uint16_t m_tagId;
 };
 
 } // namespace funni
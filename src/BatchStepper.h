@@ -0,0 +1,137 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "simd/BatchKernel.h"
+#include "simd/CpuFeatures.h"
+
+/**
+ * Runs processNextState() for a whole list of chunks, packing them into vector
+ * lanes when the CPU supports it.
+ *
+ * The chunks have to have their border read in already. Chunks are gathered
+ * k_batchSize at a time into structure of arrays buffers, stepped together by
+ * the BatchKernel for the chosen SimdLevel and then scattered back. With
+ * SimdLevel::SCALAR every chunk just steps itself.
+ */
+template <typename ChunkT> class BatchStepper {
+public:
+  using RowType = typename ChunkT::RowType;
+
+  // One AVX-512 register worth of chunks. Has to be a multiple of the lanes
+  // of the widest vector, and any bigger and the buffers for the big chunks
+  // don't fit in L1 anymore
+  static constexpr int32_t k_batchSize =
+      BatchKernel::k_avx512Bytes / sizeof(RowType);
+
+  BatchStepper() { setSimdLevel(detectSimdLevel()); }
+
+  /**
+   * Pick the instruction set to use. Anything the CPU can't run is lowered to
+   * the best one it can. Chunks with more than two states always step
+   * themselves, the kernels only have the live cells.
+   */
+  void setSimdLevel(SimdLevel level) {
+    m_level = ChunkT::k_maxStates > 2 ? SimdLevel::SCALAR
+                                      : std::min(level, detectSimdLevel());
+
+    switch (m_level) {
+    case SimdLevel::AVX512:
+      m_kernel = &BatchKernel::stepAvx512<RowType>;
+      break;
+    case SimdLevel::AVX2:
+      m_kernel = &BatchKernel::stepAvx2<RowType>;
+      break;
+    default:
+      m_kernel = nullptr;
+      break;
+    }
+  }
+
+  SimdLevel getSimdLevel() const { return m_level; }
+
+  void step(ChunkT *const *chunks, size_t count, const Rule &rule) {
+    if (!m_kernel) {
+      for (size_t i = 0; i < count; i++) {
+        chunks[i]->processNextState(rule);
+      }
+      return;
+    }
+
+    // Empty chunks that nothing can be born in are left out of the batches,
+    // around the edge of a pattern that is most of them
+    m_batch.clear();
+    for (size_t i = 0; i < count; i++) {
+      if (chunks[i]->staysEmpty(rule)) {
+        chunks[i]->processStaysEmpty();
+      } else {
+        m_batch.push_back(chunks[i]);
+      }
+    }
+
+    BatchKernel::Rows<RowType> rows{
+        m_in.data(),
+        ChunkT::k_separateHalo ? m_haloWest.data() : nullptr,
+        ChunkT::k_separateHalo ? m_haloEast.data() : nullptr,
+        m_out.data(),
+        ChunkT::k_size,
+        k_batchSize,
+        ChunkT::k_dataBits,
+        rule};
+
+    // Lanes past the end of a short batch get stepped too, whatever is left
+    // in them from the last batch is just never scattered back
+    for (size_t first = 0; first < m_batch.size(); first += k_batchSize) {
+      size_t batch = std::min<size_t>(k_batchSize, m_batch.size() - first);
+      gather(m_batch.data() + first, batch);
+      m_kernel(rows);
+      scatter(m_batch.data() + first, batch);
+    }
+  }
+
+private:
+  static constexpr int32_t k_rows = ChunkT::k_size + 2;
+
+  SimdLevel m_level = SimdLevel::SCALAR;
+  void (*m_kernel)(const BatchKernel::Rows<RowType> &) = nullptr;
+
+  std::vector<ChunkT *> m_batch;
+  std::vector<RowType> m_in = std::vector<RowType>(k_rows * k_batchSize);
+  std::vector<RowType> m_haloWest =
+      std::vector<RowType>(ChunkT::k_separateHalo ? k_rows * k_batchSize : 0);
+  std::vector<RowType> m_haloEast =
+      std::vector<RowType>(ChunkT::k_separateHalo ? k_rows * k_batchSize : 0);
+  std::vector<RowType> m_out =
+      std::vector<RowType>(ChunkT::k_size * k_batchSize);
+
+  void gather(ChunkT *const *chunks, size_t count) {
+    for (size_t l = 0; l < count; l++) {
+      const ChunkT &c = *chunks[l];
+      for (int32_t r = 0; r < k_rows; r++) {
+        m_in[r * k_batchSize + l] = c.m_data[r];
+      }
+
+      if constexpr (ChunkT::k_separateHalo) {
+        for (int32_t r = 0; r < k_rows; r++) {
+          RowType halo = c.m_halo[r];
+          m_haloWest[r * k_batchSize + l] = (halo >> 1)
+                                            << (ChunkT::k_rowBits - 1);
+          m_haloEast[r * k_batchSize + l] = halo & ChunkT::k_haloRight;
+        }
+      }
+    }
+  }
+
+  void scatter(ChunkT *const *chunks, size_t count) {
+    for (size_t l = 0; l < count; l++) {
+      ChunkT &c = *chunks[l];
+      typename ChunkT::RowChanges changes;
+      for (int32_t y = 1; y <= ChunkT::k_size; y++) {
+        c.writeRow(y, m_out[(y - 1) * k_batchSize + l], changes);
+      }
+      c.processEmpty();
+      c.processChanged(changes);
+    }
+  }
+};
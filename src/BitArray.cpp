@@ -1,46 +1,49 @@
 #include "BitArray.h"
+#include <algorithm>
+#include <bit>
 #include <iostream>
 #include <stdexcept>
 #include <stdlib.h>
 
-BitArray::BitArray(uint32_t bits) {
-  m_bits = bits;
-  int bytes = bits / 8;
-  if (bits % 8 > 0) {
-    bytes++;
-  }
-  m_byteSize = bytes;
-
-  m_bytes = std::make_unique<uint8_t[]>(bytes);
-}
+BitArray::BitArray(size_t bits) : m_words(wordsFor(bits), 0), m_bits(bits) {}
 
-bool BitArray::get(uint32_t index) const {
+bool BitArray::get(size_t index) const {
   checkIndex(index);
 
-  return (m_bytes[index / 8] >> (7 - (index % 8))) & 0b1;
+  return test(index);
 }
 
-void BitArray::set(uint32_t index, bool value) {
+void BitArray::set(size_t index, bool value) {
   checkIndex(index);
 
-  if (value) {
-    m_bytes[index / 8] |= 1 << (7 - (index % 8));
-  } else {
-    m_bytes[index / 8] &= ~(1 << (7 - (index % 8)));
+  assign(index, value);
+}
+
+void BitArray::fill(bool value) {
+  std::fill(m_words.begin(), m_words.end(), value ? ~uint64_t(0) : 0);
+  // Keep the bits past the end at 0
+  if (value && m_bits % 64 != 0) {
+    m_words.back() = (uint64_t(1) << (m_bits % 64)) - 1;
   }
 }
 
-uint32_t BitArray::size() const { return m_bits; }
+size_t BitArray::count() const {
+  size_t total = 0;
+  for (uint64_t word : m_words) {
+    total += std::popcount(word);
+  }
+  return total;
+}
 
-void BitArray::checkIndex(uint32_t index) const {
-  if (index < 0 || index > m_bits - 1) {
+void BitArray::checkIndex(size_t index) const {
+  if (index >= m_bits) {
     throw std::invalid_argument("Index is out of range.");
   }
 }
 
 std::ostream &operator<<(std::ostream &os, BitArray const &m) {
   os << "0b";
-  for (uint32_t i = 0; i < m.size(); i++) {
+  for (size_t i = 0; i < m.size(); i++) {
     os << m.get(i);
   }
   return os;
@@ -1,23 +1,63 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
-#include <memory>
-#include <stdbool.h>
-#include <stdint.h>
+#include <vector>
 
+/**
+ * A fixed number of bits packed into 64 bit words, bit i being bit i % 64 of
+ * word i / 64 the same as the rows of a LifeEngine region bitmap. Bits past
+ * the end in the last word are always 0.
+ *
+ * get() and set() check the index, test() and assign() don't and are meant
+ * for loops that already know it is in range. Whole words can be worked on
+ * through data(), as long as the bits past the end are left at 0.
+ */
 class BitArray {
 public:
   BitArray() = delete;
-  explicit BitArray(uint32_t bits);
+  explicit BitArray(size_t bits);
   ~BitArray() = default;
-  bool get(uint32_t index) const;
-  void set(uint32_t index, bool value);
-  uint32_t size() const;
+  BitArray(const BitArray &) = default;
+  BitArray(BitArray &&) = default;
+  BitArray &operator=(const BitArray &) = default;
+  BitArray &operator=(BitArray &&) = default;
+
+  /**
+   * These throw std::invalid_argument if index is past the end
+   */
+  bool get(size_t index) const;
+  void set(size_t index, bool value);
+
+  bool test(size_t index) const {
+    return m_words[index / 64] >> (index % 64) & 1;
+  }
+  void assign(size_t index, bool value) {
+    uint64_t bit = uint64_t(1) << (index % 64);
+    m_words[index / 64] =
+        value ? m_words[index / 64] | bit : m_words[index / 64] & ~bit;
+  }
+
+  /**
+   * Sets or clears every bit
+   */
+  void fill(bool value);
+  /**
+   * Number of bits that are set
+   */
+  size_t count() const;
+
+  size_t size() const { return m_bits; }
+  size_t wordCount() const { return m_words.size(); }
+  uint64_t *data() { return m_words.data(); }
+  const uint64_t *data() const { return m_words.data(); }
+
+  static constexpr size_t wordsFor(size_t bits) { return (bits + 63) / 64; }
 
 private:
-  std::unique_ptr<uint8_t[]> m_bytes;
-  uint32_t m_byteSize;
-  uint32_t m_bits;
-  void checkIndex(uint32_t index) const;
+  std::vector<uint64_t> m_words;
+  size_t m_bits;
+  void checkIndex(size_t index) const;
 };
 
 std::ostream &operator<<(std::ostream &os, BitArray const &m);
@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "CellRenderer.h"
+
+namespace {
+
+int32_t clampCell(double v) {
+  return static_cast<int32_t>(
+      std::clamp<double>(v, std::numeric_limits<int32_t>::min(),
+                         std::numeric_limits<int32_t>::max()));
+}
+
+/**
+ * Chunk a cell is in, rounding down for negative cells too
+ */
+int32_t chunkOf(int64_t cell, int32_t chunkSize) {
+  return static_cast<int32_t>(cell >= 0 ? cell / chunkSize
+                                        : (cell + 1) / chunkSize - 1);
+}
+
+} // namespace
+
+CellRenderer::Camera::Rect CellRenderer::Camera::visibleCells() const {
+  int32_t left = clampCell(std::floor(x));
+  int32_t bottom = clampCell(std::floor(y));
+  int32_t right = clampCell(std::ceil(x + width / cellPixels));
+  int32_t top = clampCell(std::ceil(y + height / cellPixels));
+  return {left, bottom, right - left, top - bottom};
+}
+
+CellRenderer::CellRenderer()
+    : m_shader("cells.vert", "cells.frag"),
+      m_densityShader("density.vert", "density.frag") {
+  m_cameraCell = m_shader.getUniformLocation("uCameraCell");
+  m_cameraOffset = m_shader.getUniformLocation("uCameraOffset");
+  m_cellScale = m_shader.getUniformLocation("uCellScale");
+  m_chunkSize = m_shader.getUniformLocation("uChunkSize");
+  m_rowWords = m_shader.getUniformLocation("uRowWords");
+  m_color = m_shader.getUniformLocation("uColor");
+
+  // Each instance is the bottom left cell of a chunk and its slot
+  glGenVertexArrays(1, &m_vao);
+  glBindVertexArray(m_vao);
+  glGenBuffers(1, &m_instanceBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+  glVertexAttribIPointer(0, 2, GL_INT, sizeof(Instance),
+                         (void *)offsetof(Instance, x));
+  glEnableVertexAttribArray(0);
+  glVertexAttribDivisor(0, 1);
+  glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Instance),
+                         (void *)offsetof(Instance, slot));
+  glEnableVertexAttribArray(1);
+  glVertexAttribDivisor(1, 1);
+  glBindVertexArray(0);
+
+  glGenTextures(1, &m_rowTexture);
+
+  m_densityRect = m_densityShader.getUniformLocation("uRect");
+  m_densityTiles = m_densityShader.getUniformLocation("uTiles");
+  m_densityColor = m_densityShader.getUniformLocation("uColor");
+  glGenVertexArrays(1, &m_densityVao);
+  glGenTextures(1, &m_densityTexture);
+  glBindTexture(GL_TEXTURE_2D, m_densityTexture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &m_maxTexels);
+
+  glGenBuffers(1, &m_staging);
+  glBindBuffer(GL_COPY_READ_BUFFER, m_staging);
+#if defined(GL_VERSION_4_4)
+  if (GLAD_GL_VERSION_4_4) {
+    GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_COPY_READ_BUFFER, k_sections * k_sectionBytes, nullptr,
+                    flags);
+    m_mapped = static_cast<std::byte *>(glMapBufferRange(
+        GL_COPY_READ_BUFFER, 0, k_sections * k_sectionBytes, flags));
+    if (!m_mapped) {
+      throw std::runtime_error("Couldn't map the cell staging buffer");
+    }
+    m_persistent = true;
+  }
+#endif
+  if (!m_persistent) {
+    glBufferData(GL_COPY_READ_BUFFER, k_sections * k_sectionBytes, nullptr,
+                 GL_STREAM_DRAW);
+  }
+}
+
+CellRenderer::~CellRenderer() {
+  for (GLsync fence : m_fences) {
+    if (fence) {
+      glDeleteSync(fence);
+    }
+  }
+  if (m_persistent) {
+    glBindBuffer(GL_COPY_READ_BUFFER, m_staging);
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+  }
+
+  glDeleteBuffers(1, &m_staging);
+  glDeleteBuffers(1, &m_rowBuffer);
+  glDeleteBuffers(1, &m_instanceBuffer);
+  glDeleteTextures(1, &m_rowTexture);
+  glDeleteTextures(1, &m_densityTexture);
+  glDeleteVertexArrays(1, &m_vao);
+  glDeleteVertexArrays(1, &m_densityVao);
+}
+
+void CellRenderer::setColor(float r, float g, float b, float a) {
+  m_rgba[0] = r;
+  m_rgba[1] = g;
+  m_rgba[2] = b;
+  m_rgba[3] = a;
+}
+
+void CellRenderer::draw(const ChunkFrame &frame, const Camera &camera) {
+  m_stats = {};
+  m_frame++;
+  if (frame.chunkSize != m_frameChunkSize ||
+      frame.rowWords != m_frameRowWords) {
+    resetSlots(frame);
+  }
+  if (frame.chunkSize == 0 || camera.width <= 0 || camera.height <= 0) {
+    evict();
+    return;
+  }
+
+  Camera::Rect view = camera.visibleCells();
+  int32_t minX = chunkOf(view.x, frame.chunkSize);
+  int32_t minY = chunkOf(view.y, frame.chunkSize);
+  int32_t maxX = chunkOf(int64_t(view.x) + view.width, frame.chunkSize);
+  int32_t maxY = chunkOf(int64_t(view.y) + view.height, frame.chunkSize);
+  auto chunkBytes = static_cast<GLsizeiptr>(frame.chunkWords() * 4);
+
+  m_instances.clear();
+  for (size_t i = 0; i < frame.chunks.size(); i++) {
+    auto [key, version] = frame.chunks[i];
+    bool visible =
+        key.x >= minX && key.x <= maxX && key.y >= minY && key.y <= maxY;
+
+    // Chunks off the screen are kept if they are there already but aren't
+    // sent until they come into view
+    uint32_t slot;
+    if (const uint32_t *cached = m_cache.find(key)) {
+      slot = *cached;
+      m_slots[slot].frame = m_frame;
+      if (!visible) {
+        continue;
+      }
+      if (m_slots[slot].version != version) {
+        upload(slot, frame.rowsOf(i), chunkBytes);
+        m_slots[slot].version = version;
+      }
+    } else {
+      if (!visible) {
+        continue;
+      }
+      slot = allocateSlot();
+      if (slot == m_maxSlots) {
+        m_stats.droppedChunks++;
+        continue;
+      }
+      m_cache.insert(key, slot);
+      m_slots[slot] = {version, m_frame, key};
+      upload(slot, frame.rowsOf(i), chunkBytes);
+    }
+
+    m_instances.push_back(
+        {key.x * frame.chunkSize, key.y * frame.chunkSize, slot});
+  }
+  if (m_sectionOpen) {
+    endSection();
+  }
+  evict();
+
+  m_stats.drawnChunks = static_cast<uint32_t>(m_instances.size());
+  if (m_instances.empty()) {
+    return;
+  }
+
+  // Orphaned every frame so the driver never has to wait on the last one
+  auto instanceBytes =
+      static_cast<GLsizeiptr>(m_instances.size() * sizeof(Instance));
+  glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, instanceBytes, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, instanceBytes, m_instances.data());
+  m_stats.instanceBytes = instanceBytes;
+
+  double cellX = std::floor(camera.x);
+  double cellY = std::floor(camera.y);
+  m_shader.use();
+  glUniform2i(m_cameraCell, clampCell(cellX), clampCell(cellY));
+  glUniform2f(m_cameraOffset, static_cast<float>(camera.x - cellX),
+              static_cast<float>(camera.y - cellY));
+  glUniform2f(m_cellScale,
+              static_cast<float>(2 * camera.cellPixels / camera.width),
+              static_cast<float>(2 * camera.cellPixels / camera.height));
+  glUniform1i(m_chunkSize, frame.chunkSize);
+  glUniform1i(m_rowWords, frame.rowWords);
+  glUniform4fv(m_color, 1, m_rgba);
+  glUniform1i(m_shader.getUniformLocation("uRows"), 0);
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_BUFFER, m_rowTexture);
+  glBindVertexArray(m_vao);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4,
+                        static_cast<GLsizei>(m_instances.size()));
+  glBindVertexArray(0);
+}
+
+void CellRenderer::drawDensity(const DensityFrame &frame,
+                               const Camera &camera) {
+  m_stats = {};
+  if (frame.counts.empty() || camera.width <= 0 || camera.height <= 0) {
+    return;
+  }
+
+  // A texel per tile, as many as there are pixels or fewer
+  m_densities.resize(frame.counts.size());
+  for (size_t i = 0; i < frame.counts.size(); i++) {
+    m_densities[i] = static_cast<float>(frame.getDensity(i));
+  }
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, m_densityTexture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  if (frame.width != m_densityWidth || frame.height != m_densityHeight) {
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, frame.width, frame.height, 0,
+                 GL_RED, GL_FLOAT, m_densities.data());
+    m_densityWidth = frame.width;
+    m_densityHeight = frame.height;
+  } else {
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, frame.width, frame.height, GL_RED,
+                    GL_FLOAT, m_densities.data());
+  }
+  m_stats.uploadBytes = m_densities.size() * sizeof(float);
+
+  auto toScreen = [](double cell, double from, double pixels, double size) {
+    return static_cast<float>((cell - from) * pixels / size * 2 - 1);
+  };
+  double left = double(frame.x) * frame.tileCells;
+  double bottom = double(frame.y) * frame.tileCells;
+  m_densityShader.use();
+  glUniform4f(
+      m_densityRect,
+      toScreen(left, camera.x, camera.cellPixels, camera.width),
+      toScreen(bottom, camera.y, camera.cellPixels, camera.height),
+      toScreen(left + double(frame.width) * frame.tileCells, camera.x,
+               camera.cellPixels, camera.width),
+      toScreen(bottom + double(frame.height) * frame.tileCells, camera.y,
+               camera.cellPixels, camera.height));
+  glUniform2i(m_densityTiles, frame.width, frame.height);
+  glUniform4fv(m_densityColor, 1, m_rgba);
+  glUniform1i(m_densityShader.getUniformLocation("uDensity"), 0);
+
+  // There are no attributes, the VAO is only there because core needs one
+  glBindVertexArray(m_densityVao);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glBindVertexArray(0);
+}
+
+void CellRenderer::resetSlots(const ChunkFrame &frame) {
+  m_frameChunkSize = frame.chunkSize;
+  m_frameRowWords = frame.rowWords;
+  m_cache.clear();
+  m_slots.clear();
+  m_freeSlots.clear();
+
+  glDeleteBuffers(1, &m_rowBuffer);
+  m_rowBuffer = 0;
+  m_slotCapacity = 0;
+  size_t slotWords = std::max<size_t>(frame.chunkWords(), 1);
+  m_maxSlots = static_cast<uint32_t>(m_maxTexels / slotWords);
+}
+
+uint32_t CellRenderer::allocateSlot() {
+  if (!m_freeSlots.empty()) {
+    uint32_t slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    return slot;
+  }
+
+  if (m_slots.size() == m_slotCapacity) {
+    if (m_slotCapacity == m_maxSlots) {
+      return m_maxSlots;
+    }
+    growSlots(std::min(std::max(64u, m_slotCapacity * 2), m_maxSlots));
+  }
+  m_slots.emplace_back();
+  return static_cast<uint32_t>(m_slots.size() - 1);
+}
+
+void CellRenderer::growSlots(uint32_t capacity) {
+  GLsizeiptr slotBytes = m_frameChunkSize * m_frameRowWords * 4;
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+  glBufferData(GL_COPY_WRITE_BUFFER, capacity * slotBytes, nullptr,
+               GL_STATIC_DRAW);
+
+  // Copies still waiting in the staging buffer go to the new one
+  if (m_rowBuffer) {
+    glBindBuffer(GL_COPY_READ_BUFFER, m_rowBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                        m_slotCapacity * slotBytes);
+    glDeleteBuffers(1, &m_rowBuffer);
+  }
+  m_rowBuffer = buffer;
+  m_slotCapacity = capacity;
+
+  glBindTexture(GL_TEXTURE_BUFFER, m_rowTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_rowBuffer);
+}
+
+void CellRenderer::evict() {
+  for (uint32_t slot = 0; slot < m_slots.size(); slot++) {
+    Slot &s = m_slots[slot];
+    if (s.frame != 0 && s.frame != m_frame) {
+      m_cache.erase(s.key);
+      s.frame = 0;
+      m_freeSlots.push_back(slot);
+    }
+  }
+}
+
+void CellRenderer::upload(uint32_t slot, const uint32_t *rows,
+                          GLsizeiptr bytes) {
+  if (!m_sectionOpen || m_sectionUsed + bytes > k_sectionBytes) {
+    if (m_sectionOpen) {
+      endSection();
+    }
+    beginSection();
+  }
+
+  std::memcpy(m_sectionData + m_sectionUsed, rows, bytes);
+  GLintptr from = m_section * k_sectionBytes + m_sectionUsed;
+  GLintptr to = slot * bytes;
+  m_sectionUsed += bytes;
+
+  // Chunks going into slots next to each other go over in one copy
+  Copy *last = m_copies.empty() ? nullptr : &m_copies.back();
+  if (last && last->from + last->bytes == from &&
+      last->to + last->bytes == to) {
+    last->bytes += bytes;
+  } else {
+    m_copies.push_back({from, to, bytes});
+  }
+
+  m_stats.uploadBytes += bytes;
+  m_stats.uploadedChunks++;
+}
+
+void CellRenderer::beginSection() {
+  m_section = (m_section + 1) % k_sections;
+  if (GLsync fence = m_fences[m_section]) {
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) ==
+           GL_TIMEOUT_EXPIRED) {
+    }
+    glDeleteSync(fence);
+    m_fences[m_section] = nullptr;
+  }
+
+  GLintptr offset = m_section * k_sectionBytes;
+  if (m_persistent) {
+    m_sectionData = m_mapped + offset;
+  } else {
+    // The fence already says the GPU is done with it
+    glBindBuffer(GL_COPY_READ_BUFFER, m_staging);
+    m_sectionData = static_cast<std::byte *>(glMapBufferRange(
+        GL_COPY_READ_BUFFER, offset, k_sectionBytes,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+            GL_MAP_UNSYNCHRONIZED_BIT));
+    if (!m_sectionData) {
+      throw std::runtime_error("Couldn't map the cell staging buffer");
+    }
+  }
+  m_sectionUsed = 0;
+  m_sectionOpen = true;
+}
+
+void CellRenderer::endSection() {
+  glBindBuffer(GL_COPY_READ_BUFFER, m_staging);
+  if (!m_persistent) {
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+  }
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, m_rowBuffer);
+  for (const Copy &copy : m_copies) {
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, copy.from,
+                        copy.to, copy.bytes);
+  }
+  m_copies.clear();
+
+  m_fences[m_section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  m_sectionOpen = false;
+}
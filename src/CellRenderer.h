@@ -0,0 +1,174 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ChunkFrame.h"
+#include "ChunkMap.h"
+#include "DensityFrame.h"
+#include "Shader.h"
+
+/**
+ * Draws the cells of a ChunkFrame straight from the chunk rows, one instanced
+ * quad per chunk with the fragment shader picking the bits out.
+ *
+ * The rows of every chunk that was drawn stay on the GPU in a slot of a
+ * texture buffer, only chunks that are new or came with a different version
+ * get sent again. Those go through a staging buffer split into sections that
+ * are each fenced, so filling one never waits on the GPU still copying out of
+ * another. With GL 4.4 the staging buffer is mapped once and stays mapped,
+ * otherwise each section is mapped while it is being filled.
+ *
+ * Zoomed out far enough that chunks are only a few pixels it can draw a
+ * DensityFrame instead, which costs about the same for any number of chunks.
+ *
+ * Needs a current GL 3.3 context for as long as it is around.
+ */
+class CellRenderer {
+public:
+  /**
+   * What part of the board ends up on the screen
+   */
+  struct Camera {
+    // Board position at the bottom left corner of the screen
+    double x = 0;
+    double y = 0;
+    double cellPixels = 1;
+    // Size of the screen in pixels
+    int32_t width = 0;
+    int32_t height = 0;
+
+    struct Rect {
+      int32_t x, y, width, height;
+    };
+    /**
+     * Every cell that is at least partly on the screen
+     */
+    Rect visibleCells() const;
+  };
+
+  /**
+   * What the last draw() did
+   */
+  struct Stats {
+    // Bytes of rows (or tiles) and of instances sent to the GPU
+    uint64_t uploadBytes = 0;
+    uint64_t instanceBytes = 0;
+    uint32_t uploadedChunks = 0;
+    uint32_t drawnChunks = 0;
+    // Chunks the texture buffer had no more room for
+    uint32_t droppedChunks = 0;
+  };
+
+  CellRenderer();
+  ~CellRenderer();
+
+  CellRenderer(const CellRenderer &) = delete;
+  const CellRenderer &operator=(const CellRenderer &) = delete;
+
+  /**
+   * Draws the live cells of the frame that the camera can see into the
+   * framebuffer that is bound, without clearing it
+   */
+  void draw(const ChunkFrame &frame, const Camera &camera);
+  /**
+   * Same for a DensityFrame, every tile with something alive in it is drawn
+   * brighter the more of it is alive
+   */
+  void drawDensity(const DensityFrame &frame, const Camera &camera);
+
+  void setColor(float r, float g, float b, float a);
+  const Stats &getStats() const { return m_stats; }
+
+private:
+  static constexpr uint32_t k_sections = 3;
+  static constexpr GLsizeiptr k_sectionBytes = 1 << 20;
+
+  struct Slot {
+    uint64_t version = 0;
+    // Last frame the chunk was in, 0 for a free slot
+    uint64_t frame = 0;
+    ChunkKey key{0, 0};
+  };
+  struct Instance {
+    int32_t x, y;
+    uint32_t slot;
+  };
+  struct Copy {
+    GLintptr from, to;
+    GLsizeiptr bytes;
+  };
+
+  Shader m_shader;
+  GLint m_cameraCell, m_cameraOffset, m_cellScale, m_chunkSize, m_rowWords,
+      m_color;
+  float m_rgba[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+  GLuint m_vao = 0;
+
+  Shader m_densityShader;
+  GLint m_densityRect, m_densityTiles, m_densityColor;
+  GLuint m_densityVao = 0;
+  GLuint m_densityTexture = 0;
+  int32_t m_densityWidth = 0;
+  int32_t m_densityHeight = 0;
+  std::vector<float> m_densities;
+  GLuint m_instanceBuffer = 0;
+  std::vector<Instance> m_instances;
+
+  // Chunk rows on the GPU, slot i starting at word i * chunk words
+  GLuint m_rowBuffer = 0;
+  GLuint m_rowTexture = 0;
+  uint32_t m_slotCapacity = 0;
+  uint32_t m_maxSlots = 0;
+  GLint m_maxTexels = 0;
+  int32_t m_frameChunkSize = 0;
+  int32_t m_frameRowWords = 0;
+  ChunkMap<uint32_t> m_cache;
+  std::vector<Slot> m_slots;
+  std::vector<uint32_t> m_freeSlots;
+  uint64_t m_frame = 0;
+
+  GLuint m_staging = 0;
+  bool m_persistent = false;
+  // The whole staging buffer when it is mapped the whole time
+  std::byte *m_mapped = nullptr;
+  GLsync m_fences[k_sections] = {};
+  uint32_t m_section = 0;
+  bool m_sectionOpen = false;
+  std::byte *m_sectionData = nullptr;
+  GLsizeiptr m_sectionUsed = 0;
+  std::vector<Copy> m_copies;
+
+  Stats m_stats;
+
+  /**
+   * Drops every cached chunk and sizes the slots for chunks like frame's
+   */
+  void resetSlots(const ChunkFrame &frame);
+  /**
+   * Slot to put a chunk in, growing the texture buffer if there is no free
+   * one. Gives back m_maxSlots if it can't grow any more.
+   */
+  uint32_t allocateSlot();
+  void growSlots(uint32_t capacity);
+  /**
+   * Frees the slots of chunks that weren't in the last frame
+   */
+  void evict();
+
+  /**
+   * Copies rows into the staging buffer and queues their copy into slot
+   */
+  void upload(uint32_t slot, const uint32_t *rows, GLsizeiptr bytes);
+  /**
+   * Waits until the GPU is done with the next section and starts filling it
+   */
+  void beginSection();
+  /**
+   * Sends the copies out of the section being filled and fences it
+   */
+  void endSection();
+};
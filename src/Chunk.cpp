@@ -1,80 +1,165 @@
-﻿#include "Chunk.h"
-
-constexpr std::array<bool, 512> createBitsToStateMap() {
-  std::array<bool, 512> map;
-  for (int16_t i = 0; i <= 0b111111111; i++) {
-    uint8_t neighbor_count = 0;
-    int16_t neighbors = i & 0b111101111;
-    bool alive = i & 0b000010000;
-    while (neighbors > 0) {
-      if (neighbors & 0b1) {
-        neighbor_count++;
-      }
+﻿#include <bit>
 
-      neighbors >>= 1;
-    }
+#include "Chunk.h"
+#include "LifeKernel.h"
+#include "utils/Relaxed.h"
 
-    map[i] = neighbor_count == 3 || (neighbor_count == 2 && alive);
-  }
-  return map;
+template <typename RowT, int32_t Size>
+bool BasicChunk<RowT, Size>::getCell(int32_t x, int32_t y) {
+  return m_data[y + 1] & cellBit(x);
 }
 
-static const std::array<bool, 512> bitsToState = createBitsToStateMap();
-
-// I apoligize for this name bit it stands for three consecutive bits in a byte
-// map Which takes in a byte and tells you if there are 3 consecutive bits in
-// that byte pretty self explanatory ¯\_(ツ)_/¯
-const std::array<bool, 256> tcbibm =
-    getThreeConsecutiveBitCheckTable<unsigned char>();
+template <typename RowT, int32_t Size>
+void BasicChunk<RowT, Size>::setCell(int32_t x, int32_t y, bool val) {
+  RowType loc = cellBit(x);
+  if (val) {
+    // When the user sets a cell in a chunk assume that the chunk is no longer
+    // empty and that there are missing border chunks to simplify intial start
+    m_flags &= ~Flags::EMPTY;
+    m_flags |= Flags::MISSING_BORDER_CHUNK;
 
-constexpr std::array<bool, 32> createCornerMap() {
-  std::array<bool, 32> map{};
+    m_data[y + 1] |= loc;
+  } else {
+    m_data[y + 1] &= ~loc;
+  }
 
-  for (int16_t i = 0; i <= 0b11111; i++) {
-    int16_t current = i;
-    int8_t count = 0;
-    while (current > 0) {
-      if (current & 0b1) {
-        count++;
-      }
+  markEdited();
+}
 
-      current >>= 1;
-    }
+template <typename RowT, int32_t Size>
+void BasicChunk<RowT, Size>::setRow(int32_t y, RowType bits, bool val) {
+  bits &= k_dataBits;
+  if (val) {
+    m_flags &= ~Flags::EMPTY;
+    m_flags |= Flags::MISSING_BORDER_CHUNK;
 
-    map[i] = count >= 3;
+    m_data[y + 1] |= bits;
+  } else {
+    m_data[y + 1] &= ~bits;
   }
 
-  return map;
+  markEdited();
 }
 
-// Map of byte to the number of bits in it
-static const std::array<bool, 32> cornerMap = createCornerMap();
+template <typename RowT, int32_t Size>
+bool BasicChunk<RowT, Size>::replaceRow(int32_t y, RowType mask,
+                                        RowType bits) {
+  mask &= k_dataBits;
+  bits &= mask;
+  if ((m_data[y + 1] & mask) == bits) {
+    return false;
+  }
+
+  if (bits) {
+    m_flags &= ~Flags::EMPTY;
+    m_flags |= Flags::MISSING_BORDER_CHUNK;
+  }
+  m_data[y + 1] = (m_data[y + 1] & ~mask) | bits;
 
-bool Chunk::getCell(int32_t x, int32_t y) {
-  uint64_t mask = 1ul << (k_size - x);
-  return m_data[y + 1] & mask;
+  markEdited();
+  return true;
 }
 
-void Chunk::setCell(int32_t x, int32_t y, bool val) {
-  uint64_t loc = 1ul << (k_size - x);
-  if (val) {
-    // When the user sets a cell in a chunk assume that the chunk is no longer
-    // empty and that there are missing border chunks to simplify intial start
+template <typename RowT, int32_t Size>
+void BasicChunk<RowT, Size>::loadRows(const RowType *rows) {
+  RowType any = 0;
+  for (int32_t y = 0; y < k_size; y++) {
+    m_data[y + 1] = rows[y] & k_dataBits;
+    any |= m_data[y + 1];
+  }
+
+  if (any) {
     m_flags &= ~Flags::EMPTY;
     m_flags |= Flags::MISSING_BORDER_CHUNK;
+  }
 
-    m_data[y + 1] |= loc;
+  markEdited();
+}
+
+template <typename RowT, int32_t Size>
+bool BasicChunk<RowT, Size>::getWithBorder(int32_t x, int32_t y) {
+  if (x >= 0 && x < k_size) {
+    return m_data[y + 1] & cellBit(x);
+  }
+
+  if constexpr (k_separateHalo) {
+    return m_halo[y + 1] & (x < 0 ? k_haloLeft : k_haloRight);
   } else {
-    m_data[y + 1] &= ~loc;
+    return m_data[y + 1] & (x < 0 ? k_leftBorderBit : k_rightBorderBit);
   }
 }
 
-void Chunk::readInBorder() {
-  for (int i = 1; i <= k_size; i++) {
-    m_data[i] &= k_dataBits;
+template <typename RowT, int32_t Size>
+RowT BasicChunk<RowT, Size>::westOf(int32_t i) const {
+  if constexpr (k_separateHalo) {
+    return (m_data[i] >> 1) | (RowType(m_halo[i] >> 1) << (k_rowBits - 1));
+  } else {
+    return m_data[i] >> 1;
+  }
+}
+
+template <typename RowT, int32_t Size>
+RowT BasicChunk<RowT, Size>::eastOf(int32_t i) const {
+  if constexpr (k_separateHalo) {
+    return RowType(m_data[i] << 1) | (m_halo[i] & k_haloRight);
+  } else {
+    return RowType(m_data[i] << 1);
+  }
+}
+
+template <typename RowT, int32_t Size>
+RowT BasicChunk<RowT, Size>::leftBorderFrom(RowType row) {
+  // The last cell of the chunk to the left
+  if constexpr (k_separateHalo) {
+    return (row & 1) << 1;
+  } else {
+    return RowType(row << k_size) & k_leftBorderBit;
   }
+}
+
+template <typename RowT, int32_t Size>
+RowT BasicChunk<RowT, Size>::rightBorderFrom(RowType row) {
+  // The first cell of the chunk to the right
+  if constexpr (k_separateHalo) {
+    return row >> (k_rowBits - 1);
+  } else {
+    return (row >> k_size) & k_rightBorderBit;
+  }
+}
+
+template <typename RowT, int32_t Size>
+void BasicChunk<RowT, Size>::orBorder(int32_t i, RowType bits) {
+  if constexpr (k_separateHalo) {
+    m_halo[i] |= bits;
+  } else {
+    m_data[i] |= bits;
+  }
+}
+
+template <typename RowT, int32_t Size>
+void BasicChunk<RowT, Size>::readInBorder(const BasicChunk *chunks) {
+  std::array<const BasicChunk *, Neighbour::COUNT> n{};
+  for (uint32_t i = 0; i < Neighbour::COUNT; i++) {
+    if (neighbours[i] != k_noChunk) {
+      n[i] = &chunks[neighbours[i]];
+    }
+  }
+  readBorderFrom(n);
+}
+
+template <typename RowT, int32_t Size>
+void BasicChunk<RowT, Size>::readBorderFrom(
+    const std::array<const BasicChunk *, Neighbour::COUNT> &n) {
+  // The surrounding chunks can be reading their own borders out of this one
+  // at the same time in a parallel update. They only ever look at the data
+  // rows and the flags, so those are read from them and written here with
+  // relaxed atomics. The top and bottom border rows and the halo are only
+  // touched by this chunk.
   m_data[k_topBorder] = 0;
   m_data[k_bottomBorder] = 0;
+  if constexpr (k_separateHalo) {
+    m_halo.fill(0);
+  }
   // This will be added to each time and if there are not 8 then there is a
   // missing border chunk
   int32_t borderingChunks = 0;
@@ -82,158 +167,337 @@ void Chunk::readInBorder() {
   // this will be false
   Flags allBordersEmpty = Flags::EMPTY;
 
-  if (up) {
-    m_data[k_topBorder] |= up->m_data[1] & k_dataBits;
-    allBordersEmpty &= up->m_flags;
-    borderingChunks++;
+  for (uint32_t i = 0; i < Neighbour::COUNT; i++) {
+    if (n[i]) {
+      allBordersEmpty &= relaxedLoad(n[i]->m_flags);
+      borderingChunks++;
+    }
   }
 
-  if (upLeft) {
-    m_data[k_topBorder] |= (upLeft->m_data[1] << k_size) & k_leftBorderBit;
-    allBordersEmpty &= upLeft->m_flags;
-    borderingChunks++;
+  if (n[Neighbour::UP]) {
+    m_data[k_topBorder] |=
+        relaxedLoad(n[Neighbour::UP]->m_data[1]) & k_dataBits;
   }
 
-  if (upRight) {
-    m_data[k_topBorder] |= (upRight->m_data[1] >> k_size) & k_rightBorderBit;
-    allBordersEmpty &= upRight->m_flags;
-    borderingChunks++;
+  if (n[Neighbour::UP_LEFT]) {
+    orBorder(k_topBorder,
+             leftBorderFrom(relaxedLoad(n[Neighbour::UP_LEFT]->m_data[1])));
   }
 
-  if (down) {
-    m_data[k_bottomBorder] |= down->m_data[k_size] & k_dataBits;
-    allBordersEmpty &= down->m_flags;
-    borderingChunks++;
+  if (n[Neighbour::UP_RIGHT]) {
+    orBorder(k_topBorder,
+             rightBorderFrom(relaxedLoad(n[Neighbour::UP_RIGHT]->m_data[1])));
   }
 
-  if (downLeft) {
+  if (n[Neighbour::DOWN]) {
     m_data[k_bottomBorder] |=
-        (downLeft->m_data[k_size] << k_size) & k_leftBorderBit;
-    allBordersEmpty &= downLeft->m_flags;
-    borderingChunks++;
+        relaxedLoad(n[Neighbour::DOWN]->m_data[k_size]) & k_dataBits;
   }
 
-  if (downRight) {
-    m_data[k_bottomBorder] |=
-        (downRight->m_data[k_size] >> k_size) & k_rightBorderBit;
-    allBordersEmpty &= downRight->m_flags;
-    borderingChunks++;
+  if (n[Neighbour::DOWN_LEFT]) {
+    orBorder(k_bottomBorder, leftBorderFrom(relaxedLoad(
+                                 n[Neighbour::DOWN_LEFT]->m_data[k_size])));
   }
 
-  if (left) {
-    for (int i = 1; i <= k_size; i++) {
-      m_data[i] |= (left->m_data[i] << k_size) & k_leftBorderBit;
-    }
-    allBordersEmpty &= left->m_flags;
-    borderingChunks++;
+  if (n[Neighbour::DOWN_RIGHT]) {
+    orBorder(k_bottomBorder, rightBorderFrom(relaxedLoad(
+                                 n[Neighbour::DOWN_RIGHT]->m_data[k_size])));
   }
 
-  if (right) {
-    for (int i = 1; i <= k_size; i++) {
-      m_data[i] |= (right->m_data[i] >> k_size) & k_rightBorderBit;
+  const BasicChunk *left = n[Neighbour::LEFT];
+  const BasicChunk *right = n[Neighbour::RIGHT];
+
+  // Each row is written once since the neighbours may be reading it
+  for (int i = 1; i <= k_size; i++) {
+    RowType border = 0;
+    if (left) {
+      border |= leftBorderFrom(relaxedLoad(left->m_data[i]));
+    }
+    if (right) {
+      border |= rightBorderFrom(relaxedLoad(right->m_data[i]));
+    }
+
+    if constexpr (k_separateHalo) {
+      m_halo[i] = border;
+    } else {
+      relaxedStore(m_data[i], RowType((m_data[i] & k_dataBits) | border));
     }
-    allBordersEmpty &= right->m_flags;
-    borderingChunks++;
   }
 
+  Flags flags = m_flags;
+
   if (static_cast<uint32_t>(allBordersEmpty)) {
-    m_flags |= Flags::ALL_BORDERS_EMPTY;
+    flags |= Flags::ALL_BORDERS_EMPTY;
   } else {
-    m_flags &= ~Flags::ALL_BORDERS_EMPTY;
+    flags &= ~Flags::ALL_BORDERS_EMPTY;
   }
 
   if (borderingChunks != 8) {
-    m_flags |= Flags::MISSING_BORDER_CHUNK;
+    flags |= Flags::MISSING_BORDER_CHUNK;
   } else {
-    m_flags &= ~Flags::MISSING_BORDER_CHUNK;
+    flags &= ~Flags::MISSING_BORDER_CHUNK;
   }
-}
-
-void Chunk::processNextState() {
-  /*
-  if (m_flags & Flags::EMPTY) {
-    // Logic for if the border will spawn any cells or not
-    RowType top = m_data[k_topBorder];
-    RowType bottom = m_data[k_bottomBorder];
-    RowType left = 0;
-    RowType right = 0;
 
-    for (int i = k_bottomBorder; i <= k_topBorder; i++) {
-      right <<= 1;
-      right |= m_data[i] & k_rightBorderBit;
+  relaxedStore(m_flags, flags);
+}
 
-      left >>= 1;
-      left |= m_data[i] & k_leftBorderBit;
+template <typename RowT, int32_t Size>
+void BasicChunk<RowT, Size>::processNextState(const Rule &rule) {
+  LifeKernel::withRule(rule, [this](auto next) {
+    if (staysEmptyWith(next)) {
+      processStaysEmpty();
+    } else {
+      stepWith(next, [](int32_t, RowType row) { return row; });
     }
+  });
+}
 
-    // The + 2 is for the border and the + 3 is to round up the calculation
-    constexpr int32_t nibbles = ((k_size + 2) + 3) / 4;
+template <typename RowT, int32_t Size>
+template <typename Kernel, typename Finish>
+void BasicChunk<RowT, Size>::stepWith(Kernel next, Finish finish) {
+  RowChanges changes;
 
-    bool br = cornerMap[((right >> (k_size - 1)) | (bottom << 2)) & 0x1F];
-    bool bl = cornerMap[((bottom >> (k_size - 1)) | (left << 2)) & 0x1F];
-    bool tr = cornerMap[((top << 2) | (right >> 1)) & 0x1F];
-    bool tl = cornerMap[(((top >> 2) | (left << 1)) >> (k_size - 3)) & 0x1F];
+  RowType topWest = westOf(k_topBorder);
+  RowType top = m_data[k_topBorder];
+  RowType topEast = eastOf(k_topBorder);
+  RowType currWest = westOf(k_size);
+  RowType curr = m_data[k_size];
+  RowType currEast = eastOf(k_size);
 
+  for (int y = k_size; y > k_bottomBorder; y--) {
+    RowType botWest = westOf(y - 1);
+    RowType bot = m_data[y - 1];
+    RowType botEast = eastOf(y - 1);
+
+    writeRow(y,
+             finish(y, next(topWest, top, topEast, currWest, curr, currEast,
+                            botWest, bot, botEast) &
+                           k_dataBits),
+             changes);
+
+    topWest = currWest;
+    top = curr;
+    topEast = currEast;
+    currWest = botWest;
+    curr = bot;
+    currEast = botEast;
+  }
 
-    bool spawnFromBorder = br | bl | tr | tl;
+  processEmpty();
+  processChanged(changes);
 
-    for (int i = 0; i < nibbles && !spawnFromBorder; i++) {
-      spawnFromBorder = tcbibm[top & 0xFF] || tcbibm[bottom & 0xFF] ||
-                        tcbibm[left & 0xFF] || tcbibm[right & 0xFF];
+  return;
+}
 
-      top >>= 4;
-      bottom >>= 4;
-      left >>= 4;
-      right >>= 4;
-    }
+template <typename RowT, int32_t Size>
+void BasicChunk<RowT, Size>::processNextStateTable(const Rule &rule) {
+  std::array<bool, 512> bitsToState = rule.table();
 
-    if (!spawnFromBorder) {
-      return;
-    }
-  }
-  */
+  RowType topWest = westOf(k_topBorder);
+  RowType top = m_data[k_topBorder];
+  RowType topEast = eastOf(k_topBorder);
+  RowType currWest = westOf(k_size);
+  RowType curr = m_data[k_size];
+  RowType currEast = eastOf(k_size);
 
-  uint64_t top = m_data[k_topBorder];
+  RowChanges changes;
 
   for (int y = k_size; y > k_bottomBorder; y--) {
-    uint64_t newVals = 0;
-    uint64_t curr = m_data[y];
-    uint64_t bot = m_data[y - 1];
-    for (int x = Chunk::k_size - 1; x >= 0; x--) {
+    RowType newVals = 0;
+    RowType botWest = westOf(y - 1);
+    RowType bot = m_data[y - 1];
+    RowType botEast = eastOf(y - 1);
+
+    for (int x = 0; x < k_size; x++) {
+      RowType bit = cellBit(x);
       uint32_t around = 0;
 
       // Top 3 bits
-      around |= ((top >> x) & 0b111) << 6;
+      around |= (((topWest & bit) != 0) << 8) | (((top & bit) != 0) << 7) |
+                (((topEast & bit) != 0) << 6);
 
       // Middle 3 bits
-      around |= ((curr >> x) & 0b111) << 3;
+      around |= (((currWest & bit) != 0) << 5) | (((curr & bit) != 0) << 4) |
+                (((currEast & bit) != 0) << 3);
 
       // Bottom 3 bits
-      around |= (bot >> x) & 0b111;
-
-      // std::cout << "(" << x << "," << (y - 1) << ") -> "
-      //           << std::bitset<3>(around >> 6) << " "
-      //           << std::bitset<3>(around >> 3) << " " <<
-      //           std::bitset<3>(around)
-      //           << " -> " << bitsToState[around]
-      //           << std::endl;
+      around |= (((botWest & bit) != 0) << 2) | (((bot & bit) != 0) << 1) |
+                ((botEast & bit) != 0);
 
-      newVals |= bitsToState[around];
-      newVals <<= 1;
+      if (bitsToState[around]) {
+        newVals |= bit;
+      }
     }
-    // std::cout << std::bitset<Chunk::Size>(curr) << std::endl;
 
-    top = m_data[y];
-    m_data[y] = newVals;
+    writeRow(y, newVals, changes);
+
+    topWest = currWest;
+    top = curr;
+    topEast = currEast;
+    currWest = botWest;
+    curr = bot;
+    currEast = botEast;
   }
 
   processEmpty();
+  processChanged(changes);
 
   return;
 }
 
-void Chunk::processEmpty() {
-  uint64_t val = 0;
+template <typename RowT, int32_t Size>
+bool BasicChunk<RowT, Size>::staysEmpty(const Rule &rule) const {
+  bool stays;
+  LifeKernel::withRule(rule,
+                       [&](auto next) { stays = staysEmptyWith(next); });
+  return stays;
+}
+
+template <typename RowT, int32_t Size>
+template <typename Kernel>
+bool BasicChunk<RowT, Size>::staysEmptyWith(Kernel next) const {
+  if (!static_cast<uint32_t>(m_flags & Flags::EMPTY)) {
+    return false;
+  }
+
+  // With nothing inside only the cells along the edge have live neighbours.
+  // The top and bottom rows see the corners of the border so they get the
+  // whole rule, anywhere else down the left and right columns a cell only
+  // has the three border cells next to it.
+  RowType born =
+      next(westOf(k_topBorder), m_data[k_topBorder], eastOf(k_topBorder),
+           westOf(k_size), m_data[k_size], eastOf(k_size), westOf(k_size - 1),
+           m_data[k_size - 1], eastOf(k_size - 1)) |
+      next(westOf(2), m_data[2], eastOf(2), westOf(1), m_data[1], eastOf(1),
+           westOf(k_bottomBorder), m_data[k_bottomBorder],
+           eastOf(k_bottomBorder));
+
+  // All ones for the counts of up to three that give a birth, for Life only
+  // three in a row does
+  auto bornWith = [&](int n) {
+    return next.rule.birth >> n & 1 ? RowType(~RowType(0)) : RowType(0);
+  };
+  const RowType one = bornWith(1), two = bornWith(2), three = bornWith(3);
+  auto column = [&](RowType a, RowType b, RowType c) {
+    RowType odd = a ^ b ^ c;
+    RowType atLeastTwo = (a & b) | (c & (a ^ b));
+    return (odd & ~atLeastTwo & one) | (atLeastTwo & ~odd & two) |
+           (a & b & c & three);
+  };
+
+  // westOf() and eastOf() only have the left and right border in the data
+  // bits since the data itself is empty
+  RowType topWest = westOf(k_size);
+  RowType topEast = eastOf(k_size);
+  RowType currWest = westOf(k_size - 1);
+  RowType currEast = eastOf(k_size - 1);
+  for (int32_t y = k_size - 1; y > 1; y--) {
+    RowType botWest = westOf(y - 1);
+    RowType botEast = eastOf(y - 1);
+
+    born |= column(topWest, currWest, botWest) |
+            column(topEast, currEast, botEast);
+
+    topWest = currWest;
+    topEast = currEast;
+    currWest = botWest;
+    currEast = botEast;
+  }
+
+  return (born & k_dataBits) == 0;
+}
+
+template <typename RowT, int32_t Size>
+void BasicChunk<RowT, Size>::replayPrevious() {
+  for (int32_t y = 1; y <= k_size; y++) {
+    RowType old = m_data[y] & k_dataBits;
+    m_data[y] = m_prev[y - 1];
+    m_prev[y - 1] = old;
+  }
+
+  processEmpty();
+
+  // Played back it is the same as two generations ago by definition, and
+  // what changed from the last generation is the same as last time. The
+  // border wasn't looked at so it can't be trusted to be empty.
+  m_flags &= ~(Flags::OFF_PERIOD | Flags::ALL_BORDERS_EMPTY);
+  m_flags |= Flags::PARKED;
+  m_offPeriodEdges = 0;
+}
+
+template <typename RowT, int32_t Size>
+void BasicChunk<RowT, Size>::processStaysEmpty() {
+  // The rows are still written to move the last generation into m_prev
+  RowChanges changes;
+  for (int32_t y = k_size; y > k_bottomBorder; y--) {
+    writeRow(y, 0, changes);
+  }
+  processChanged(changes);
+}
+
+template <typename RowT, int32_t Size>
+void BasicChunk<RowT, Size>::writeRow(int32_t y, RowType next,
+                                      RowChanges &changes) {
+  RowType old = m_data[y] & k_dataBits;
+  RowType twoGensAgo = m_prev[y - 1] ^ next;
+
+  changes.lastGen |= old ^ next;
+  changes.twoGensAgo |= twoGensAgo;
+  if (y == k_size) {
+    changes.topTwoGensAgo = twoGensAgo;
+  }
+  if (y == 1) {
+    changes.bottomTwoGensAgo = twoGensAgo;
+  }
+
+  m_prev[y - 1] = old;
+  m_data[y] = next;
+}
+
+template <typename RowT, int32_t Size>
+void BasicChunk<RowT, Size>::processChanged(const RowChanges &changes) {
+  Flags flags = m_flags & ~(Flags::CHANGED | Flags::OFF_PERIOD |
+                            Flags::PARKED | Flags::EDITED);
+  if (changes.lastGen) {
+    flags |= Flags::CHANGED;
+  }
+  // Straight after an edit m_prev is the edited cells, which didn't come
+  // from processing, so this generation can't be played back next time
+  if (changes.twoGensAgo ||
+      static_cast<uint32_t>(m_flags & Flags::EDITED)) {
+    flags |= Flags::OFF_PERIOD;
+  }
+  m_flags = flags;
+
+  // m_prev has the rows from before by now
+  m_changedEdges = changedEdges(m_data[k_size] ^ m_prev[k_size - 1],
+                                changes.lastGen, m_data[1] ^ m_prev[0]);
+  m_offPeriodEdges = changedEdges(changes.topTwoGensAgo, changes.twoGensAgo,
+                                  changes.bottomTwoGensAgo);
+}
+
+template <typename RowT, int32_t Size>
+uint8_t BasicChunk<RowT, Size>::changedEdges(RowType top, RowType rows,
+                                             RowType bottom) {
+  constexpr RowType leftColumn = cellBit(0);
+  constexpr RowType rightColumn = cellBit(k_size - 1);
+  auto edge = [](bool changed, Neighbour::Index n) {
+    return static_cast<uint8_t>(changed << n);
+  };
+
+  return edge(top & leftColumn, Neighbour::UP_LEFT) |
+         edge(top, Neighbour::UP) |
+         edge(top & rightColumn, Neighbour::UP_RIGHT) |
+         edge(rows & leftColumn, Neighbour::LEFT) |
+         edge(rows & rightColumn, Neighbour::RIGHT) |
+         edge(bottom & leftColumn, Neighbour::DOWN_LEFT) |
+         edge(bottom, Neighbour::DOWN) |
+         edge(bottom & rightColumn, Neighbour::DOWN_RIGHT);
+}
+
+template <typename RowT, int32_t Size>
+void BasicChunk<RowT, Size>::processEmpty() {
+  RowType val = 0;
   // Skip top and bottom
   for (int32_t i = 1; i <= k_size; i++) {
     // Or with borders cleared
@@ -245,4 +509,203 @@ void Chunk::processEmpty() {
   } else {
     m_flags &= ~Flags::EMPTY;
   }
-};
+}
+
+template class BasicChunk<uint16_t, 8>;
+template class BasicChunk<uint32_t, 30>;
+template class BasicChunk<uint64_t, 62>;
+template class BasicChunk<uint64_t, 64>;
+
+template <typename RowT, int32_t Size>
+void BasicGenerationsChunk<RowT, Size>::processNextState(const Rule &rule) {
+  // Counters go from 1 for the first dying state up to last, and from last
+  // back to 0 for dead. Two states don't need any planes at all.
+  const uint32_t last = rule.states - 2;
+  const int32_t planes = std::bit_width(last);
+  RowType anyDying = 0;
+
+  auto finish = [&](int32_t y, RowType next) {
+    std::array<RowType, k_planes> &counter = m_dying[y - 1];
+    RowType dying = 0;
+    RowType atLast = ~RowType(0);
+    for (int32_t p = 0; p < planes; p++) {
+      dying |= counter[p];
+      atLast &= last >> p & 1 ? counter[p] : RowType(~counter[p]);
+    }
+    atLast &= dying;
+
+    // Nothing is born in a dying cell, the ones that were alive and aren't
+    // anymore start dying
+    next &= ~dying;
+    RowType died = this->m_data[y] & k_dataBits & ~next;
+
+    // Add one to every counter that isn't on the last state and clear the
+    // ones that are
+    RowType carry = dying & ~atLast;
+    for (int32_t p = 0; p < planes; p++) {
+      RowType bit = counter[p];
+      counter[p] = (bit ^ carry) & ~atLast;
+      carry &= bit;
+      anyDying |= counter[p];
+    }
+    if (planes > 0) {
+      counter[0] |= died;
+      anyDying |= died;
+    }
+    return next;
+  };
+
+  LifeKernel::withRule(rule, [&](auto next) {
+    if (this->staysEmptyWith(next)) {
+      this->processStaysEmpty();
+    } else {
+      this->stepWith(next, finish);
+    }
+  });
+  processDying(anyDying != 0);
+}
+
+template <typename RowT, int32_t Size>
+void BasicGenerationsChunk<RowT, Size>::readInBorder(
+    const BasicGenerationsChunk *chunks) {
+  // Same as for a BasicChunk but stepping through the array with the size of
+  // this one
+  std::array<const Base *, Neighbour::COUNT> n{};
+  for (uint32_t i = 0; i < Neighbour::COUNT; i++) {
+    if (this->neighbours[i] != k_noChunk) {
+      n[i] = &chunks[this->neighbours[i]];
+    }
+  }
+  this->readBorderFrom(n);
+}
+
+template <typename RowT, int32_t Size>
+uint32_t BasicGenerationsChunk<RowT, Size>::getState(int32_t x,
+                                                    int32_t y) const {
+  RowType bit = Base::cellBit(x);
+  if (this->m_data[y + 1] & bit) {
+    return 1;
+  }
+
+  uint32_t counter = 0;
+  for (int32_t p = 0; p < k_planes; p++) {
+    counter |= uint32_t((m_dying[y][p] & bit) != 0) << p;
+  }
+  return counter == 0 ? 0 : counter + 1;
+}
+
+template <typename RowT, int32_t Size>
+void BasicGenerationsChunk<RowT, Size>::setState(int32_t x, int32_t y,
+                                                uint32_t state) {
+  if (state < 2) {
+    setCell(x, y, state == 1);
+    return;
+  }
+
+  RowType bit = Base::cellBit(x);
+  Base::setCell(x, y, false);
+  for (int32_t p = 0; p < k_planes; p++) {
+    m_dying[y][p] = (state - 1) >> p & 1 ? m_dying[y][p] | bit
+                                         : m_dying[y][p] & ~bit;
+  }
+  this->m_flags &= ~Flags::EMPTY;
+  m_dyingGens |= 1;
+}
+
+template <typename RowT, int32_t Size>
+void BasicGenerationsChunk<RowT, Size>::limitStates(uint32_t states) {
+  const uint32_t last = states - 2;
+  for (std::array<RowType, k_planes> &counter : m_dying) {
+    // Compared from the top plane down, above is set for the cells that are
+    // already bigger and same for the ones that are the same as last so far
+    RowType above = 0;
+    RowType same = ~RowType(0);
+    for (int32_t p = k_planes - 1; p >= 0; p--) {
+      if (last >> p & 1) {
+        same &= counter[p];
+      } else {
+        above |= same & counter[p];
+        same &= ~counter[p];
+      }
+    }
+    for (RowType &plane : counter) {
+      plane &= ~above;
+    }
+  }
+}
+
+template <typename RowT, int32_t Size>
+void BasicGenerationsChunk<RowT, Size>::setCell(int32_t x, int32_t y,
+                                               bool val) {
+  clearDying(y + 1, Base::cellBit(x));
+  Base::setCell(x, y, val);
+}
+
+template <typename RowT, int32_t Size>
+void BasicGenerationsChunk<RowT, Size>::setRow(int32_t y, RowType bits,
+                                              bool val) {
+  clearDying(y + 1, bits & k_dataBits);
+  Base::setRow(y, bits, val);
+}
+
+template <typename RowT, int32_t Size>
+bool BasicGenerationsChunk<RowT, Size>::replaceRow(int32_t y, RowType mask,
+                                                  RowType bits) {
+  // Dying cells that get replaced are a change even if the live ones stay
+  // the same
+  RowType dying = dyingRow(y + 1) & mask & k_dataBits;
+  clearDying(y + 1, dying);
+  if (Base::replaceRow(y, mask, bits)) {
+    return true;
+  }
+  if (dying) {
+    this->markEdited();
+  }
+  return dying != 0;
+}
+
+template <typename RowT, int32_t Size>
+void BasicGenerationsChunk<RowT, Size>::loadRows(const RowType *rows) {
+  m_dying = {};
+  m_dyingGens &= ~1;
+  Base::loadRows(rows);
+}
+
+template <typename RowT, int32_t Size>
+RowT BasicGenerationsChunk<RowT, Size>::dyingRow(int32_t y) const {
+  RowType dying = 0;
+  for (RowType plane : m_dying[y - 1]) {
+    dying |= plane;
+  }
+  return dying;
+}
+
+template <typename RowT, int32_t Size>
+void BasicGenerationsChunk<RowT, Size>::clearDying(int32_t y, RowType bits) {
+  for (RowType &plane : m_dying[y - 1]) {
+    plane &= ~bits;
+  }
+}
+
+template <typename RowT, int32_t Size>
+void BasicGenerationsChunk<RowT, Size>::processDying(bool dying) {
+  m_dyingGens = (m_dyingGens << 1 | dying) & 0b111;
+
+  // Dying cells step on every generation, so the chunk changes until the
+  // last of them is dead and can't be played back until two generations
+  // after that
+  if (m_dyingGens & 0b1) {
+    this->m_flags &= ~Flags::EMPTY;
+  }
+  if (m_dyingGens & 0b11) {
+    this->m_flags |= Flags::CHANGED;
+  }
+  if (m_dyingGens & 0b111) {
+    this->m_flags |= Flags::OFF_PERIOD;
+  }
+}
+
+template class BasicGenerationsChunk<uint16_t, 8>;
+template class BasicGenerationsChunk<uint32_t, 30>;
+template class BasicGenerationsChunk<uint64_t, 62>;
+template class BasicGenerationsChunk<uint64_t, 64>;
@@ -1,53 +1,250 @@
 #pragma once
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <iostream>
 #include <limits>
-#include <memory>
 
-class Chunk {
+#include "Rule.h"
+
+enum class ChunkFlags : uint32_t {
+  CLEAR = 0,
+  // Flag specifying that the chunk is currently empty better to just check
+  // this than constantly caluclate it
+  EMPTY = 1,
+  // Flag specifying that one or more of the surrounding border chunks does
+  // not exist
+  MISSING_BORDER_CHUNK = 1 << 1,
+  // Flag specifying if all surrounding border chunks are empty
+  ALL_BORDERS_EMPTY = 1 << 2,
+  // Flag specifying that cells changed when the chunk was last processed or
+  // have been set since then
+  CHANGED = 1 << 3,
+  // Flag specifying that the cells are different from two generations ago,
+  // without it the chunk is holding still or blinking with period 2
+  OFF_PERIOD = 1 << 4,
+  // Flag specifying that the chunk was last moved on by replayPrevious()
+  // instead of being processed
+  PARKED = 1 << 5,
+  // Flag specifying that cells were set since the chunk was last processed.
+  // The generation before didn't lead to the cells there are now so it can't
+  // be played back yet.
+  EDITED = 1 << 6,
+};
+
+inline ChunkFlags operator~(ChunkFlags a) {
+  return static_cast<ChunkFlags>(~static_cast<uint32_t>(a));
+}
+inline ChunkFlags operator|(ChunkFlags a, ChunkFlags b) {
+  return static_cast<ChunkFlags>(static_cast<uint32_t>(a) |
+                                 static_cast<uint32_t>(b));
+}
+inline ChunkFlags operator&(ChunkFlags a, ChunkFlags b) {
+  return static_cast<ChunkFlags>(static_cast<uint32_t>(a) &
+                                 static_cast<uint32_t>(b));
+}
+inline ChunkFlags operator^(ChunkFlags a, ChunkFlags b) {
+  return static_cast<ChunkFlags>(static_cast<uint32_t>(a) ^
+                                 static_cast<uint32_t>(b));
+}
+inline ChunkFlags &operator|=(ChunkFlags &a, ChunkFlags b) {
+  a = a | b;
+  return a;
+}
+inline ChunkFlags &operator&=(ChunkFlags &a, ChunkFlags b) {
+  a = a & b;
+  return a;
+}
+inline ChunkFlags &operator^=(ChunkFlags &a, ChunkFlags b) {
+  a = a ^ b;
+  return a;
+}
+
+/**
+ * Which of the eight surrounding chunks an entry of BasicChunk::neighbours
+ * is. The order is picked so that the opposite of n is always 7 - n.
+ */
+namespace Neighbour {
+enum Index : uint32_t {
+  UP_LEFT,
+  UP,
+  UP_RIGHT,
+  LEFT,
+  RIGHT,
+  DOWN_LEFT,
+  DOWN,
+  DOWN_RIGHT,
+  COUNT,
+};
+
+constexpr Index opposite(Index n) { return static_cast<Index>(7 - n); }
+
+// Chunk key offset of each neighbour, up is +y
+constexpr std::array<std::array<int32_t, 2>, COUNT> k_offsets{{
+    {-1, 1},
+    {0, 1},
+    {1, 1},
+    {-1, 0},
+    {1, 0},
+    {-1, -1},
+    {0, -1},
+    {1, -1},
+}};
+} // namespace Neighbour
+
+/**
+ * A square of k_size x k_size cells, one row per RowType, with a one cell
+ * border read in from the surrounding chunks.
+ *
+ * When RowType has at least two spare bits the border lives inside the rows
+ * (left border in the top spare bit, right border in bit 0). When the chunk is
+ * as wide as RowType (64 cells in a uint64_t) there is no room for that so the
+ * left and right border bits are kept in a separate halo array instead.
+ */
+template <typename RowT, int32_t Size> class BasicChunk {
 public:
-  using RowType = uint16_t;
-
-  enum class Flags : uint32_t {
-    CLEAR = 0,
-    // Flag specifying that the chunk is currently empty better to just check
-    // this than constantly caluclate it
-    EMPTY = 1,
-    // Flag specifying that one or more of the surrounding border chunks does
-    // not exist
-    MISSING_BORDER_CHUNK = 1 << 1,
-    // Flag specifying if all surrounding border chunks are empty
-    ALL_BORDERS_EMPTY = 1 << 2,
-  };
+  using RowType = RowT;
+  using Flags = ChunkFlags;
+
+  static constexpr int32_t k_rowBits = sizeof(RowType) * 8;
+  static constexpr bool k_separateHalo = Size == k_rowBits;
+  static_assert(std::numeric_limits<RowType>::is_signed == false);
+  static_assert(k_separateHalo || Size <= k_rowBits - 2,
+                "Chunk rows need two spare bits for the border or have to "
+                "fill the whole row");
 
-  // I think this should size should be 6 bits under the type used in m_data for
-  // each row.
-  static constexpr int32_t k_size = 8;
+  static constexpr int32_t k_size = Size;
+  // Dead and alive, see BasicGenerationsChunk for more
+  static constexpr uint32_t k_maxStates = 2;
   static constexpr int32_t k_topBorder = k_size + 1;
   static constexpr int32_t k_bottomBorder = 0;
-  static constexpr RowType k_leftBorderBit = 1ul << (k_size + 1);
-  static constexpr RowType k_rightBorderBit = 1ul;
-  static constexpr RowType k_dataBits = ((1ul << k_size) - 1) << 1;
-
-  std::shared_ptr<Chunk> upLeft;
-  std::shared_ptr<Chunk> up;
-  std::shared_ptr<Chunk> upRight;
-  std::shared_ptr<Chunk> left;
-  std::shared_ptr<Chunk> right;
-  std::shared_ptr<Chunk> downLeft;
-  std::shared_ptr<Chunk> down;
-  std::shared_ptr<Chunk> downRight;
+  // How far the data is shifted up from bit 0 of a row
+  static constexpr int32_t k_dataShift = k_separateHalo ? 0 : 1;
+  static constexpr RowType k_leftBorderBit =
+      k_separateHalo ? 0 : RowType(1) << (k_size + 1);
+  static constexpr RowType k_rightBorderBit = k_separateHalo ? 0 : 1;
+  static constexpr RowType k_dataBits =
+      k_separateHalo ? RowType(~RowType(0))
+                     : RowType(((RowType(1) << k_size) - 1) << 1);
+  // Bits in m_halo used for the left and right border with k_separateHalo
+  static constexpr uint8_t k_haloLeft = 0b10;
+  static constexpr uint8_t k_haloRight = 0b01;
+
+  // Marks a missing neighbour in neighbours
+  static constexpr uint32_t k_noChunk = std::numeric_limits<uint32_t>::max();
+
+  /**
+   * Index of each surrounding chunk in the storage of the board that owns
+   * this chunk, in Neighbour::Index order
+   */
+  std::array<uint32_t, Neighbour::COUNT> neighbours = makeNoNeighbours();
 
   // I am not sure if this should return the chunks Flags, maybe there should
   // just be a function called getFlags() or maybe both?
-  void processNextState();
-  void readInBorder();
+  void processNextState(const Rule &rule = Rule());
+  /**
+   * Reference version of processNextState() that looks up every cell on its
+   * own in a table. Slow, but simple enough to check the fast one against.
+   */
+  void processNextStateTable(const Rule &rule = Rule());
+  /**
+   * Read the border in from the neighbours, chunks is the start of the
+   * storage that the neighbour indices point into
+   */
+  void readInBorder(const BasicChunk *chunks);
   Flags getFlags() { return m_flags; }
+  void addFlags(Flags flags) { m_flags |= flags; }
+  /**
+   * Flags the chunk the same as when cells get set in it, so the next update
+   * steps it and everything around it
+   */
+  void markEdited() {
+    m_flags |= Flags::CHANGED | Flags::OFF_PERIOD | Flags::EDITED;
+    m_changedEdges = 0xFF;
+    m_offPeriodEdges = 0xFF;
+  }
+
+  /**
+   * Bit n is set if the cells that neighbour n reads as its border changed
+   * along with Flags::CHANGED
+   */
+  uint8_t getChangedEdges() const { return m_changedEdges; }
+  /**
+   * Same as getChangedEdges() but for Flags::OFF_PERIOD
+   */
+  uint8_t getOffPeriodEdges() const { return m_offPeriodEdges; }
+
+  /**
+   * Go back to the cells of the last generation. That's what processing
+   * would give as long as this chunk and the edges of its neighbours are the
+   * same as two generations ago, so a chunk blinking with period 2 can be
+   * played back without reading its border or stepping it.
+   */
+  void replayPrevious();
+
+  /**
+   * True if the chunk is empty and nothing in its border can cause a birth
+   * under rule, so processing it wouldn't change anything. The border has to
+   * be read in.
+   */
+  bool staysEmpty(const Rule &rule = Rule()) const;
 
   bool getCell(int32_t x, int32_t y);
   void setCell(int32_t x, int32_t y, bool val);
 
+  /**
+   * The cells of row y, laid out like cellBit()
+   */
+  RowType getRow(int32_t y) const { return m_data[y + 1] & k_dataBits; }
+  /**
+   * Sets (or clears with val false) every cell of row y that is in bits, same
+   * as calling setCell() for each of them
+   */
+  void setRow(int32_t y, RowType bits, bool val);
+  /**
+   * Replaces the cells of row y that are in mask with the ones in bits,
+   * returns false without touching anything if they are the same already
+   */
+  bool replaceRow(int32_t y, RowType mask, RowType bits);
+  /**
+   * Overwrites all k_size rows with rows, laid out the way getRow() gives
+   * them
+   */
+  void loadRows(const RowType *rows);
+
+  /**
+   * Bit of a row that holds the cell in column x, x = 0 is the leftmost cell.
+   */
+  static constexpr RowType cellBit(int32_t x) {
+    return RowType(1) << (k_size - 1 - x + k_dataShift);
+  }
+  /**
+   * Bits of the cells in columns x to x + length - 1
+   */
+  static constexpr RowType runBits(int32_t x, int32_t length) {
+    // Wraps around to all the bits from the last cell up when the first cell
+    // is the top bit
+    return RowType(RowType(cellBit(x) << 1) - cellBit(x + length - 1));
+  }
+  /**
+   * Column of the cell in bit
+   */
+  static constexpr int32_t cellColumn(int32_t bit) {
+    return k_size - 1 + k_dataShift - bit;
+  }
+  /**
+   * Convert between a row and a word with the cell in column x in bit x, the
+   * way LifeEngine bitmaps have them
+   */
+  static constexpr RowType fromColumns(uint64_t columns) {
+    return RowType(reverseBits(columns) >> (64 - k_size - k_dataShift)) &
+           k_dataBits;
+  }
+  static constexpr uint64_t toColumns(RowType row) {
+    return reverseBits(uint64_t(row & k_dataBits)
+                       << (64 - k_size - k_dataShift));
+  }
+
   using iterator = typename std::array<RowType, k_size + 2>::iterator;
   using reverse_iterator =
       typename std::array<RowType, k_size + 2>::reverse_iterator;
@@ -68,73 +265,218 @@ public:
   reverse_iterator rend() { return m_data.rend(); };
   const_reverse_iterator rend() const { return m_data.rend(); };
 
-  friend std::ostream &operator<<(std::ostream &o, Chunk &c);
+  template <typename R, int32_t S>
+  friend std::ostream &operator<<(std::ostream &o, BasicChunk<R, S> &c);
+  template <typename C> friend class BatchStepper;
 
-private:
+protected:
   Flags m_flags = Flags::EMPTY;
+  uint8_t m_changedEdges = 0;
+  uint8_t m_offPeriodEdges = 0;
   std::array<RowType, k_size + 2> m_data{};
+  // Data rows of the last generation, m_prev[y - 1] goes with m_data[y]
+  std::array<RowType, k_size> m_prev{};
+  // Left and right border bits of each row, only used with k_separateHalo
+  std::array<uint8_t, k_separateHalo ? k_size + 2 : 0> m_halo{};
+
+  /**
+   * What changed while writing the rows of a new generation, all rows ored
+   * together plus the top and bottom row against two generations ago
+   */
+  struct RowChanges {
+    RowType lastGen = 0;
+    RowType twoGensAgo = 0;
+    RowType topTwoGensAgo = 0;
+    RowType bottomTwoGensAgo = 0;
+  };
 
+  /**
+   * processNextState() and staysEmpty() with the LifeKernel kernel for the
+   * rule, so the rule is only looked at once per chunk. finish(y, row) gets
+   * each new data row before it is written and gives back what to write.
+   */
+  template <typename Kernel, typename Finish>
+  void stepWith(Kernel next, Finish finish);
+  template <typename Kernel> bool staysEmptyWith(Kernel next) const;
+  /**
+   * Puts next in data row y and moves the row it replaces into m_prev
+   */
+  void writeRow(int32_t y, RowType next, RowChanges &changes);
   void processEmpty();
+  /**
+   * Processing for when staysEmpty() is true, only the bookkeeping is left
+   */
+  void processStaysEmpty();
+  /**
+   * Sets the change flags and edges once all rows are written
+   */
+  void processChanged(const RowChanges &changes);
+  static uint8_t changedEdges(RowType top, RowType rows, RowType bottom);
+
+  static constexpr uint64_t reverseBits(uint64_t v) {
+    v = ((v >> 1) & 0x5555555555555555ull) | ((v & 0x5555555555555555ull) << 1);
+    v = ((v >> 2) & 0x3333333333333333ull) | ((v & 0x3333333333333333ull) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((v & 0x0F0F0F0F0F0F0F0Full) << 4);
+    v = ((v >> 8) & 0x00FF00FF00FF00FFull) | ((v & 0x00FF00FF00FF00FFull) << 8);
+    v = ((v >> 16) & 0x0000FFFF0000FFFFull) |
+        ((v & 0x0000FFFF0000FFFFull) << 16);
+    return (v >> 32) | (v << 32);
+  }
+
+  static constexpr std::array<uint32_t, Neighbour::COUNT> makeNoNeighbours() {
+    std::array<uint32_t, Neighbour::COUNT> n{};
+    n.fill(k_noChunk);
+    return n;
+  }
+
+  /**
+   * Row i lined up so that each cell's bit holds the cell to its left
+   */
+  RowType westOf(int32_t i) const;
+  /**
+   * Row i lined up so that each cell's bit holds the cell to its right
+   */
+  RowType eastOf(int32_t i) const;
+  /**
+   * Border bits to take from a chunk to the left or right of this one
+   */
+  static RowType leftBorderFrom(RowType row);
+  static RowType rightBorderFrom(RowType row);
+  void orBorder(int32_t i, RowType bits);
+  /**
+   * readInBorder() once the neighbours are found, missing ones are nullptr
+   */
+  void readBorderFrom(
+      const std::array<const BasicChunk *, Neighbour::COUNT> &n);
+  /**
+   * Like getCell() but x and y can be -1 or k_size to get the border
+   */
+  bool getWithBorder(int32_t x, int32_t y);
 };
 
-inline Chunk::Flags operator~(Chunk::Flags a) {
-  return static_cast<Chunk::Flags>(~static_cast<uint32_t>(a));
-}
-inline Chunk::Flags operator|(Chunk::Flags a, Chunk::Flags b) {
-  return static_cast<Chunk::Flags>(static_cast<uint32_t>(a) |
-                                   static_cast<uint32_t>(b));
-}
-inline Chunk::Flags operator&(Chunk::Flags a, Chunk::Flags b) {
-  return static_cast<Chunk::Flags>(static_cast<uint32_t>(a) &
-                                   static_cast<uint32_t>(b));
-}
-inline Chunk::Flags operator^(Chunk::Flags a, Chunk::Flags b) {
-  return static_cast<Chunk::Flags>(static_cast<uint32_t>(a) ^
-                                   static_cast<uint32_t>(b));
-}
-inline Chunk::Flags &operator|=(Chunk::Flags &a, Chunk::Flags b) {
-  a = a | b;
-  return a;
-}
-inline Chunk::Flags &operator&=(Chunk::Flags &a, Chunk::Flags b) {
-  a = a & b;
-  return a;
-}
-inline Chunk::Flags &operator^=(Chunk::Flags &a, Chunk::Flags b) {
-  a = a ^ b;
-  return a;
-}
+// The supported chunk layouts, all of them are explicitly instantiated in
+// Chunk.cpp
+using Chunk8 = BasicChunk<uint16_t, 8>;
+using Chunk30 = BasicChunk<uint32_t, 30>;
+using Chunk62 = BasicChunk<uint64_t, 62>;
+using Chunk64 = BasicChunk<uint64_t, 64>;
+
+extern template class BasicChunk<uint16_t, 8>;
+extern template class BasicChunk<uint32_t, 30>;
+extern template class BasicChunk<uint64_t, 62>;
+extern template class BasicChunk<uint64_t, 64>;
 
 /**
- * This function creates a table (array) with indices spanning all possible
- * values for a given unsigned integer type. Each value in the array is a bool
- * representing whether the integer has three consecutive bits somewhere within
- * it (true) or not (false).
+ * A chunk for Generations rules, where a cell that dies goes through
+ * rule.states - 2 dying states before it is dead.
+ *
+ * The live cells are the rows of the BasicChunk so reading the border, the
+ * edges and the flags all work the same as with two states. Each dying cell
+ * has a counter on top of that, 1 for the first dying state (state 2) and up
+ * from there, kept in k_planes bitplanes of each row. A generation steps the
+ * live cells with the same kernels and then counts every plane on by one
+ * with bitwise adds, only looking at as many planes as the rule has states
+ * for.
  *
- * I have a feeling it could be faster, but it's constexpr so definitely not a
- * priority
+ * Flags::EMPTY means no live or dying cells, Flags::CHANGED and
+ * Flags::OFF_PERIOD are also set while there are dying cells around. Dying
+ * cells don't count as neighbours so the edges stay the ones of the live
+ * cells. Only the live cells go through getRow() and everything built on it
+ * like snapshots and delta logs, getState() has the rest.
  */
-template <typename UintThingy,
-          uint64_t numVals = (1 << (sizeof(UintThingy) * 8))>
-constexpr std::array<bool, numVals> getThreeConsecutiveBitCheckTable() {
-  static_assert(std::numeric_limits<UintThingy>::is_signed == false);
-  std::array<bool, numVals> table{};
-
-  for (UintThingy candidate = std::numeric_limits<UintThingy>::max();
-       candidate >= 0b111; candidate--) {
-    UintThingy testee = candidate;
-
-    // I figured I could subtract 3 and not 2 here, but that seems to be an off
-    // by 1 bc/ the output was wrong for consecutive bits in the most
-    // significant nibble (i.e. 0b11100000 was false) I might be sleepy...
-    for (int i = sizeof(UintThingy) * 8 - 2; i >= 0; i--) {
-      if (!(testee & 0b0111 ^ 0b0111)) {
-        table[candidate] = true;
-        break;
-      }
-      testee >>= 1;
-    }
-  }
+template <typename RowT, int32_t Size>
+class BasicGenerationsChunk : public BasicChunk<RowT, Size> {
+  using Base = BasicChunk<RowT, Size>;
 
-  return table;
-}
+public:
+  using RowType = RowT;
+  using typename Base::Flags;
+  using Base::k_dataBits;
+  using Base::k_noChunk;
+  using Base::k_size;
+
+  static constexpr int32_t k_planes = 8;
+  // The counter goes up to the number of dying states
+  static constexpr uint32_t k_maxStates =
+      std::min<uint32_t>((1u << k_planes) + 1, Rule::k_maxStates);
+
+  /**
+   * Steps the live cells and the dying ones with them, rule.states can't be
+   * more than k_maxStates
+   */
+  void processNextState(const Rule &rule = Rule());
+  // Only knows about two states
+  void processNextStateTable(const Rule &rule = Rule()) = delete;
+  void readInBorder(const BasicGenerationsChunk *chunks);
+
+  /**
+   * 0 for dead, 1 for alive and 2 up for the dying states
+   */
+  uint32_t getState(int32_t x, int32_t y) const;
+  void setState(int32_t x, int32_t y, uint32_t state);
+  /**
+   * Kills every dying cell with a state of states or more, for going over
+   * to a rule with fewer
+   */
+  void limitStates(uint32_t states);
+
+  /**
+   * Same as for a BasicChunk, cells that get set go from dying to dead or
+   * alive
+   */
+  void setCell(int32_t x, int32_t y, bool val);
+  void setRow(int32_t y, RowType bits, bool val);
+  bool replaceRow(int32_t y, RowType mask, RowType bits);
+  void loadRows(const RowType *rows);
+
+private:
+  // Counter planes of each data row, m_dying[y - 1] goes with m_data[y]
+  std::array<std::array<RowType, k_planes>, k_size> m_dying{};
+  // Bit 0 is set if there are dying cells now, bit 1 a generation ago and
+  // bit 2 two generations ago
+  uint8_t m_dyingGens = 0;
+
+  /**
+   * Cells of data row y (from 1) that are dying
+   */
+  RowType dyingRow(int32_t y) const;
+  /**
+   * Turns the dying cells of data row y in bits dead
+   */
+  void clearDying(int32_t y, RowType bits);
+  /**
+   * Moves m_dyingGens on a generation and adds its flags to the ones the
+   * live cells got
+   */
+  void processDying(bool dying);
+};
+
+// Generations chunks in the same layout as Chunk, explicitly instantiated in
+// Chunk.cpp
+extern template class BasicGenerationsChunk<uint16_t, 8>;
+extern template class BasicGenerationsChunk<uint32_t, 30>;
+extern template class BasicGenerationsChunk<uint64_t, 62>;
+extern template class BasicGenerationsChunk<uint64_t, 64>;
+
+// Chunk size used by the GameBoard, one of 8, 30, 62 or 64. The build sets it
+// with the GAME_OF_LIFE_CHUNK_SIZE CMake option.
+#ifndef CHUNK_SIZE
+#define CHUNK_SIZE 8
+#endif
+
+static_assert(CHUNK_SIZE == 8 || CHUNK_SIZE == 30 || CHUNK_SIZE == 62 ||
+                  CHUNK_SIZE == 64,
+              "CHUNK_SIZE has to be one of 8, 30, 62 or 64");
+
+#if CHUNK_SIZE == 8
+using Chunk = Chunk8;
+#elif CHUNK_SIZE == 30
+using Chunk = Chunk30;
+#elif CHUNK_SIZE == 62
+using Chunk = Chunk62;
+#else
+using Chunk = Chunk64;
+#endif
+
+using GenerationsChunk =
+    BasicGenerationsChunk<Chunk::RowType, Chunk::k_size>;
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "ChunkKey.h"
+
+/**
+ * Contiguous storage for all the chunks of a board. Chunks are referred to by
+ * their index, which stays the same for as long as the chunk is alive, and
+ * freed slots are handed out again before the storage grows.
+ *
+ * Pointers and references into the arena are only good until the next
+ * allocate() since growing it can move every chunk.
+ */
+template <typename ChunkT> class ChunkArena {
+public:
+  /**
+   * Get a fresh chunk for key and return its index
+   */
+  uint32_t allocate(ChunkKey key) {
+    if (!m_free.empty()) {
+      uint32_t index = m_free.back();
+      m_free.pop_back();
+
+      m_chunks[index] = ChunkT();
+      m_keys[index] = key;
+      m_live[index] = true;
+      return index;
+    }
+
+    m_chunks.emplace_back();
+    m_keys.push_back(key);
+    m_live.push_back(true);
+    return static_cast<uint32_t>(m_chunks.size() - 1);
+  }
+
+  void release(uint32_t index) {
+    m_live[index] = false;
+    m_free.push_back(index);
+  }
+
+  ChunkT &operator[](uint32_t index) { return m_chunks[index]; }
+  const ChunkT &operator[](uint32_t index) const { return m_chunks[index]; }
+
+  ChunkT *data() { return m_chunks.data(); }
+  const ChunkT *data() const { return m_chunks.data(); }
+
+  ChunkKey key(uint32_t index) const { return m_keys[index]; }
+  bool isLive(uint32_t index) const { return m_live[index]; }
+
+  /**
+   * One past the highest index handed out so far, live or not
+   */
+  uint32_t capacity() const { return static_cast<uint32_t>(m_chunks.size()); }
+  /**
+   * Number of live chunks
+   */
+  size_t size() const { return m_chunks.size() - m_free.size(); }
+
+  /**
+   * Make room for count chunks without growing again
+   */
+  void reserve(size_t count) {
+    m_chunks.reserve(count);
+    m_keys.reserve(count);
+    m_live.reserve(count);
+  }
+
+  void clear() {
+    m_chunks.clear();
+    m_keys.clear();
+    m_live.clear();
+    m_free.clear();
+  }
+
+private:
+  std::vector<ChunkT> m_chunks;
+  std::vector<ChunkKey> m_keys;
+  std::vector<uint8_t> m_live;
+  std::vector<uint32_t> m_free;
+};
@@ -0,0 +1,32 @@
+#include <algorithm>
+
+#include "ChunkFrame.h"
+#include "LifeEngine.h"
+
+void ChunkFrame::getRegion(int32_t x, int32_t y, int32_t width,
+                           int32_t height, uint64_t *bits) const {
+  size_t stride = LifeEngine::regionStride(width);
+  std::fill(bits, bits + height * stride, 0);
+
+  for (size_t i = 0; i < chunks.size(); i++) {
+    int64_t left = int64_t(chunks[i].key.x) * chunkSize;
+    int64_t bottom = int64_t(chunks[i].key.y) * chunkSize;
+    // Part of the chunk inside the region, relative to the chunk
+    int64_t fromX = std::max<int64_t>(0, x - left);
+    int64_t toX = std::min<int64_t>(chunkSize, x + int64_t(width) - left);
+    int64_t fromY = std::max<int64_t>(0, y - bottom);
+    int64_t toY = std::min<int64_t>(chunkSize, y + int64_t(height) - bottom);
+
+    const uint32_t *chunkRows = rowsOf(i);
+    for (int64_t cy = fromY; cy < toY; cy++) {
+      const uint32_t *row = chunkRows + cy * rowWords;
+      uint64_t *out = bits + (bottom + cy - y) * stride;
+      for (int64_t cx = fromX; cx < toX; cx++) {
+        if (row[cx / 32] >> (cx % 32) & 1) {
+          int64_t bit = left + cx - x;
+          out[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ChunkKey.h"
+
+/**
+ * The chunks with live cells in part of a board, packed up so they can be
+ * handed to another thread or straight to the GPU.
+ *
+ * Every chunk is chunkSize rows from the bottom up, each rowWords 32 bit
+ * words with bit x % 32 of word x / 32 being the cell x to the right of the
+ * left edge of the chunk. The version of a chunk only changes when its cells
+ * do, so whatever keeps a copy of it only has to look at it again when the
+ * version is different.
+ */
+struct ChunkFrame {
+  struct Chunk {
+    ChunkKey key;
+    uint64_t version;
+  };
+
+  int32_t chunkSize = 0;
+  int32_t rowWords = 0;
+  std::vector<Chunk> chunks;
+  std::vector<uint32_t> rows;
+
+  /**
+   * Empties the frame for chunks of size cells
+   */
+  void reset(int32_t size) {
+    chunkSize = size;
+    rowWords = (size + 31) / 32;
+    chunks.clear();
+    rows.clear();
+  }
+
+  size_t chunkWords() const { return size_t(chunkSize) * rowWords; }
+  const uint32_t *rowsOf(size_t i) const {
+    return rows.data() + i * chunkWords();
+  }
+
+  /**
+   * Adds a chunk and gives back where its rows go
+   */
+  uint32_t *add(ChunkKey key, uint64_t version) {
+    chunks.push_back({key, version});
+    rows.resize(rows.size() + chunkWords());
+    return rows.data() + rows.size() - chunkWords();
+  }
+
+  /**
+   * Fills a region bitmap, laid out like LifeEngine::getRegion() gives it,
+   * with the cells of the frame. Anything that isn't in a chunk is dead.
+   */
+  void getRegion(int32_t x, int32_t y, int32_t width, int32_t height,
+                 uint64_t *bits) const;
+};
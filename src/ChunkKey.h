@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+
+struct ChunkKey {
+  constexpr ChunkKey(int32_t x, int32_t y) : x(x), y(y) {}
+  constexpr ChunkKey(std::array<int32_t, 2> p) : x(p[0]), y(p[1]) {}
+
+  int32_t x;
+  int32_t y;
+
+  bool operator==(ChunkKey &key) {
+    return this->x == key.x && this->y == key.y;
+  }
+  bool operator==(const ChunkKey &key) const {
+    return this->x == key.x && this->y == key.y;
+  }
+};
+
+class ChunkKeyHash {
+public:
+  std::size_t operator()(const ChunkKey &c) const {
+    auto h1 = std::hash<int32_t>{}(c.x);
+    auto h2 = std::hash<int32_t>{}(c.y);
+
+    return (53 + h1) * 53 + h2;
+  }
+};
+
+namespace Morton {
+
+/**
+ * Spreads the 32 bits of v out over the even bits of the result
+ */
+constexpr uint64_t spread(uint32_t v) {
+  uint64_t x = v;
+  x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+  x = (x | (x << 8)) & 0x00FF00FF00FF00FFull;
+  x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0Full;
+  x = (x | (x << 2)) & 0x3333333333333333ull;
+  x = (x | (x << 1)) & 0x5555555555555555ull;
+  return x;
+}
+
+/**
+ * Undoes spread(), the odd bits are ignored
+ */
+constexpr uint32_t compact(uint64_t x) {
+  x &= 0x5555555555555555ull;
+  x = (x | (x >> 1)) & 0x3333333333333333ull;
+  x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+  x = (x | (x >> 4)) & 0x00FF00FF00FF00FFull;
+  x = (x | (x >> 8)) & 0x0000FFFF0000FFFFull;
+  x = (x | (x >> 16)) & 0x00000000FFFFFFFFull;
+  return static_cast<uint32_t>(x);
+}
+
+// Flipping the sign bit makes -1 come right before 0 so sorting by the code
+// walks the Z curve through negative and positive keys without a jump
+constexpr uint32_t k_signFlip = 0x80000000u;
+
+/**
+ * Packs a key into one 64 bit number with the bits of x and y interleaved,
+ * keys close together on the board end up close together when sorted
+ */
+constexpr uint64_t encode(ChunkKey key) {
+  return spread(static_cast<uint32_t>(key.x) ^ k_signFlip) |
+         (spread(static_cast<uint32_t>(key.y) ^ k_signFlip) << 1);
+}
+
+constexpr ChunkKey decode(uint64_t code) {
+  return {static_cast<int32_t>(compact(code) ^ k_signFlip),
+          static_cast<int32_t>(compact(code >> 1) ^ k_signFlip)};
+}
+
+} // namespace Morton
@@ -0,0 +1,249 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "ChunkKey.h"
+
+/**
+ * Flat hash map from a ChunkKey to a small value (the arena index of a chunk).
+ *
+ * Keys are stored as their Morton code and the table is open addressing with
+ * Robin Hood probing: when inserting, an entry that is closer to its home slot
+ * than the one being placed gives its slot up, so every probe sequence stays
+ * short even when full to 7/8. Erasing shifts the following entries back
+ * instead of leaving tombstones.
+ *
+ * Iterating goes in slot order which has nothing to do with where the chunks
+ * are, spatialOrder() sorts the entries along the Z curve instead.
+ */
+template <typename Value> class ChunkMap {
+public:
+  struct Entry {
+    ChunkKey key;
+    Value value;
+  };
+
+  class const_iterator {
+  public:
+    Entry operator*() const {
+      return {Morton::decode(m_slot->code), m_slot->value};
+    }
+    const_iterator &operator++() {
+      m_slot++;
+      skipEmpty();
+      return *this;
+    }
+    bool operator==(const const_iterator &other) const {
+      return m_slot == other.m_slot;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return m_slot != other.m_slot;
+    }
+
+  private:
+    friend ChunkMap;
+
+    const_iterator(const typename ChunkMap::Slot *slot,
+                   const typename ChunkMap::Slot *end)
+        : m_slot(slot), m_end(end) {
+      skipEmpty();
+    }
+
+    void skipEmpty() {
+      while (m_slot != m_end && m_slot->dist == 0) {
+        m_slot++;
+      }
+    }
+
+    const typename ChunkMap::Slot *m_slot;
+    const typename ChunkMap::Slot *m_end;
+  };
+
+  /**
+   * Pointer to the value for key or nullptr if it isn't in the map. Only good
+   * until the map is changed.
+   */
+  Value *find(ChunkKey key) {
+    size_t slot = findSlot(Morton::encode(key));
+    return slot == k_notFound ? nullptr : &m_slots[slot].value;
+  }
+  const Value *find(ChunkKey key) const {
+    size_t slot = findSlot(Morton::encode(key));
+    return slot == k_notFound ? nullptr : &m_slots[slot].value;
+  }
+  bool contains(ChunkKey key) const { return find(key) != nullptr; }
+
+  /**
+   * Adds key to the map or overwrites the value if it is already there
+   */
+  void insert(ChunkKey key, Value value) {
+    uint64_t code = Morton::encode(key);
+
+    size_t existing = findSlot(code);
+    if (existing != k_notFound) {
+      m_slots[existing].value = value;
+      return;
+    }
+
+    if ((m_size + 1) * 8 > m_slots.size() * 7) {
+      rehash(std::max<size_t>(m_slots.size() * 2, k_minCapacity));
+    }
+
+    place({code, value, 1});
+    m_size++;
+  }
+
+  /**
+   * Removes key, returns false if it wasn't in the map
+   */
+  bool erase(ChunkKey key) {
+    size_t slot = findSlot(Morton::encode(key));
+    if (slot == k_notFound) {
+      return false;
+    }
+
+    // Pull everything after it that isn't in its home slot back by one
+    size_t next = (slot + 1) & m_mask;
+    while (m_slots[next].dist > 1) {
+      m_slots[slot] = m_slots[next];
+      m_slots[slot].dist--;
+      slot = next;
+      next = (next + 1) & m_mask;
+    }
+
+    m_slots[slot].dist = 0;
+    m_size--;
+    return true;
+  }
+
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  void clear() {
+    m_slots.clear();
+    m_mask = 0;
+    m_size = 0;
+  }
+
+  /**
+   * Make room for count keys without growing again
+   */
+  void reserve(size_t count) {
+    size_t capacity = k_minCapacity;
+    while (count * 8 > capacity * 7) {
+      capacity *= 2;
+    }
+
+    if (capacity > m_slots.size()) {
+      rehash(capacity);
+    }
+  }
+
+  const_iterator begin() const {
+    return {m_slots.data(), m_slots.data() + m_slots.size()};
+  }
+  const_iterator end() const {
+    return {m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size()};
+  }
+
+  /**
+   * All the entries sorted by their Morton code, so neighbouring chunks are
+   * mostly next to each other
+   */
+  std::vector<Entry> spatialOrder() const {
+    std::vector<std::pair<uint64_t, Value>> codes;
+    codes.reserve(m_size);
+    for (const Slot &slot : m_slots) {
+      if (slot.dist != 0) {
+        codes.emplace_back(slot.code, slot.value);
+      }
+    }
+
+    std::sort(codes.begin(), codes.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    std::vector<Entry> entries;
+    entries.reserve(codes.size());
+    for (auto &[code, value] : codes) {
+      entries.push_back({Morton::decode(code), value});
+    }
+    return entries;
+  }
+
+private:
+  struct Slot {
+    uint64_t code;
+    Value value;
+    // How far the entry is from its home slot plus one, 0 is an empty slot
+    uint32_t dist;
+  };
+
+  static constexpr size_t k_minCapacity = 16;
+  static constexpr size_t k_notFound = ~size_t(0);
+
+  std::vector<Slot> m_slots;
+  size_t m_mask = 0;
+  size_t m_size = 0;
+
+  /**
+   * The Morton codes of neighbouring keys only differ in the low bits, so
+   * they get mixed up (the splitmix64 finaliser) before picking a slot
+   */
+  static uint64_t hash(uint64_t code) {
+    code ^= code >> 30;
+    code *= 0xBF58476D1CE4E5B9ull;
+    code ^= code >> 27;
+    code *= 0x94D049BB133111EBull;
+    code ^= code >> 31;
+    return code;
+  }
+
+  size_t findSlot(uint64_t code) const {
+    if (m_slots.empty()) {
+      return k_notFound;
+    }
+
+    size_t slot = hash(code) & m_mask;
+    // Once the entries get closer to home than we are the key can't be
+    // further along, this also stops at empty slots
+    for (uint32_t dist = 1; m_slots[slot].dist >= dist; dist++) {
+      if (m_slots[slot].code == code) {
+        return slot;
+      }
+      slot = (slot + 1) & m_mask;
+    }
+
+    return k_notFound;
+  }
+
+  /**
+   * Puts an entry that isn't in the table yet into it, there has to be room
+   */
+  void place(Slot entry) {
+    size_t slot = hash(entry.code) & m_mask;
+
+    while (m_slots[slot].dist != 0) {
+      if (m_slots[slot].dist < entry.dist) {
+        std::swap(m_slots[slot], entry);
+      }
+      slot = (slot + 1) & m_mask;
+      entry.dist++;
+    }
+
+    m_slots[slot] = entry;
+  }
+
+  void rehash(size_t capacity) {
+    std::vector<Slot> old = std::move(m_slots);
+    m_slots.assign(capacity, Slot{0, Value{}, 0});
+    m_mask = capacity - 1;
+
+    for (Slot &slot : old) {
+      if (slot.dist != 0) {
+        place({slot.code, slot.value, 1});
+      }
+    }
+  }
+};
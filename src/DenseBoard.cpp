@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "DenseBoard.h"
+#include "LifeKernel.h"
+#include "utils/WrappedPoint.h"
+
+namespace {
+
+// Checked before any of the members are made out of the sizes
+int32_t checkSize(LifeEngine::Topology topology, int32_t size) {
+  if (topology == LifeEngine::Topology::Unbounded) {
+    throw std::invalid_argument("A dense board needs a torus or cylinder.");
+  }
+  if (size <= 0) {
+    throw std::invalid_argument("A dense board has to be at least 1x1.");
+  }
+  return size;
+}
+
+uint64_t lowBits(int32_t count) {
+  return count < 64 ? (uint64_t(1) << count) - 1 : ~uint64_t(0);
+}
+
+} // namespace
+
+DenseBoard::DenseBoard(Topology topology, int32_t width, int32_t height)
+    : m_topology(topology), m_width(checkSize(topology, width)),
+      m_height(checkSize(topology, height)),
+      m_size{uint32_t(width), uint32_t(height)},
+      m_stride(BitArray::wordsFor(width)), m_lastBit((width - 1) % 64),
+      m_cells(m_stride * 64 * height), m_next(m_stride * 64 * height),
+      m_deadRow(m_stride, 0) {}
+
+void DenseBoard::setPoint(int32_t x, int32_t y, bool value) {
+  if (wrap(x, y)) {
+    m_cells.assign(y * m_stride * 64 + x, value);
+  }
+}
+
+bool DenseBoard::getPoint(int32_t x, int32_t y) {
+  return wrap(x, y) && m_cells.test(y * m_stride * 64 + x);
+}
+
+void DenseBoard::setRun(int32_t x, int32_t y, int32_t length, bool value) {
+  if (length <= 0 || !wrap(x, y)) {
+    return;
+  }
+
+  // Past the width of the board it only goes over the same cells again
+  length = std::min(length, m_width);
+  for (int32_t done = 0; done < length;) {
+    int32_t count = std::min(length - done, 64);
+    writeCells(x, y, count, value ? ~uint64_t(0) : 0, true);
+    x = static_cast<int32_t>((int64_t(x) + count) % m_width);
+    done += count;
+  }
+}
+
+void DenseBoard::setRowBits(int32_t x, int32_t y, const uint64_t *bits,
+                            int32_t width) {
+  if (!wrap(x, y)) {
+    return;
+  }
+
+  for (int32_t col = 0; col < width; col += 64) {
+    int32_t count = std::min(width - col, 64);
+    int32_t at = static_cast<int32_t>((int64_t(x) + col) % m_width);
+    writeCells(at, y, count, bits[col / 64] & lowBits(count), false);
+  }
+}
+
+void DenseBoard::setRegion(int32_t x, int32_t y, int32_t width,
+                           int32_t height, const uint64_t *bits) {
+  size_t stride = regionStride(width);
+  for (int32_t row = 0; row < height; row++) {
+    int32_t rx = x, ry = static_cast<int32_t>(int64_t(y) + row);
+    if (!wrap(rx, ry)) {
+      continue;
+    }
+
+    const uint64_t *rowBits = bits + row * stride;
+    for (int32_t col = 0; col < width; col += 64) {
+      int32_t count = std::min(width - col, 64);
+      int32_t at = static_cast<int32_t>((int64_t(rx) + col) % m_width);
+      writeCells(at, ry, count, rowBits[col / 64] & lowBits(count), true);
+    }
+  }
+}
+
+void DenseBoard::getRegion(int32_t x, int32_t y, int32_t width,
+                           int32_t height, uint64_t *bits) {
+  size_t stride = regionStride(width);
+  std::fill(bits, bits + height * stride, 0);
+
+  for (int32_t row = 0; row < height; row++) {
+    int32_t rx = x, ry = static_cast<int32_t>(int64_t(y) + row);
+    if (!wrap(rx, ry)) {
+      continue;
+    }
+
+    uint64_t *rowBits = bits + row * stride;
+    for (int32_t col = 0; col < width; col += 64) {
+      int32_t count = std::min(width - col, 64);
+      int32_t at = static_cast<int32_t>((int64_t(rx) + col) % m_width);
+      rowBits[col / 64] = readCells(at, ry, count);
+    }
+  }
+}
+
+std::optional<LifeEngine::Bounds> DenseBoard::getBounds() {
+  std::vector<uint64_t> columns(m_stride, 0);
+  int32_t minY = m_height, maxY = -1;
+  for (int32_t y = 0; y < m_height; y++) {
+    const uint64_t *row = rowOf(y);
+    uint64_t any = 0;
+    for (size_t w = 0; w < m_stride; w++) {
+      columns[w] |= row[w];
+      any |= row[w];
+    }
+    if (any) {
+      minY = std::min(minY, y);
+      maxY = y;
+    }
+  }
+  if (maxY < 0) {
+    return std::nullopt;
+  }
+
+  size_t first = 0, last = m_stride - 1;
+  while (!columns[first]) {
+    first++;
+  }
+  while (!columns[last]) {
+    last--;
+  }
+  return Bounds{int64_t(first * 64 + std::countr_zero(columns[first])), minY,
+                int64_t(last * 64 + 63 - std::countl_zero(columns[last])),
+                maxY};
+}
+
+void DenseBoard::setRule(const Rule &rule) {
+  if (rule.states != 2) {
+    throw std::invalid_argument("A dense board only has two states, not " +
+                                rule.toString());
+  }
+  m_rule = rule;
+}
+
+void DenseBoard::update() {
+  LifeKernel::withRule(m_rule, [this](auto next) {
+    m_pool->run([&](uint32_t thread, uint32_t threadCount) {
+      auto [begin, end] =
+          ThreadPool::partition(m_height, thread, threadCount);
+      stepRows(next, begin, end);
+    });
+  });
+
+  std::swap(m_cells, m_next);
+  m_generation++;
+}
+
+void DenseBoard::setThreadCount(uint32_t threads) {
+  if (threads == 0) {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  m_pool = std::make_unique<ThreadPool>(threads);
+}
+
+bool DenseBoard::wrap(int32_t &x, int32_t &y) const {
+  if (m_topology == Topology::Cylinder && (y < 0 || y >= m_height)) {
+    return false;
+  }
+
+  WrappedPoint wrapped({x, y}, m_size);
+  x = static_cast<int32_t>(wrapped.x());
+  y = static_cast<int32_t>(wrapped.y());
+  return true;
+}
+
+uint64_t DenseBoard::readCells(int32_t x, int32_t y, int32_t count) const {
+  const uint64_t *row = rowOf(y);
+  uint64_t cells = 0;
+
+  // In pieces that each stay inside one word and don't go past the edge
+  for (int32_t done = 0; done < count;) {
+    int32_t piece = std::min({count - done, m_width - x, 64 - x % 64});
+    cells |= (row[x / 64] >> (x % 64) & lowBits(piece)) << done;
+    done += piece;
+    x = x + piece == m_width ? 0 : x + piece;
+  }
+  return cells;
+}
+
+void DenseBoard::writeCells(int32_t x, int32_t y, int32_t count,
+                            uint64_t cells, bool replace) {
+  uint64_t *row = rowOf(y);
+
+  for (int32_t done = 0; done < count;) {
+    int32_t piece = std::min({count - done, m_width - x, 64 - x % 64});
+    uint64_t mask = lowBits(piece) << (x % 64);
+    uint64_t bits = (cells >> done) << (x % 64) & mask;
+    row[x / 64] = replace ? (row[x / 64] & ~mask) | bits : row[x / 64] | bits;
+    done += piece;
+    x = x + piece == m_width ? 0 : x + piece;
+  }
+}
+
+template <typename Kernel>
+void DenseBoard::stepRows(Kernel next, size_t begin, size_t end) {
+  const uint64_t *cells = m_cells.data();
+  uint64_t *nextCells = m_next.data();
+  size_t height = m_height;
+  bool torus = m_topology == Topology::Torus;
+
+  for (size_t strip = 0; strip < m_stride; strip += k_stripWords) {
+    size_t stripEnd = std::min(m_stride, strip + k_stripWords);
+    // The first and last word of a row get their outside neighbours from
+    // the other end of it, everything in between is plain shifts
+    size_t inner = std::max<size_t>(strip, 1);
+    size_t innerEnd = std::min(stripEnd, m_stride - 1);
+
+    for (size_t y = begin; y < end; y++) {
+      const uint64_t *curr = cells + y * m_stride;
+      const uint64_t *up, *down;
+      if (y + 1 < height) {
+        up = curr + m_stride;
+      } else {
+        up = torus ? cells : m_deadRow.data();
+      }
+      if (y > 0) {
+        down = curr - m_stride;
+      } else {
+        down = torus ? cells + (height - 1) * m_stride : m_deadRow.data();
+      }
+      uint64_t *out = nextCells + y * m_stride;
+
+      auto edgeWord = [&](size_t w) {
+        out[w] = next(west(up, w), up[w], east(up, w), west(curr, w), curr[w],
+                      east(curr, w), west(down, w), down[w], east(down, w));
+      };
+
+      if (strip == 0) {
+        edgeWord(0);
+      }
+      if (inner < innerEnd) {
+        // Each word is loaded once and passed along as the one to the left
+        // and then the middle one
+        uint64_t upLeft = up[inner - 1], upMid = up[inner];
+        uint64_t currLeft = curr[inner - 1], currMid = curr[inner];
+        uint64_t downLeft = down[inner - 1], downMid = down[inner];
+        for (size_t w = inner; w < innerEnd; w++) {
+          uint64_t upRight = up[w + 1], currRight = curr[w + 1],
+                   downRight = down[w + 1];
+          out[w] = next(upMid << 1 | upLeft >> 63, upMid,
+                        upMid >> 1 | upRight << 63,
+                        currMid << 1 | currLeft >> 63, currMid,
+                        currMid >> 1 | currRight << 63,
+                        downMid << 1 | downLeft >> 63, downMid,
+                        downMid >> 1 | downRight << 63);
+          upLeft = upMid;
+          upMid = upRight;
+          currLeft = currMid;
+          currMid = currRight;
+          downLeft = downMid;
+          downMid = downRight;
+        }
+      }
+      if (stripEnd == m_stride) {
+        if (m_stride > 1) {
+          edgeWord(m_stride - 1);
+        }
+        // Keep the bits past the edge dead
+        out[m_stride - 1] &= lowBits(m_lastBit + 1);
+      }
+    }
+  }
+}
+
+uint64_t DenseBoard::west(const uint64_t *row, size_t w) const {
+  // Left of the first cell is the last one
+  uint64_t carry = w > 0 ? row[w - 1] >> 63 : row[m_stride - 1] >> m_lastBit;
+  return row[w] << 1 | (carry & 1);
+}
+
+uint64_t DenseBoard::east(const uint64_t *row, size_t w) const {
+  // Right of the last cell is the first one, the bits past it are 0
+  uint64_t carry =
+      w + 1 < m_stride ? row[w + 1] << 63 : (row[0] & 1) << m_lastBit;
+  return row[w] >> 1 | carry;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "BitArray.h"
+#include "LifeEngine.h"
+#include "ThreadPool.h"
+
+/**
+ * A LifeEngine for bounded boards that are busy all over. The cells are one
+ * flat bitmap of rows of 64 bit words with none of the chunks and hashing of
+ * a GameBoard, and every update steps every row a word at a time with
+ * LifeKernel.
+ *
+ * A GameBoard skips whatever is empty or holding still and this doesn't, so
+ * it only comes out ahead when most of the board is doing something. Like a
+ * bounded GameBoard the bottom left corner is at (0, 0) and cells outside it
+ * wrap around onto it, or are dead above and below a cylinder where setting
+ * them does nothing.
+ */
+class DenseBoard : public LifeEngine {
+public:
+  /**
+   * Throws std::invalid_argument if topology is Unbounded or a size isn't
+   * positive.
+   */
+  DenseBoard(Topology topology, int32_t width, int32_t height);
+
+  void setPoint(int32_t x, int32_t y, bool value) override;
+  bool getPoint(int32_t x, int32_t y) override;
+  /**
+   * The row and region versions copy whole words in and out
+   */
+  void setRun(int32_t x, int32_t y, int32_t length, bool value) override;
+  void setRowBits(int32_t x, int32_t y, const uint64_t *bits,
+                  int32_t width) override;
+  void setRegion(int32_t x, int32_t y, int32_t width, int32_t height,
+                 const uint64_t *bits) override;
+  void getRegion(int32_t x, int32_t y, int32_t width, int32_t height,
+                 uint64_t *bits) override;
+  std::optional<Bounds> getBounds() override;
+
+  /**
+   * Throws std::invalid_argument for Generations rules, every cell is one
+   * bit
+   */
+  void setRule(const Rule &rule) override;
+  Rule getRule() const override { return m_rule; }
+
+  void update() override;
+  uint64_t getGeneration() const { return m_generation; }
+  uint64_t getPopulation() const { return m_cells.count(); }
+
+  Topology getTopology() const { return m_topology; }
+  int32_t getWidth() const { return m_width; }
+  int32_t getHeight() const { return m_height; }
+
+  /**
+   * Number of threads update() steps rows on, 0 uses one per hardware
+   * thread. Each one gets a band of rows of its own.
+   */
+  void setThreadCount(uint32_t threads);
+  uint32_t getThreadCount() const { return m_pool->size(); }
+
+private:
+  // Rows are stepped a strip of this many words at a time, so the three rows
+  // being read stay in the L1 cache even on very wide boards
+  static constexpr size_t k_stripWords = 512;
+
+  Topology m_topology;
+  int32_t m_width;
+  int32_t m_height;
+  // The same as m_width and m_height, for WrappedPoint
+  uint32_t m_size[2];
+  // Words in a row, the bits of the last one past m_lastBit are always 0
+  size_t m_stride;
+  int32_t m_lastBit;
+  BitArray m_cells;
+  BitArray m_next;
+  // What is above and below a cylinder
+  std::vector<uint64_t> m_deadRow;
+  Rule m_rule;
+  std::unique_ptr<ThreadPool> m_pool = std::make_unique<ThreadPool>(1);
+  uint64_t m_generation = 0;
+
+  uint64_t *rowOf(int32_t y) { return m_cells.data() + y * m_stride; }
+  const uint64_t *rowOf(int32_t y) const {
+    return m_cells.data() + y * m_stride;
+  }
+  /**
+   * Wraps a point around onto the board, false if it is above or below a
+   * cylinder
+   */
+  bool wrap(int32_t &x, int32_t &y) const;
+  /**
+   * count (up to 64) cells of row y going right from column x, wrapping
+   * around at the right edge. x and y have to be on the board.
+   */
+  uint64_t readCells(int32_t x, int32_t y, int32_t count) const;
+  /**
+   * Same the other way around, with replace the count cells are overwritten
+   * and otherwise only the ones set in cells get set
+   */
+  void writeCells(int32_t x, int32_t y, int32_t count, uint64_t cells,
+                  bool replace);
+
+  /**
+   * Puts rows [begin, end) of the next generation into m_next, next being
+   * the LifeKernel kernel for m_rule
+   */
+  template <typename Kernel>
+  void stepRows(Kernel next, size_t begin, size_t end);
+  /**
+   * The left and right neighbour of every cell of word w of a row in the
+   * cell's own bit, like the LifeKernel kernels want them
+   */
+  uint64_t west(const uint64_t *row, size_t w) const;
+  uint64_t east(const uint64_t *row, size_t w) const;
+};
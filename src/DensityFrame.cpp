@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "DensityFrame.h"
+
+void DensityFrame::reset(int64_t size, int32_t cellX, int32_t cellY,
+                         int32_t cellWidth, int32_t cellHeight) {
+  tileCells = size;
+  counts.clear();
+  if (cellWidth <= 0 || cellHeight <= 0) {
+    x = y = width = height = 0;
+    return;
+  }
+
+  x = static_cast<int32_t>(tileOf(cellX));
+  y = static_cast<int32_t>(tileOf(cellY));
+  width = static_cast<int32_t>(tileOf(int64_t(cellX) + cellWidth - 1) - x + 1);
+  height =
+      static_cast<int32_t>(tileOf(int64_t(cellY) + cellHeight - 1) - y + 1);
+  counts.assign(size_t(width) * height, 0);
+}
+
+void DensityFrame::writeHeatmap(std::ostream &out) const {
+  // Even a soup is only about a third alive, the square root spreads the
+  // usual densities over more of the ramp
+  static const std::string k_ramp = " .:-=+*#%@";
+  const auto steps = static_cast<double>(k_ramp.size() - 1);
+
+  std::string line(width, ' ');
+  for (int32_t row = height - 1; row >= 0; row--) {
+    for (int32_t col = 0; col < width; col++) {
+      size_t i = size_t(row) * width + col;
+      size_t step = 0;
+      if (counts[i] != 0) {
+        double scaled = std::ceil(std::sqrt(getDensity(i)) * steps);
+        step = std::max<size_t>(1, static_cast<size_t>(scaled));
+      }
+      line[col] = k_ramp[std::min<size_t>(step, k_ramp.size() - 1)];
+    }
+    out << line << '\n';
+  }
+}
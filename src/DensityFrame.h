@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/**
+ * Live cell counts of square tiles covering part of a board, for drawing it
+ * zoomed out to where a cell is much smaller than a pixel.
+ *
+ * Tile (tx, ty) covers the cells from (tx * tileCells, ty * tileCells) up to
+ * the next tile over, the frame holds the width x height tiles starting at
+ * tile (x, y).
+ */
+struct DensityFrame {
+  int64_t tileCells = 0;
+  int32_t x = 0;
+  int32_t y = 0;
+  int32_t width = 0;
+  int32_t height = 0;
+  // A row of tiles at a time from the bottom
+  std::vector<uint64_t> counts;
+
+  /**
+   * Empties the frame and sizes it for the tiles of size cells that cover
+   * the rectangle of cells
+   */
+  void reset(int64_t size, int32_t cellX, int32_t cellY, int32_t cellWidth,
+             int32_t cellHeight);
+
+  /**
+   * Tile a cell x or y is in
+   */
+  int64_t tileOf(int64_t cell) const {
+    return cell >= 0 ? cell / tileCells : (cell + 1) / tileCells - 1;
+  }
+
+  uint64_t getCount(int32_t tx, int32_t ty) const {
+    return counts[size_t(ty - y) * width + (tx - x)];
+  }
+  /**
+   * Part of the cells of tile i that are alive
+   */
+  double getDensity(size_t i) const {
+    return counts[i] / (double(tileCells) * double(tileCells));
+  }
+
+  /**
+   * Writes the frame as text, a character per tile going from ' ' for empty
+   * to '@' for full and a line per row of tiles starting at the top
+   */
+  void writeHeatmap(std::ostream &out) const;
+};
@@ -0,0 +1,105 @@
+#include <algorithm>
+
+#include "DensityPyramid.h"
+
+namespace {
+
+/**
+ * Key of the tile of level whose code is the Morton code of one of its chunks
+ * shifted right 2 bits a level. The sign flip Morton codes have went down
+ * with the rest of the bits so it is flipped back and sign extended.
+ */
+ChunkKey tileKey(uint64_t code, uint32_t level) {
+  auto unshift = [level](uint32_t v) {
+    uint32_t bits = (v ^ (Morton::k_signFlip >> level)) << level;
+    return static_cast<int32_t>(bits) >> level;
+  };
+  return {unshift(Morton::compact(code)), unshift(Morton::compact(code >> 1))};
+}
+
+} // namespace
+
+void DensityPyramid::apply(std::vector<Change> &changes) {
+  m_deltas.clear();
+  for (const Change &change : changes) {
+    if (change.delta != 0) {
+      m_deltas.push_back({Morton::encode(change.key), change.delta});
+    }
+  }
+  changes.clear();
+
+  sortByCode();
+
+  for (uint32_t level = 1; level <= k_levels && !m_deltas.empty(); level++) {
+    // Deltas for the same tile are put together, ones that cancel out are
+    // dropped since nothing above them changes either
+    size_t kept = 0;
+    for (size_t i = 0; i < m_deltas.size();) {
+      uint64_t code = m_deltas[i].code >> 2;
+      int64_t delta = 0;
+      for (; i < m_deltas.size() && m_deltas[i].code >> 2 == code; i++) {
+        delta += m_deltas[i].delta;
+      }
+      if (delta != 0) {
+        add(m_levels[level - 1], tileKey(code, level), delta);
+        m_deltas[kept++] = {code, delta};
+      }
+    }
+    m_deltas.erase(m_deltas.begin() + kept, m_deltas.end());
+  }
+}
+
+void DensityPyramid::sortByCode() {
+  if (m_deltas.size() < 2) {
+    return;
+  }
+
+  // A radix sort a byte at a time, going only over the bytes that aren't
+  // the same for every code. The changes of one update are usually close
+  // together on the board so most of the high bytes are.
+  uint64_t varying = 0;
+  for (const Delta &d : m_deltas) {
+    varying |= d.code ^ m_deltas[0].code;
+  }
+
+  m_sorted.resize(m_deltas.size());
+  for (uint32_t shift = 0; shift < 64 && varying >> shift; shift += 8) {
+    size_t starts[257] = {};
+    for (const Delta &d : m_deltas) {
+      starts[(d.code >> shift & 0xFF) + 1]++;
+    }
+    for (size_t b = 1; b < 257; b++) {
+      starts[b] += starts[b - 1];
+    }
+    for (const Delta &d : m_deltas) {
+      m_sorted[starts[d.code >> shift & 0xFF]++] = d;
+    }
+    std::swap(m_deltas, m_sorted);
+  }
+}
+
+uint64_t DensityPyramid::getPopulation() const {
+  uint64_t population = 0;
+  for (auto [key, count] : m_levels[k_levels - 1]) {
+    population += count;
+  }
+  return population;
+}
+
+void DensityPyramid::clear() {
+  for (ChunkMap<uint64_t> &level : m_levels) {
+    level.clear();
+  }
+  m_deltas.clear();
+  m_sorted.clear();
+}
+
+void DensityPyramid::add(ChunkMap<uint64_t> &level, ChunkKey tile,
+                         int64_t delta) {
+  uint64_t *count = level.find(tile);
+  if (!count) {
+    level.insert(tile, static_cast<uint64_t>(delta));
+  } else if ((*count += delta) == 0) {
+    level.erase(tile);
+  }
+}
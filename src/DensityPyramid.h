@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "ChunkKey.h"
+#include "ChunkMap.h"
+
+/**
+ * Live cell counts of a board at every zoom level above single chunks. A
+ * tile of level n adds up 2^n x 2^n chunks and its key is the key of any of
+ * those chunks shifted right by n. Empty tiles aren't stored. The counts of
+ * single chunks are left to whatever owns the chunks, it already has them
+ * by index and has to work out how much each one changed anyway.
+ *
+ * Changes only go up through the tiles above the chunks that changed, and
+ * changes that land in the same tile are added together first so the levels
+ * near the top only see a handful of them. They are sorted by Morton code
+ * once, which keeps the ones that share a tile together on every level.
+ */
+class DensityPyramid {
+public:
+  static constexpr uint32_t k_levels = 24;
+
+  struct Change {
+    ChunkKey key;
+    // Live cells the chunk gained, negative if it lost some
+    int64_t delta;
+  };
+
+  /**
+   * Adds the changes of a batch of chunks to every tile above them. Empties
+   * changes.
+   */
+  void apply(std::vector<Change> &changes);
+
+  /**
+   * Count of a tile of level 1 to k_levels
+   */
+  uint64_t get(uint32_t level, ChunkKey tile) const {
+    const uint64_t *count = m_levels[level - 1].find(tile);
+    return count ? *count : 0;
+  }
+  const ChunkMap<uint64_t> &getLevel(uint32_t level) const {
+    return m_levels[level - 1];
+  }
+  /**
+   * Live cells on the whole board
+   */
+  uint64_t getPopulation() const;
+
+  void clear();
+
+private:
+  struct Delta {
+    // Morton code of the tile, shifted right 2 bits a level so tiles that
+    // share a parent stay next to each other once sorted
+    uint64_t code;
+    int64_t delta;
+  };
+
+  std::vector<ChunkMap<uint64_t>> m_levels =
+      std::vector<ChunkMap<uint64_t>>(k_levels);
+  std::vector<Delta> m_deltas;
+  std::vector<Delta> m_sorted;
+
+  void sortByCode();
+  /**
+   * Adds delta to a tile, dropping it once it gets to 0
+   */
+  static void add(ChunkMap<uint64_t> &level, ChunkKey tile, int64_t delta);
+};
@@ -1,7 +1,14 @@
-#include <bitset>
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <iostream>
 #include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "Chunk.h"
 #include "GameBoard.h"
@@ -11,235 +18,1381 @@
 GameBoard method definitions
 */
 
-void GameBoard::setPoint(int32_t x, int32_t y, bool value) {
+template <typename ChunkT>
+BasicGameBoard<ChunkT>::BasicGameBoard(Topology topology, int32_t width,
+                                       int32_t height)
+    : m_topology(topology) {
+  if (topology == Topology::Unbounded) {
+    throw std::invalid_argument("A bounded board needs a torus or cylinder.");
+  }
+  if (width <= 0 || height <= 0 || width % ChunkT::k_size != 0 ||
+      height % ChunkT::k_size != 0) {
+    throw std::invalid_argument(
+        "A bounded board has to be a positive multiple of " +
+        std::to_string(ChunkT::k_size) + " cells each way.");
+  }
+
+  m_gridSize[0] = width / ChunkT::k_size;
+  m_gridSize[1] = height / ChunkT::k_size;
+  makeGrid();
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::setPoint(int32_t x, int32_t y, bool value) {
   ChunkKey key = calcChunkKey(x, y);
-  auto chunk = getOrMakeChunk(key);
+  uint32_t chunk = makeChunk(key);
+  // Off the top or bottom of a cylinder
+  if (chunk == ChunkT::k_noChunk) {
+    return;
+  }
 
-  int32_t properX, properY;
+  markEdited(chunk, m_arena[chunk].getFlags());
+  m_arena[chunk].setCell(calcChunkOffset(x), calcChunkOffset(y), value);
+}
 
-  if (x >= 0) {
-    properX = x % Chunk::k_size;
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::setRun(int32_t x, int32_t y, int32_t length,
+                                    bool value) {
+  int32_t chunkY = calcChunkOffset(y);
+
+  while (length > 0) {
+    int32_t chunkX = calcChunkOffset(x);
+    int32_t count = std::min(length, ChunkT::k_size - chunkX);
+    ChunkKey key = calcChunkKey(x, y);
+
+    // No point making a chunk just to clear cells in it
+    uint32_t chunk = value ? makeChunk(key) : getChunk(key);
+    if (chunk != ChunkT::k_noChunk) {
+      markEdited(chunk, m_arena[chunk].getFlags());
+      m_arena[chunk].setRow(chunkY, ChunkT::runBits(chunkX, count), value);
+    }
+
+    x += count;
+    length -= count;
+  }
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::setRowBits(int32_t x, int32_t y,
+                                       const uint64_t *bits, int32_t width) {
+  int32_t chunkY = calcChunkOffset(y);
+  // Going along the row the next chunk is the right neighbour of the last
+  // one, so the map only has to be used for the first one and new ones
+  uint32_t chunk = ChunkT::k_noChunk;
+
+  for (int32_t i = 0; i < width;) {
+    int32_t chunkX = calcChunkOffset(x + i);
+    int32_t count = std::min(width - i, ChunkT::k_size - chunkX);
+
+    typename ChunkT::RowType row =
+        ChunkT::fromColumns(readBits(bits, i, count) << chunkX);
+
+    if (row) {
+      if (chunk == ChunkT::k_noChunk) {
+        chunk = makeChunk(calcChunkKey(x + i, y));
+      }
+      // The whole row is off the top or bottom of a cylinder
+      if (chunk == ChunkT::k_noChunk) {
+        return;
+      }
+      markEdited(chunk, m_arena[chunk].getFlags());
+      m_arena[chunk].setRow(chunkY, row, true);
+    }
+
+    if (chunk != ChunkT::k_noChunk) {
+      chunk = m_arena[chunk].neighbours[Neighbour::RIGHT];
+    }
+    i += count;
+  }
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::setRegion(int32_t x, int32_t y, int32_t width,
+                                      int32_t height, const uint64_t *bits) {
+  size_t stride = regionStride(width);
+
+  // One band of chunks at a time, each chunk gets all its rows of the region
+  // at once
+  for (int32_t row = 0; row < height;) {
+    int32_t chunkY = calcChunkOffset(y + row);
+    int32_t rows = std::min(height - row, ChunkT::k_size - chunkY);
+    // Like setRowBits() the chunks are found by following the right
+    // neighbours, once one is known. That one not being there means the next
+    // chunk isn't either.
+    uint32_t chunk = ChunkT::k_noChunk;
+    bool known = false;
+
+    for (int32_t col = 0; col < width;) {
+      int32_t chunkX = calcChunkOffset(x + col);
+      int32_t count = std::min(width - col, ChunkT::k_size - chunkX);
+
+      std::array<typename ChunkT::RowType, ChunkT::k_size> next;
+      bool any = false;
+      for (int32_t r = 0; r < rows; r++) {
+        next[r] = ChunkT::fromColumns(
+            readBits(bits + (row + r) * stride, col, count) << chunkX);
+        any = any || next[r];
+      }
+
+      ChunkKey key = calcChunkKey(x + col, y + row);
+      if (!known) {
+        chunk = getChunk(key);
+      }
+      // Nothing to clear in a chunk that isn't there
+      if (chunk == ChunkT::k_noChunk && any) {
+        chunk = makeChunk(key);
+      }
+
+      if (chunk != ChunkT::k_noChunk) {
+        ChunkT &c = m_arena[chunk];
+        typename ChunkT::Flags before = c.getFlags();
+        typename ChunkT::RowType mask = ChunkT::runBits(chunkX, count);
+        bool changed = false;
+        for (int32_t r = 0; r < rows; r++) {
+          changed = c.replaceRow(chunkY + r, mask, next[r]) || changed;
+        }
+        if (changed) {
+          markEdited(chunk, before);
+        }
+
+        // A missing neighbour can still be waiting in the snapshot
+        chunk = c.neighbours[Neighbour::RIGHT];
+        known = chunk != ChunkT::k_noChunk || !m_snapshot;
+      } else {
+        known = false;
+      }
+
+      col += count;
+    }
+
+    row += rows;
+  }
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::getRegion(int32_t x, int32_t y, int32_t width,
+                                      int32_t height, uint64_t *bits) {
+  size_t stride = regionStride(width);
+  std::fill(bits, bits + height * stride, 0);
+
+  for (int32_t row = 0; row < height;) {
+    int32_t chunkY = calcChunkOffset(y + row);
+    int32_t rows = std::min(height - row, ChunkT::k_size - chunkY);
+    uint32_t chunk = ChunkT::k_noChunk;
+    bool known = false;
+
+    for (int32_t col = 0; col < width;) {
+      int32_t chunkX = calcChunkOffset(x + col);
+      int32_t count = std::min(width - col, ChunkT::k_size - chunkX);
+
+      if (!known) {
+        chunk = getChunk(calcChunkKey(x + col, y + row));
+      }
+
+      if (chunk != ChunkT::k_noChunk) {
+        const ChunkT &c = m_arena[chunk];
+        for (int32_t r = 0; r < rows; r++) {
+          uint64_t word = ChunkT::toColumns(c.getRow(chunkY + r)) >> chunkX;
+          writeBits(bits + (row + r) * stride, col, count, word);
+        }
+
+        // A missing neighbour can still be waiting in the snapshot
+        chunk = c.neighbours[Neighbour::RIGHT];
+        known = chunk != ChunkT::k_noChunk || !m_snapshot;
+      } else {
+        known = false;
+      }
+
+      col += count;
+    }
+
+    row += rows;
+  }
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::collectChunks(int32_t x, int32_t y,
+                                          int32_t width, int32_t height,
+                                          ChunkFrame &frame) {
+  frame.reset(ChunkT::k_size);
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+  faultInAll();
+
+  ChunkKey first = calcChunkKey(x, y);
+  ChunkKey last = calcChunkKey(static_cast<int32_t>(int64_t(x) + width - 1),
+                               static_cast<int32_t>(int64_t(y) + height - 1));
+  if (isBounded()) {
+    first = {std::max(first.x, 0), std::max(first.y, 0)};
+    last = {std::min(last.x, int32_t(m_gridSize[0]) - 1),
+            std::min(last.y, int32_t(m_gridSize[1]) - 1)};
+    if (first.x > last.x || first.y > last.y) {
+      return;
+    }
+  }
+
+  auto add = [&](ChunkKey key, uint32_t index) {
+    const ChunkT &chunk = m_arena[index];
+    bool any = false;
+    for (int32_t r = 0; r < ChunkT::k_size && !any; r++) {
+      any = chunk.getRow(r) != 0;
+    }
+    if (!any) {
+      return;
+    }
+
+    uint32_t *rows = frame.add(key, m_chunkVersion[index]);
+    for (int32_t r = 0; r < ChunkT::k_size; r++) {
+      uint64_t row = ChunkT::toColumns(chunk.getRow(r));
+      for (int32_t w = 0; w < frame.rowWords; w++) {
+        rows[r * frame.rowWords + w] = static_cast<uint32_t>(row >> (w * 32));
+      }
+    }
+  };
+
+  // Looking up every key in the rectangle is quicker unless it is mostly
+  // empty space
+  int64_t keys =
+      (int64_t(last.x) - first.x + 1) * (int64_t(last.y) - first.y + 1);
+  if (keys <= static_cast<int64_t>(m_chunks.size())) {
+    for (int32_t ky = first.y; ky <= last.y; ky++) {
+      for (int32_t kx = first.x; kx <= last.x; kx++) {
+        uint32_t index = findChunk({kx, ky});
+        if (index != ChunkT::k_noChunk) {
+          add({kx, ky}, index);
+        }
+      }
+    }
   } else {
-    properX = (Chunk::k_size - 1) + ((x + 1) % Chunk::k_size);
+    for (auto [key, index] : m_chunks) {
+      if (key.x >= first.x && key.x <= last.x && key.y >= first.y &&
+          key.y <= last.y) {
+        add(key, index);
+      }
+    }
   }
+}
 
-  if (y >= 0) {
-    properY = y % Chunk::k_size;
-    // properY = (Chunk::Size - 1) - ((y) % Chunk::Size);
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::collectDensity(int32_t x, int32_t y,
+                                           int32_t width, int32_t height,
+                                           int64_t tileCells,
+                                           DensityFrame &frame) {
+  if (!m_density) {
+    faultInAll();
+    m_density = std::make_unique<DensityPyramid>();
+    for (auto [key, index] : m_chunks) {
+      countChunk(index);
+    }
+    m_densityEdited = false;
+  }
+  syncDensity();
+
+  uint32_t level = 0;
+  while (level < DensityPyramid::k_levels &&
+         (int64_t(ChunkT::k_size) << level) < tileCells) {
+    level++;
+  }
+  frame.reset(int64_t(ChunkT::k_size) << level, x, y, width, height);
+
+  // Level 0 is the chunks themselves, ones made since the counts last
+  // changed are empty
+  auto countOf = [this](uint32_t index) -> uint64_t {
+    return index < m_chunkCount.size() ? m_chunkCount[index] : 0;
+  };
+  auto get = [&](ChunkKey tile) -> uint64_t {
+    if (level > 0) {
+      return m_density->get(level, tile);
+    }
+    uint32_t index = isOnGrid(tile) ? findChunk(tile) : ChunkT::k_noChunk;
+    return index == ChunkT::k_noChunk ? 0 : countOf(index);
+  };
+
+  // Same as collectChunks(), looking every tile up is quicker unless most of
+  // them are empty
+  size_t stored = level > 0 ? m_density->getLevel(level).size()
+                            : m_chunks.size();
+  if (frame.counts.size() <= stored) {
+    for (int32_t ty = 0; ty < frame.height; ty++) {
+      for (int32_t tx = 0; tx < frame.width; tx++) {
+        frame.counts[size_t(ty) * frame.width + tx] =
+            get({frame.x + tx, frame.y + ty});
+      }
+    }
+    return;
+  }
+
+  auto addTile = [&](ChunkKey key, uint64_t count) {
+    int64_t tx = int64_t(key.x) - frame.x;
+    int64_t ty = int64_t(key.y) - frame.y;
+    if (tx >= 0 && tx < frame.width && ty >= 0 && ty < frame.height) {
+      frame.counts[ty * frame.width + tx] = count;
+    }
+  };
+  if (level > 0) {
+    for (auto [key, count] : m_density->getLevel(level)) {
+      addTile(key, count);
+    }
   } else {
-    // properY = -((y + 1) % Chunk::Size);
-    properY = (Chunk::k_size - 1) + ((y + 1) % Chunk::k_size);
+    for (auto [key, index] : m_chunks) {
+      addTile(key, countOf(index));
+    }
+  }
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::setCells(std::span<const Cell> cells,
+                                     bool value) {
+  // Sorted by chunk so every chunk is only looked up once
+  std::vector<std::pair<uint64_t, uint32_t>> order = sortByChunk(cells);
+
+  for (size_t i = 0; i < order.size();) {
+    uint64_t code = order[i].first;
+    ChunkKey key = Morton::decode(code);
+    uint32_t chunk = value ? makeChunk(key) : getChunk(key);
+    if (chunk != ChunkT::k_noChunk) {
+      markEdited(chunk, m_arena[chunk].getFlags());
+    }
+
+    for (; i < order.size() && order[i].first == code; i++) {
+      if (chunk != ChunkT::k_noChunk) {
+        Cell c = cells[order[i].second];
+        m_arena[chunk].setCell(calcChunkOffset(c.x), calcChunkOffset(c.y),
+                               value);
+      }
+    }
   }
+}
 
-  chunk->setCell(properX, properY, value);
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::getCells(std::span<const Cell> cells,
+                                     uint64_t *alive) {
+  std::fill(alive, alive + (cells.size() + 63) / 64, 0);
+  std::vector<std::pair<uint64_t, uint32_t>> order = sortByChunk(cells);
+
+  for (size_t i = 0; i < order.size();) {
+    uint64_t code = order[i].first;
+    uint32_t chunk = getChunk(Morton::decode(code));
+
+    for (; i < order.size() && order[i].first == code; i++) {
+      uint32_t index = order[i].second;
+      Cell c = cells[index];
+      if (chunk != ChunkT::k_noChunk &&
+          m_arena[chunk].getCell(calcChunkOffset(c.x), calcChunkOffset(c.y))) {
+        alive[index / 64] |= uint64_t(1) << (index % 64);
+      }
+    }
+  }
 }
 
-bool GameBoard::getPoint(int32_t x, int32_t y) {
+template <typename ChunkT>
+std::optional<LifeEngine::Bounds> BasicGameBoard<ChunkT>::getBounds() {
+  using RowType = typename ChunkT::RowType;
+  std::optional<Bounds> bounds;
+
+  auto addChunk = [&bounds](ChunkKey key, const RowType *rows) {
+    RowType columns = 0;
+    int32_t minY = ChunkT::k_size, maxY = -1;
+    for (int32_t y = 0; y < ChunkT::k_size; y++) {
+      RowType row = rows[y] & ChunkT::k_dataBits;
+      if (row) {
+        columns |= row;
+        minY = std::min(minY, y);
+        maxY = y;
+      }
+    }
+    if (!columns) {
+      return;
+    }
+
+    // The leftmost column is in the highest bit
+    int64_t x = int64_t(key.x) * ChunkT::k_size;
+    int64_t y = int64_t(key.y) * ChunkT::k_size;
+    Bounds chunkBounds{
+        x + ChunkT::cellColumn(ChunkT::k_rowBits - 1 -
+                               std::countl_zero(columns)),
+        y + minY, x + ChunkT::cellColumn(std::countr_zero(columns)),
+        y + maxY};
+
+    if (!bounds) {
+      bounds = chunkBounds;
+    } else {
+      bounds->minX = std::min(bounds->minX, chunkBounds.minX);
+      bounds->minY = std::min(bounds->minY, chunkBounds.minY);
+      bounds->maxX = std::max(bounds->maxX, chunkBounds.maxX);
+      bounds->maxY = std::max(bounds->maxY, chunkBounds.maxY);
+    }
+  };
+
+  std::array<RowType, ChunkT::k_size> rows;
+  for (auto [key, index] : m_chunks) {
+    for (int32_t y = 0; y < ChunkT::k_size; y++) {
+      rows[y] = m_arena[index].getRow(y);
+    }
+    addChunk(key, rows.data());
+  }
+  // Lazy chunks are read straight out of the file without making them
+  for (auto [key, index] : m_lazyChunks) {
+    addChunk(key, static_cast<const RowType *>(m_snapshot->rows(index)));
+  }
+
+  return bounds;
+}
+
+template <typename ChunkT>
+bool BasicGameBoard<ChunkT>::getPoint(int32_t x, int32_t y) {
   ChunkKey key = calcChunkKey(x, y);
-  auto chunk = getChunk(key);
+  uint32_t chunk = getChunk(key);
 
-  if (chunk) {
-    return chunk->getCell(x % Chunk::k_size, y % Chunk::k_size);
+  if (chunk != ChunkT::k_noChunk) {
+    return m_arena[chunk].getCell(calcChunkOffset(x), calcChunkOffset(y));
   }
 
   return false;
 }
 
-void GameBoard::update() {
+template <typename ChunkT>
+uint32_t BasicGameBoard<ChunkT>::getState(int32_t x, int32_t y) {
+  if constexpr (ChunkT::k_maxStates > 2) {
+    uint32_t chunk = getChunk(calcChunkKey(x, y));
+    if (chunk == ChunkT::k_noChunk) {
+      return 0;
+    }
+    return m_arena[chunk].getState(calcChunkOffset(x), calcChunkOffset(y));
+  } else {
+    return getPoint(x, y);
+  }
+}
 
-  // Check chunks for deletion
-  for (auto it = m_chunks.begin(); it != m_chunks.end();) {
-    Chunk::Flags flags = it->second->getFlags();
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::setState(int32_t x, int32_t y, uint32_t state) {
+  if (state >= m_rule.states) {
+    throw std::invalid_argument("State " + std::to_string(state) +
+                                " isn't one of " + m_rule.toString());
+  }
 
-    // Check that the chunk is empty and all borders are empty
-    if ((flags & (Chunk::Flags::EMPTY | Chunk::Flags::ALL_BORDERS_EMPTY)) ==
-        (Chunk::Flags::EMPTY | Chunk::Flags::ALL_BORDERS_EMPTY)) {
-      deleteChunkBorders(it->second);
-      it = m_chunks.erase(it);
-    } else {
-      it++;
+  if constexpr (ChunkT::k_maxStates > 2) {
+    ChunkKey key = calcChunkKey(x, y);
+    // Like setRun() no chunk is made just to clear a cell
+    uint32_t chunk = state != 0 ? makeChunk(key) : getChunk(key);
+    if (chunk == ChunkT::k_noChunk) {
+      return;
+    }
+
+    markEdited(chunk, m_arena[chunk].getFlags());
+    m_arena[chunk].setState(calcChunkOffset(x), calcChunkOffset(y), state);
+  } else {
+    setPoint(x, y, state == 1);
+  }
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::setRule(const Rule &rule) {
+  if (rule.states > ChunkT::k_maxStates) {
+    throw std::invalid_argument(
+        rule.toString() + " has more states than the " +
+        std::to_string(ChunkT::k_maxStates) + " the board can hold");
+  }
+  if (m_log && rule.states > 2) {
+    throw std::invalid_argument("The delta log only has live cells, " +
+                                rule.toString() + " has dying ones too");
+  }
+
+  faultInAll();
+  m_rule = rule;
+
+  // Chunks that were holding still or blinking could do anything now, the
+  // edited flags have them and everything around them stepped instead of
+  // replayed or skipped. Empty ones with empty borders stay that way under
+  // any rule without B0.
+  for (uint32_t index = 0; index < m_arena.capacity(); index++) {
+    if (!m_arena.isLive(index)) {
+      continue;
+    }
+    ChunkT &chunk = m_arena[index];
+    if constexpr (ChunkT::k_maxStates > 2) {
+      chunk.limitStates(rule.states);
+    }
+    typename ChunkT::Flags before = chunk.getFlags();
+    if (static_cast<uint32_t>(before & ChunkT::Flags::EMPTY)) {
+      continue;
+    }
+
+    chunk.markEdited();
+    if (!static_cast<uint32_t>(before & ChunkT::Flags::CHANGED)) {
+      m_changed.push_back(index);
+    }
+    if (!static_cast<uint32_t>(before & ChunkT::Flags::OFF_PERIOD)) {
+      m_offPeriod.push_back(index);
+    }
+  }
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::update() {
+  uint64_t mark = m_profiler.begin(m_generation + 1, m_pool->size());
+  faultInAll();
+  // Cells set since the last update go in with the generation they were set
+  // in
+  logEdits();
+  syncDensity();
+  m_generation++;
+  mark = m_profiler.lap(UpdatePhase::PREPARE, mark);
+
+  if (++m_activeStamp == 0) {
+    // Wrapped around, old marks could match again
+    std::fill(m_activeMark.begin(), m_activeMark.end(), 0);
+    m_activeStamp = 1;
+  }
+  m_nextActive.clear();
+  m_nextParked.clear();
+
+  // A chunk can only come out different from what it is now if it or the
+  // part of a neighbour next to it changed, and it can only come out
+  // different from the last generation if it or a neighbour broke period 2.
+  // This is worked out before deleting anything since a chunk that just
+  // emptied out can still change its neighbours.
+  auto spread = [this](const std::vector<uint32_t> &from, bool offPeriod,
+                       std::vector<uint32_t> &to) {
+    for (uint32_t index : from) {
+      if (!m_arena.isLive(index)) {
+        continue;
+      }
+
+      // Neighbours only see the edge of the chunk, if nothing changed along
+      // the side next to them they don't have to be looked at because of it
+      const ChunkT &chunk = m_arena[index];
+      uint8_t edges =
+          offPeriod ? chunk.getOffPeriodEdges() : chunk.getChangedEdges();
+      activate(index, to);
+      for (uint32_t n = 0; n < Neighbour::COUNT; n++) {
+        if ((edges >> n & 1) && chunk.neighbours[n] != ChunkT::k_noChunk) {
+          activate(chunk.neighbours[n], to);
+        }
+      }
+    }
+  };
+  // Stepping wins so it goes first
+  spread(m_offPeriod, true, m_nextActive);
+  spread(m_changed, false, m_nextParked);
+  mark = m_profiler.lap(UpdatePhase::SPREAD, mark);
+
+  // The flags of chunks that weren't looked at in the last update haven't
+  // changed since they were last checked here. Parked chunks never have
+  // Flags::ALL_BORDERS_EMPTY so they don't get deleted.
+  auto forEachCandidate = [this](auto &&f) {
+    for (const auto *list : {&m_active, &m_parked, &m_offPeriod}) {
+      for (uint32_t index : *list) {
+        if (m_arena.isLive(index)) {
+          f(index, m_arena[index].getFlags());
+        }
+      }
+    }
+  };
+
+  // A bounded board has all of its chunks from the start, only unbounded
+  // ones make and delete them
+  if (!isBounded()) {
+    // The neighbours of a deleted chunk get looked at again next update,
+    // they may have been waiting on it
+    auto sweep = [this](uint32_t index) {
+      queueEmptyCheck(index);
+      deleteChunk(index);
+      m_profiler.add(UpdateCounter::DELETED);
+    };
+
+    // Check chunks for deletion
+    forEachCandidate([&](uint32_t index, typename ChunkT::Flags flags) {
+      // Check that the chunk is empty and all borders are empty
+      if ((flags &
+           (ChunkT::Flags::EMPTY | ChunkT::Flags::ALL_BORDERS_EMPTY)) ==
+          (ChunkT::Flags::EMPTY | ChunkT::Flags::ALL_BORDERS_EMPTY)) {
+        sweep(index);
+      }
+    });
+
+    // Flags::ALL_BORDERS_EMPTY is only worked out when a chunk is stepped,
+    // and an empty chunk stops getting stepped once nothing changes next to
+    // it. So the ones that came out empty and the ones around them are
+    // looked at here with the flags the neighbours have now.
+    m_emptyChecking.swap(m_emptyCheck);
+    m_emptyCheck.clear();
+    for (uint32_t index : m_emptyChecking) {
+      if (m_arena.isLive(index) && canDelete(index)) {
+        sweep(index);
+      }
+    }
+
+    // Drop what was deleted before the slots get used again by new chunks
+    auto dropDeleted = [this](std::vector<uint32_t> &list) {
+      list.erase(std::remove_if(list.begin(), list.end(),
+                                [this](uint32_t index) {
+                                  if (m_arena.isLive(index)) {
+                                    return false;
+                                  }
+                                  m_activeMark[index] = 0;
+                                  return true;
+                                }),
+                 list.end());
+    };
+    dropDeleted(m_nextActive);
+    dropDeleted(m_nextParked);
+    mark = m_profiler.lap(UpdatePhase::SWEEP, mark);
+
+    // Check if chunks need to be created, they are gathered up first so the
+    // new ones don't get looked at in the same pass
+    std::vector<uint32_t> needBorders;
+    forEachCandidate([&](uint32_t index, typename ChunkT::Flags flags) {
+      // Check that the chunk is not empty and has missing border chunks
+      if ((flags &
+           (ChunkT::Flags::EMPTY | ChunkT::Flags::MISSING_BORDER_CHUNK)) ==
+          ChunkT::Flags::MISSING_BORDER_CHUNK) {
+        needBorders.push_back(index);
+      }
+    });
+
+    size_t chunksBefore = m_arena.size();
+    for (uint32_t index : needBorders) {
+      makeBorderChunks(index);
+    }
+    m_profiler.add(UpdateCounter::CREATED, m_arena.size() - chunksBefore);
+    mark = m_profiler.lap(UpdatePhase::BORDER_CHUNKS, mark);
+  }
+
+  // New chunks are empty so they don't change anything around them, they
+  // still get stepped once to work out their flags
+  for (uint32_t index : m_fresh) {
+    if (m_arena.isLive(index)) {
+      activate(index, m_nextActive);
+      if (m_log && !isBounded()) {
+        m_log->addCreated(m_arena.key(index));
+      }
+    }
+  }
+
+  m_changed.clear();
+  m_offPeriod.clear();
+  m_fresh.clear();
+  std::swap(m_active, m_nextActive);
+  std::swap(m_parked, m_nextParked);
+  if (isBounded()) {
+    // In index order stepping is one sweep through the grid
+    sortByIndex(m_active);
+    sortByIndex(m_parked);
+  }
+
+  // Nothing gets made or deleted from here on so pointers into m_arena stay
+  // good until the end of the update
+  m_stepList.clear();
+  for (uint32_t index : m_active) {
+    m_stepList.push_back(&m_arena[index]);
+  }
+  m_replayList.clear();
+  for (uint32_t index : m_parked) {
+    m_replayList.push_back(&m_arena[index]);
+  }
+  m_steppedChunks += m_stepList.size();
+  m_replayedChunks += m_replayList.size();
+  m_profiler.set(UpdateCounter::STEPPED, m_stepList.size());
+  m_profiler.set(UpdateCounter::REPLAYED, m_replayList.size());
+  mark = m_profiler.lap(UpdatePhase::SPREAD, mark);
+
+  m_pool->run([this, mark](uint32_t thread, uint32_t threadCount) {
+    auto [begin, end] =
+        ThreadPool::partition(m_stepList.size(), thread, threadCount);
+    const ChunkT *chunks = m_arena.data();
+
+    // Setup the border for all chunks
+    for (size_t i = begin; i < end; i++) {
+      m_stepList[i]->readInBorder(chunks);
+    }
+
+    // Every border has to be read before any chunk changes its rows
+    m_pool->sync();
+    uint64_t threadMark =
+        m_profiler.threadLap(thread, UpdatePhase::READ_BORDERS, mark);
+
+    // Process the chunks
+    m_steppers[thread].step(m_stepList.data() + begin, end - begin, m_rule);
+    threadMark = m_profiler.threadLap(thread, UpdatePhase::STEP, threadMark);
+
+    auto [replayBegin, replayEnd] =
+        ThreadPool::partition(m_replayList.size(), thread, threadCount);
+    for (size_t i = replayBegin; i < replayEnd; i++) {
+      m_replayList[i]->replayPrevious();
+    }
+    m_profiler.threadLap(thread, UpdatePhase::REPLAY, threadMark);
+  });
+  mark = m_profiler.now();
+
+  for (const auto *list : {&m_active, &m_parked}) {
+    for (uint32_t index : *list) {
+      typename ChunkT::Flags flags = m_arena[index].getFlags();
+      if (static_cast<uint32_t>(flags & ChunkT::Flags::CHANGED)) {
+        m_changed.push_back(index);
+      }
+      if (static_cast<uint32_t>(flags & ChunkT::Flags::OFF_PERIOD)) {
+        m_offPeriod.push_back(index);
+      }
+      if (static_cast<uint32_t>(flags & ChunkT::Flags::EMPTY)) {
+        m_profiler.add(UpdateCounter::EMPTY);
+        if (!isBounded()) {
+          queueEmptyCheck(index);
+        }
+      }
+    }
+  }
+
+  m_version++;
+  for (uint32_t index : m_changed) {
+    setVersion(index, m_version);
+  }
+  if (m_density) {
+    for (uint32_t index : m_changed) {
+      countChunk(index);
+    }
+    m_density->apply(m_densityChanges);
+  }
+
+  if (m_log) {
+    for (uint32_t index : m_changed) {
+      logRows(index);
+    }
+    m_log->writeRecord(m_generation);
+  }
+  m_profiler.lap(UpdatePhase::FINISH, mark);
+
+  if constexpr (UpdateProfiler::k_enabled) {
+    // Goes over every chunk, which only a profiled build pays for. It isn't
+    // in any of the phases.
+    uint64_t population = 0;
+    for (uint32_t index = 0; index < m_arena.capacity(); index++) {
+      if (m_arena.isLive(index)) {
+        for (int32_t y = 0; y < ChunkT::k_size; y++) {
+          population += std::popcount(m_arena[index].getRow(y));
+        }
+      }
+    }
+    m_profiler.set(UpdateCounter::POPULATION, population);
+  }
+  m_profiler.set(UpdateCounter::CHUNKS, m_arena.size());
+  m_profiler.end();
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::saveSnapshot(const std::string &path) {
+  if (m_rule.states > 2) {
+    throw std::invalid_argument("Snapshots only have live cells, " +
+                                m_rule.toString() + " has dying ones too");
+  }
+
+  // Also lets go of the mapping in case path is the file it is of
+  faultInAll();
+
+  std::vector<ChunkKey> keys;
+  std::vector<uint32_t> indices;
+  for (auto [key, index] : m_chunks.spatialOrder()) {
+    const ChunkT &chunk = m_arena[index];
+    bool any = false;
+    for (int32_t y = 0; y < ChunkT::k_size && !any; y++) {
+      any = chunk.getRow(y) != 0;
+    }
+    if (any) {
+      keys.push_back(key);
+      indices.push_back(index);
+    }
+  }
+
+  Snapshot::Writer writer(path, ChunkT::k_size,
+                          sizeof(typename ChunkT::RowType), m_generation,
+                          keys);
+  std::array<typename ChunkT::RowType, ChunkT::k_size> rows;
+  for (uint32_t index : indices) {
+    for (int32_t y = 0; y < ChunkT::k_size; y++) {
+      rows[y] = m_arena[index].getRow(y);
+    }
+    writer.writeRows(rows.data());
+  }
+  writer.finish();
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::loadSnapshot(const std::string &path,
+                                          bool lazy) {
+  auto view = std::make_unique<Snapshot::View>(path, lazy);
+  const Snapshot::Header &header = view->header();
+  if (header.chunkSize != ChunkT::k_size ||
+      header.rowBytes != sizeof(typename ChunkT::RowType)) {
+    throw std::runtime_error(
+        path + " was saved with " + std::to_string(header.chunkSize) +
+        " cell chunks of " + std::to_string(header.rowBytes) +
+        " byte rows, the board has " + std::to_string(ChunkT::k_size) +
+        " cell chunks of " +
+        std::to_string(sizeof(typename ChunkT::RowType)) + " byte rows");
+  }
+
+  clear();
+  m_generation = header.generation;
+
+  if (lazy && !isBounded()) {
+    m_lazyChunks.reserve(view->size());
+    for (size_t i = 0; i < view->size(); i++) {
+      m_lazyChunks.insert(view->key(i), static_cast<uint32_t>(i));
+    }
+    if (!m_lazyChunks.empty()) {
+      m_snapshot = std::move(view);
+    }
+    return;
+  }
+
+  m_arena.reserve(view->size());
+  m_chunks.reserve(view->size());
+  for (size_t i = 0; i < view->size(); i++) {
+    uint32_t chunk = makeChunk(view->key(i));
+    if (chunk == ChunkT::k_noChunk) {
+      continue;
     }
+    markEdited(chunk, m_arena[chunk].getFlags());
+    m_arena[chunk].loadRows(
+        static_cast<const typename ChunkT::RowType *>(view->rows(i)));
+  }
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::startDeltaLog(const std::string &path) {
+  if (m_rule.states > 2) {
+    throw std::invalid_argument("Delta logs only have live cells, " +
+                                m_rule.toString() + " has dying ones too");
+  }
+
+  stopDeltaLog();
+  m_log = std::make_unique<DeltaLog::Writer>(
+      path, ChunkT::k_size, sizeof(typename ChunkT::RowType), m_generation);
+}
+
+template <typename ChunkT> void BasicGameBoard<ChunkT>::stopDeltaLog() {
+  if (m_log) {
+    logEdits();
+    m_log.reset();
+  }
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::replayDeltaLog(const std::string &path,
+                                            uint64_t generation) {
+  DeltaLog::Reader reader(path);
+  const DeltaLog::Header &header = reader.header();
+  if (header.chunkSize != ChunkT::k_size ||
+      header.rowBytes != sizeof(typename ChunkT::RowType)) {
+    throw std::runtime_error(path + " was saved with a different chunk size");
+  }
+  if (header.baseGeneration != m_generation) {
+    throw std::runtime_error(path + " starts at generation " +
+                             std::to_string(header.baseGeneration) +
+                             ", the board is at " +
+                             std::to_string(m_generation));
+  }
+
+  faultInAll();
+  DeltaLog::Record record;
+  while (reader.next(record) && record.generation <= generation) {
+    // Same order as update() does them in
+    for (ChunkKey key : record.deleted) {
+      uint32_t chunk = isBounded() ? ChunkT::k_noChunk : findChunk(key);
+      if (chunk != ChunkT::k_noChunk) {
+        deleteChunk(chunk);
+      }
+    }
+    for (ChunkKey key : record.created) {
+      makeChunk(key);
+    }
+    for (size_t i = 0; i < record.changed.size(); i++) {
+      uint32_t chunk = makeChunk(record.changed[i]);
+      if (chunk == ChunkT::k_noChunk) {
+        continue;
+      }
+      markEdited(chunk, m_arena[chunk].getFlags());
+      m_arena[chunk].loadRows(
+          static_cast<const typename ChunkT::RowType *>(record.rowsOf(i)));
+    }
+    m_generation = record.generation;
+  }
+
+  if (m_generation != generation) {
+    throw std::out_of_range(path + " ends at generation " +
+                            std::to_string(m_generation) + ", before " +
+                            std::to_string(generation));
+  }
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::setSimdLevel(SimdLevel level) {
+  for (auto &stepper : m_steppers) {
+    stepper.setSimdLevel(level);
+  }
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::setThreadCount(uint32_t threads) {
+  if (threads == 0) {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  SimdLevel level = getSimdLevel();
+  m_pool = std::make_unique<ThreadPool>(threads);
+  m_steppers.resize(threads);
+  setSimdLevel(level);
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::deleteChunk(uint32_t index) {
+  ChunkT &c = m_arena[index];
+
+  // The border flags of the neighbours were worked out before they were last
+  // processed so they can't be trusted to know about this chunk going away
+  for (uint32_t n = 0; n < Neighbour::COUNT; n++) {
+    uint32_t other = c.neighbours[n];
+    if (other == ChunkT::k_noChunk) {
+      continue;
+    }
+
+    ChunkT &o = m_arena[other];
+    o.neighbours[Neighbour::opposite(static_cast<Neighbour::Index>(n))] =
+        ChunkT::k_noChunk;
+    o.addFlags(ChunkT::Flags::MISSING_BORDER_CHUNK);
+  }
+
+  if (m_log) {
+    m_log->addDeleted(m_arena.key(index));
+  }
+  // Only empty chunks get deleted, but the count has to be 0 for whatever
+  // gets the index next
+  if (index < m_chunkCount.size() && m_chunkCount[index] != 0) {
+    m_densityChanges.push_back(
+        {m_arena.key(index), -int64_t(m_chunkCount[index])});
+    m_chunkCount[index] = 0;
+  }
+  m_chunks.erase(m_arena.key(index));
+  m_arena.release(index);
+}
+
+template <typename ChunkT>
+int32_t BasicGameBoard<ChunkT>::calcChunkOffset(int32_t v) {
+  if (v >= 0) {
+    return v % ChunkT::k_size;
   }
+  return (ChunkT::k_size - 1) + ((v + 1) % ChunkT::k_size);
+}
 
-  // Check if chunks need to be created
-  for (auto &chunkPair : m_chunks) {
-    Chunk::Flags flags = chunkPair.second->getFlags();
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::queueEmptyCheck(uint32_t index) {
+  m_emptyCheck.push_back(index);
+  for (uint32_t n : m_arena[index].neighbours) {
+    if (n != ChunkT::k_noChunk) {
+      m_emptyCheck.push_back(n);
+    }
+  }
+}
 
-    // Check that the chunk is not empty and has missing border chunks
-    if ((flags & (Chunk::Flags::EMPTY | Chunk::Flags::MISSING_BORDER_CHUNK)) ==
-        Chunk::Flags::MISSING_BORDER_CHUNK) {
-      makeBorderChunks(chunkPair.first, chunkPair.second);
+template <typename ChunkT>
+bool BasicGameBoard<ChunkT>::canDelete(uint32_t index) {
+  auto isEmpty = [this](uint32_t i) {
+    return static_cast<uint32_t>(m_arena[i].getFlags() &
+                                 ChunkT::Flags::EMPTY) != 0;
+  };
+  if (!isEmpty(index)) {
+    return false;
+  }
+  for (uint32_t n : m_arena[index].neighbours) {
+    if (n != ChunkT::k_noChunk && !isEmpty(n)) {
+      return false;
     }
   }
+  return true;
+}
 
-  // Setup the border for all chunks
-  for (auto &chunkPair : m_chunks) {
-    chunkPair.second->readInBorder();
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::markEdited(uint32_t chunk,
+                                       typename ChunkT::Flags before) {
+  // The flags being set means it is in the list already
+  if (!static_cast<uint32_t>(before & ChunkT::Flags::CHANGED)) {
+    m_changed.push_back(chunk);
+  }
+  if (!static_cast<uint32_t>(before & ChunkT::Flags::OFF_PERIOD)) {
+    m_offPeriod.push_back(chunk);
+  }
+  setVersion(chunk, ++m_version);
+  m_densityEdited = true;
+
+  if (m_log) {
+    if (chunk >= m_logMark.size()) {
+      m_logMark.resize(m_arena.capacity(), 0);
+    }
+    if (m_logMark[chunk] != m_logStamp) {
+      m_logMark[chunk] = m_logStamp;
+      m_logEdited.push_back(chunk);
+    }
   }
+}
 
-  // Process the chunks
-  for (auto &chunkPair : m_chunks) {
-    chunkPair.second->processNextState();
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::setVersion(uint32_t chunk, uint64_t version) {
+  if (chunk >= m_chunkVersion.size()) {
+    m_chunkVersion.resize(m_arena.capacity(), 0);
   }
+  m_chunkVersion[chunk] = version;
 }
 
-void GameBoard::deleteChunkBorders(std::shared_ptr<Chunk> c) {
-  if (!c)
+template <typename ChunkT> void BasicGameBoard<ChunkT>::syncDensity() {
+  if (!m_density) {
     return;
+  }
 
-  if (c->upLeft)
-    c->upLeft->downRight = nullptr;
+  if (m_densityEdited) {
+    for (uint32_t index : m_changed) {
+      if (m_arena.isLive(index)) {
+        countChunk(index);
+      }
+    }
+    m_densityEdited = false;
+  }
+  m_density->apply(m_densityChanges);
+}
 
-  if (c->up)
-    c->up->down = nullptr;
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::countChunk(uint32_t chunk) {
+  if (chunk >= m_chunkCount.size()) {
+    m_chunkCount.resize(m_arena.capacity(), 0);
+  }
 
-  if (c->upRight)
-    c->upRight->downLeft = nullptr;
+  const ChunkT &c = m_arena[chunk];
+  uint32_t count = 0;
+  for (int32_t y = 0; y < ChunkT::k_size; y++) {
+    count += std::popcount(c.getRow(y));
+  }
+  if (count != m_chunkCount[chunk]) {
+    m_densityChanges.push_back(
+        {m_arena.key(chunk), int64_t(count) - m_chunkCount[chunk]});
+    m_chunkCount[chunk] = count;
+  }
+}
 
-  if (c->left)
-    c->left->right = nullptr;
+template <typename ChunkT> void BasicGameBoard<ChunkT>::logEdits() {
+  if (!m_log || m_logEdited.empty()) {
+    return;
+  }
 
-  if (c->right)
-    c->right->left = nullptr;
+  for (uint32_t chunk : m_logEdited) {
+    logRows(chunk);
+  }
+  m_log->writeRecord(m_generation);
+  m_logEdited.clear();
 
-  if (c->downLeft)
-    c->downLeft->upRight = nullptr;
+  if (++m_logStamp == 0) {
+    std::fill(m_logMark.begin(), m_logMark.end(), 0);
+    m_logStamp = 1;
+  }
+}
 
-  if (c->down)
-    c->down->up = nullptr;
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::logRows(uint32_t chunk) {
+  std::array<typename ChunkT::RowType, ChunkT::k_size> rows;
+  for (int32_t y = 0; y < ChunkT::k_size; y++) {
+    rows[y] = m_arena[chunk].getRow(y);
+  }
+  m_log->addRows(m_arena.key(chunk), rows.data());
+}
 
-  if (c->downRight)
-    c->downRight->upLeft = nullptr;
+template <typename ChunkT>
+uint64_t BasicGameBoard<ChunkT>::readBits(const uint64_t *bits, int32_t first,
+                                          int32_t count) {
+  int32_t shift = first % 64;
+  uint64_t word = bits[first / 64] >> shift;
+  // They can go over into the next word
+  if (shift + count > 64) {
+    word |= bits[first / 64 + 1] << (64 - shift);
+  }
+  if (count < 64) {
+    word &= (uint64_t(1) << count) - 1;
+  }
+  return word;
 }
 
-ChunkKey GameBoard::calcChunkKey(int32_t x, int32_t y) {
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::writeBits(uint64_t *bits, int32_t first,
+                                       int32_t count, uint64_t word) {
+  if (count < 64) {
+    word &= (uint64_t(1) << count) - 1;
+  }
+
+  int32_t shift = first % 64;
+  bits[first / 64] |= word << shift;
+  if (shift + count > 64) {
+    bits[first / 64 + 1] |= word >> (64 - shift);
+  }
+}
+
+template <typename ChunkT>
+std::vector<std::pair<uint64_t, uint32_t>>
+BasicGameBoard<ChunkT>::sortByChunk(std::span<const Cell> cells) {
+  std::vector<std::pair<uint64_t, uint32_t>> order(cells.size());
+  for (size_t i = 0; i < cells.size(); i++) {
+    order[i] = {Morton::encode(calcChunkKey(cells[i].x, cells[i].y)),
+                static_cast<uint32_t>(i)};
+  }
+  std::sort(order.begin(), order.end());
+  return order;
+}
+
+template <typename ChunkT>
+ChunkKey BasicGameBoard<ChunkT>::calcChunkKey(int32_t x, int32_t y) {
   int32_t realChunkX, realChunkY;
 
   if (x >= 0) {
-    realChunkX = x / Chunk::k_size;
+    realChunkX = x / ChunkT::k_size;
   } else {
-    realChunkX = -1 + ((x + 1) / Chunk::k_size);
+    realChunkX = -1 + ((x + 1) / ChunkT::k_size);
   }
 
   if (y >= 0) {
-    realChunkY = y / Chunk::k_size;
+    realChunkY = y / ChunkT::k_size;
   } else {
-    realChunkY = -1 + ((y + 1) / Chunk::k_size);
+    realChunkY = -1 + ((y + 1) / ChunkT::k_size);
   }
 
   return {realChunkX, realChunkY};
 }
 
-std::shared_ptr<Chunk> GameBoard::getChunk(ChunkKey key) {
-  auto chunk_entry = m_chunks.find(key);
-  if (chunk_entry == m_chunks.end()) {
-    return nullptr;
+template <typename ChunkT>
+uint32_t BasicGameBoard<ChunkT>::getChunk(ChunkKey key) {
+  uint32_t index = findChunk(key);
+  if (index == ChunkT::k_noChunk && m_snapshot) {
+    return faultIn(key);
   }
 
-  return chunk_entry->second;
+  return index;
 }
 
-void GameBoard::makeChunk(ChunkKey key) {
-  std::shared_ptr<Chunk> chunk = getChunk(key);
-
-  if (chunk) {
-    return;
+template <typename ChunkT>
+uint32_t BasicGameBoard<ChunkT>::findChunk(ChunkKey key) {
+  if (isBounded()) {
+    return gridChunk(key);
   }
 
-  chunk = std::make_shared<Chunk>();
-  m_chunks[key] = chunk;
-
-  // Get all border chunks into the references
-  chunk->upLeft = getChunk({key.x - 1, key.y + 1});
-  chunk->up = getChunk({key.x, key.y + 1});
-  chunk->upRight = getChunk({key.x + 1, key.y + 1});
-  chunk->left = getChunk({key.x - 1, key.y});
-  chunk->right = getChunk({key.x + 1, key.y});
-  chunk->downLeft = getChunk({key.x - 1, key.y - 1});
-  chunk->down = getChunk({key.x, key.y - 1});
-  chunk->downRight = getChunk({key.x + 1, key.y - 1});
+  const uint32_t *index = m_chunks.find(key);
+  if (!index) {
+    return ChunkT::k_noChunk;
+  }
 
-  // For each border chunk reference this chunk in it
-  if (chunk->upLeft)
-    chunk->upLeft->downRight = chunk;
+  return *index;
+}
 
-  if (chunk->up)
-    chunk->up->down = chunk;
+template <typename ChunkT>
+uint32_t BasicGameBoard<ChunkT>::faultIn(ChunkKey key) {
+  const uint32_t *lazy = m_lazyChunks.find(key);
+  if (!lazy) {
+    return ChunkT::k_noChunk;
+  }
 
-  if (chunk->upRight)
-    chunk->upRight->downLeft = chunk;
+  // Taken out first so makeChunk() doesn't come back here for it
+  uint32_t snapshotIndex = *lazy;
+  m_lazyChunks.erase(key);
 
-  if (chunk->left)
-    chunk->left->right = chunk;
+  uint32_t chunk = makeChunk(key);
+  markEdited(chunk, m_arena[chunk].getFlags());
+  m_arena[chunk].loadRows(static_cast<const typename ChunkT::RowType *>(
+      m_snapshot->rows(snapshotIndex)));
 
-  if (chunk->right)
-    chunk->right->left = chunk;
+  if (m_lazyChunks.empty()) {
+    m_snapshot.reset();
+  }
+  return chunk;
+}
 
-  if (chunk->downLeft)
-    chunk->downLeft->upRight = chunk;
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::faultInAll() {
+  if (!m_snapshot) {
+    return;
+  }
 
-  if (chunk->down)
-    chunk->down->up = chunk;
+  m_arena.reserve(m_arena.size() + m_lazyChunks.size());
+  for (auto [key, index] : m_lazyChunks.spatialOrder()) {
+    faultIn(key);
+  }
+}
 
-  if (chunk->downRight)
-    chunk->downRight->upLeft = chunk;
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::clear() {
+  m_arena.clear();
+  m_chunks.clear();
+  m_changed.clear();
+  m_offPeriod.clear();
+  m_fresh.clear();
+  m_emptyCheck.clear();
+  m_active.clear();
+  m_parked.clear();
+  m_nextActive.clear();
+  m_nextParked.clear();
+  m_activeMark.clear();
+  m_activeStamp = 0;
+  m_generation = 0;
+  m_chunkVersion.clear();
+  m_density.reset();
+  m_chunkCount.clear();
+  m_densityChanges.clear();
+  m_densityEdited = false;
+  m_snapshot.reset();
+  m_lazyChunks.clear();
+  // The log can't follow the board onto a whole new one
+  m_log.reset();
+  m_logEdited.clear();
+  m_logMark.clear();
+  m_logStamp = 1;
+
+  if (isBounded()) {
+    makeGrid();
+  }
 }
 
-void GameBoard::makeBorderChunks(ChunkKey key, std::shared_ptr<Chunk> c) {
-  if (!c->upLeft) {
-    makeChunk({key.x - 1, key.y + 1});
+template <typename ChunkT> void BasicGameBoard<ChunkT>::makeGrid() {
+  uint32_t width = m_gridSize[0], height = m_gridSize[1];
+  size_t count = size_t(width) * height;
+  m_arena.reserve(count);
+  m_chunks.reserve(count);
+
+  // Made in index order, the arena is empty so it hands out 0, 1, 2...
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width; x++) {
+      ChunkKey key{int32_t(x), int32_t(y)};
+      uint32_t index = m_arena.allocate(key);
+      m_chunks.insert(key, index);
+      m_fresh.push_back(index);
+      setVersion(index, ++m_version);
+    }
   }
 
-  if (!c->up) {
-    makeChunk({key.x, key.y + 1});
+  for (uint32_t index = 0; index < count; index++) {
+    ChunkKey key = m_arena.key(index);
+    for (uint32_t n = 0; n < Neighbour::COUNT; n++) {
+      auto [dx, dy] = Neighbour::k_offsets[n];
+      m_arena[index].neighbours[n] = gridChunk({key.x + dx, key.y + dy});
+    }
   }
 
-  if (!c->upRight) {
-    makeChunk({key.x + 1, key.y + 1});
+  // None of the lists can have a chunk twice, so with room for every chunk
+  // update() never has to allocate
+  for (auto *list : {&m_changed, &m_offPeriod, &m_active, &m_parked,
+                     &m_nextActive, &m_nextParked}) {
+    list->reserve(count);
   }
+  m_stepList.reserve(count);
+  m_replayList.reserve(count);
+  m_activeMark.resize(count, 0);
+  m_gridMark.assign((count + 63) / 64, 0);
+}
 
-  if (!c->left) {
-    makeChunk({key.x - 1, key.y});
+template <typename ChunkT>
+uint32_t BasicGameBoard<ChunkT>::gridChunk(ChunkKey key) const {
+  if (m_topology == Topology::Cylinder &&
+      (key.y < 0 || key.y >= int32_t(m_gridSize[1]))) {
+    return ChunkT::k_noChunk;
   }
 
-  if (!c->right) {
-    makeChunk({key.x + 1, key.y});
+  WrappedPoint wrapped({key.x, key.y}, m_gridSize);
+  return wrapped.y() * m_gridSize[0] + wrapped.x();
+}
+
+template <typename ChunkT>
+bool BasicGameBoard<ChunkT>::isOnGrid(ChunkKey key) const {
+  return !isBounded() ||
+         (key.x >= 0 && key.x < int32_t(m_gridSize[0]) && key.y >= 0 &&
+          key.y < int32_t(m_gridSize[1]));
+}
+
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::sortByIndex(std::vector<uint32_t> &list) {
+  for (uint32_t index : list) {
+    m_gridMark[index / 64] |= uint64_t(1) << (index % 64);
   }
 
-  if (!c->downLeft) {
-    makeChunk({key.x - 1, key.y - 1});
+  list.clear();
+  for (size_t word = 0; word < m_gridMark.size(); word++) {
+    for (uint64_t bits = m_gridMark[word]; bits; bits &= bits - 1) {
+      list.push_back(uint32_t(word * 64 + std::countr_zero(bits)));
+    }
+    m_gridMark[word] = 0;
   }
+}
+
+template <typename ChunkT>
+uint32_t BasicGameBoard<ChunkT>::makeChunk(ChunkKey key) {
+  uint32_t index = getChunk(key);
 
-  if (!c->down) {
-    makeChunk({key.x, key.y - 1});
+  if (index != ChunkT::k_noChunk || isBounded()) {
+    return index;
   }
 
-  if (!c->downRight) {
-    makeChunk({key.x + 1, key.y - 1});
+  index = m_arena.allocate(key);
+  m_chunks.insert(key, index);
+  m_fresh.push_back(index);
+  setVersion(index, ++m_version);
+  ChunkT &chunk = m_arena[index];
+
+  // Link up with all the border chunks there are in both directions
+  for (uint32_t n = 0; n < Neighbour::COUNT; n++) {
+    auto [dx, dy] = Neighbour::k_offsets[n];
+    // Lazy chunks get linked up once they are made
+    uint32_t other = findChunk({key.x + dx, key.y + dy});
+    chunk.neighbours[n] = other;
+
+    if (other != ChunkT::k_noChunk) {
+      m_arena[other]
+          .neighbours[Neighbour::opposite(static_cast<Neighbour::Index>(n))] =
+          index;
+    }
   }
+
+  return index;
 }
 
-std::shared_ptr<Chunk> GameBoard::getOrMakeChunk(ChunkKey key) {
-  std::shared_ptr<Chunk> chunk = getChunk(key);
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::makeBorderChunks(uint32_t index) {
+  ChunkKey key = m_arena.key(index);
 
-  if (chunk) {
-    return chunk;
+  // m_arena[index] is looked up again every time since makeChunk() can move
+  // it
+  for (uint32_t n = 0; n < Neighbour::COUNT; n++) {
+    if (m_arena[index].neighbours[n] == ChunkT::k_noChunk) {
+      auto [dx, dy] = Neighbour::k_offsets[n];
+      makeChunk({key.x + dx, key.y + dy});
+    }
   }
+}
 
-  makeChunk(key);
+template <typename ChunkT>
+void BasicGameBoard<ChunkT>::activate(uint32_t index,
+                                      std::vector<uint32_t> &list) {
+  if (index >= m_activeMark.size()) {
+    m_activeMark.resize(m_arena.capacity(), 0);
+  }
 
-  return m_chunks[key];
+  if (m_activeMark[index] != m_activeStamp) {
+    m_activeMark[index] = m_activeStamp;
+    list.push_back(index);
+  }
 }
 
-std::ostream &operator<<(std::ostream &o, GameBoard &g) {
+template <typename ChunkT>
+std::ostream &operator<<(std::ostream &o, BasicGameBoard<ChunkT> &g) {
   int32_t maxX = std::numeric_limits<int32_t>::min();
   int32_t minX = std::numeric_limits<int32_t>::max();
   int32_t maxY = std::numeric_limits<int32_t>::min();
   int32_t minY = std::numeric_limits<int32_t>::max();
 
-  // Setup the border for all chunks
-  for (auto &chunkPair : g.m_chunks) {
-    ChunkKey k = chunkPair.first;
+  g.faultInAll();
+  for (auto entry : g.m_chunks) {
+    ChunkKey k = entry.key;
 
     // Update the boundaries of the GameBoard
     maxX = std::max(k.x, maxX);
@@ -249,44 +1402,63 @@ std::ostream &operator<<(std::ostream &o, GameBoard &g) {
   }
 
 #if PRINT_GB
-  Chunk defaultEmpty;
   o << std::endl;
   Console::Screen::clear();
   Console::Cursor::setPosition(0, 0);
 
+  // The whole picture is put together first and written out in one go, chunk
+  // by chunk the terminal takes longer than the board did to update
+  constexpr int32_t size = ChunkT::k_size;
+  std::string out;
+  ChunkT defaultEmpty;
+
 #if VISUALIZE == VISUALIZE_BORDERS
+  // Chunks draw their own border, going back up to the top of the chunk after
+  // each one lines them up next to each other
+  const std::string nextChunk = "\033[" + std::to_string(size + 2) + "A\033[" +
+                                std::to_string(size + 3) + "C";
+  const std::string nextRow = "\033[" + std::to_string(size + 2) + "B\n";
   for (int32_t y = maxY; y >= minY; y--) {
     for (int32_t x = minX; x <= maxX; x++) {
-      if (g.m_chunks.find({x, y}) != g.m_chunks.end()) {
-        o << *g.m_chunks.at({x, y}) << std::flush;
+      uint32_t index = g.findChunk({x, y});
+      std::ostringstream chunk;
+      if (index != ChunkT::k_noChunk) {
+        // Make sure that the border is read in before rendering it out
+        ChunkT &c = g.m_arena[index];
+        c.readInBorder(g.m_arena.data());
+        chunk << c;
       } else {
-        o << defaultEmpty << std::flush;
+        chunk << defaultEmpty;
       }
-      Console::Cursor::up(Chunk::k_size + 2);
-      Console::Cursor::forward(Chunk::k_size + 3);
+      out += chunk.str();
+      out += nextChunk;
     }
-    Console::Cursor::down(Chunk::k_size + 2);
-    std::cout << std::endl;
+    out += nextRow;
   }
 #endif
 
 #if VISUALIZE == VISUALIZE_DEFAULT
+  std::vector<uint32_t> chunkRow;
   for (int32_t y = maxY; y >= minY; y--) {
+    chunkRow.clear();
     for (int32_t x = minX; x <= maxX; x++) {
-      if (g.m_chunks.find({x, y}) != g.m_chunks.end()) {
-        o << *g.m_chunks.at({x, y}) << std::flush;
-      } else {
-        o << defaultEmpty << std::flush;
+      chunkRow.push_back(g.findChunk({x, y}));
+    }
+
+    for (int32_t cy = size - 1; cy >= 0; cy--) {
+      for (uint32_t index : chunkRow) {
+        ChunkT &c =
+            index != ChunkT::k_noChunk ? g.m_arena[index] : defaultEmpty;
+        for (int32_t cx = 0; cx < size; cx++) {
+          out += c.getCell(cx, cy) ? ALIVE_CELL : DEAD_CELL;
+        }
       }
-      Console::Cursor::up(Chunk::k_size);
-      Console::Cursor::forward(Chunk::k_size);
+      out += '\n';
     }
-    Console::Cursor::down(Chunk::k_size - 1);
-    std::cout << std::endl;
   }
-
 #endif
 
+  o << out;
 #endif
 
   o << std::endl;
@@ -298,39 +1470,55 @@ std::ostream &operator<<(std::ostream &o, GameBoard &g) {
   return o;
 }
 
-std::ostream &operator<<(std::ostream &o, Chunk &c) {
+template <typename RowT, int32_t Size>
+std::ostream &operator<<(std::ostream &o, BasicChunk<RowT, Size> &c) {
+  using ChunkT = BasicChunk<RowT, Size>;
+
+  // Each row goes back under the start of the one before it, so the chunk
+  // can be drawn anywhere on the screen. It is all sent in one go.
+  std::string out;
 #if VISUALIZE == VISUALIZE_BORDERS
-  // Make sure that the border is read in before rendering it out
-  c.readInBorder();
-
-  for (int32_t y = Chunk::k_topBorder; y >= 0; y--) {
-    std::bitset<Chunk::k_size + 2> row(c.m_data[y]);
-    for (int x = Chunk::k_size + 1; x >= 0; x--) {
-      if (row[x]) {
-        o << ALIVE_CELL;
-      } else {
-        o << DEAD_CELL;
-      }
+  // The border has to be read in already, the chunk can't do it on its own
+  // without the rest of the board
+  const std::string nextRow =
+      "\033[1B\033[" + std::to_string(ChunkT::k_size + 2) + "D";
+  for (int32_t y = ChunkT::k_size; y >= -1; y--) {
+    for (int x = -1; x <= ChunkT::k_size; x++) {
+      out += c.getWithBorder(x, y) ? ALIVE_CELL : DEAD_CELL;
     }
-    Console::Cursor::down(1);
-    Console::Cursor::backward(Chunk::k_size + 2);
+    out += nextRow;
   }
 #endif
 
 #if VISUALIZE == VISUALIZE_DEFAULT
-  for (int32_t y = Chunk::k_size; y > 0; y--) {
-    std::bitset<Chunk::k_size> row((c.m_data[y] & Chunk::k_dataBits) >> 1);
-    for (int x = Chunk::k_size - 1; x >= 0; x--) {
-      if (row[x]) {
-        o << ALIVE_CELL;
-      } else {
-        o << DEAD_CELL;
-      }
+  const std::string nextRow =
+      "\033[1B\033[" + std::to_string(ChunkT::k_size) + "D";
+  for (int32_t y = ChunkT::k_size - 1; y >= 0; y--) {
+    for (int x = 0; x < ChunkT::k_size; x++) {
+      out += c.getCell(x, y) ? ALIVE_CELL : DEAD_CELL;
     }
-    Console::Cursor::down(1);
-    Console::Cursor::backward(Chunk::k_size);
+    out += nextRow;
   }
 #endif
 
+  o << out;
   return o;
 }
+
+template class BasicGameBoard<Chunk8>;
+template class BasicGameBoard<Chunk30>;
+template class BasicGameBoard<Chunk62>;
+template class BasicGameBoard<Chunk64>;
+template class BasicGameBoard<GenerationsChunk>;
+
+template std::ostream &operator<<(std::ostream &o, BasicGameBoard<Chunk8> &g);
+template std::ostream &operator<<(std::ostream &o, BasicGameBoard<Chunk30> &g);
+template std::ostream &operator<<(std::ostream &o, BasicGameBoard<Chunk62> &g);
+template std::ostream &operator<<(std::ostream &o, BasicGameBoard<Chunk64> &g);
+template std::ostream &operator<<(std::ostream &o,
+                                  BasicGameBoard<GenerationsChunk> &g);
+
+template std::ostream &operator<<(std::ostream &o, Chunk8 &c);
+template std::ostream &operator<<(std::ostream &o, Chunk30 &c);
+template std::ostream &operator<<(std::ostream &o, Chunk62 &c);
+template std::ostream &operator<<(std::ostream &o, Chunk64 &c);
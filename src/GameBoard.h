@@ -1,10 +1,26 @@
 ﻿#pragma once
-#include <array>
 #include <cstdint>
-#include <functional>
 #include <iostream>
 #include <memory>
-#include <unordered_map>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BatchStepper.h"
+#include "Chunk.h"
+#include "ChunkArena.h"
+#include "ChunkKey.h"
+#include "ChunkMap.h"
+#include "DensityPyramid.h"
+#include "LifeEngine.h"
+#include "ThreadPool.h"
+#include "UpdateProfiler.h"
+#include "io/DeltaLog.h"
+#include "io/Snapshot.h"
+#include "simd/CpuFeatures.h"
+#include "utils/WrappedPoint.h"
 
 #define VISUALIZE_BORDERS 0
 #define VISUALIZE_DEFAULT 1
@@ -25,61 +41,379 @@
 
 #endif
 
-struct ChunkKey {
-  ChunkKey(int32_t x, int32_t y) : x(x), y(y) {}
-  ChunkKey(std::array<int32_t, 2> p) : x(p[0]), y(p[1]) {}
+/**
+ * Main gameboard structure for working with chunks and controlling the system.
+ *
+ * The chunk layout is picked at compile time, GameBoard uses the one selected
+ * by CHUNK_SIZE in Chunk.h.
+ */
+template <typename ChunkT> class BasicGameBoard : public LifeEngine {
+public:
+  using ChunkType = ChunkT;
 
-  int32_t x;
-  int32_t y;
+  BasicGameBoard() = default;
+  /**
+   * A bounded board of width x height cells with its bottom left corner at
+   * (0, 0). Every chunk of it is made up front and linked up with the ones
+   * across the edges it wraps over, so updates never make or delete chunks
+   * or look anything up and go through the grid in order.
+   *
+   * Cells outside it wrap around onto it, or are dead above and below a
+   * cylinder, where setting them does nothing.
+   *
+   * Throws std::invalid_argument if topology is Unbounded or the sizes
+   * aren't positive multiples of the chunk size.
+   */
+  BasicGameBoard(Topology topology, int32_t width, int32_t height);
 
-  bool operator==(ChunkKey &key) {
-    return this->x == key.x && this->y == key.y;
-  }
-  bool operator==(const ChunkKey &key) const {
-    return this->x == key.x && this->y == key.y;
-  }
-};
+  Topology getTopology() const { return m_topology; }
 
-class ChunkKeyHash {
-public:
-  std::size_t operator()(const ChunkKey &c) const {
-    auto h1 = std::hash<int32_t>{}(c.x);
-    auto h2 = std::hash<int32_t>{}(c.y);
+  void setPoint(int32_t x, int32_t y, bool value) override;
+  bool getPoint(int32_t x, int32_t y) override;
+  /**
+   * These set the cells a chunk row at a time instead of one by one
+   */
+  void setRun(int32_t x, int32_t y, int32_t length, bool value) override;
+  void setRowBits(int32_t x, int32_t y, const uint64_t *bits,
+                  int32_t width) override;
 
-    return (53 + h1) * 53 + h2;
-  }
-};
+  /**
+   * The region and cell list versions look up each chunk once and do all of
+   * its cells together
+   */
+  void setRegion(int32_t x, int32_t y, int32_t width, int32_t height,
+                 const uint64_t *bits) override;
+  void getRegion(int32_t x, int32_t y, int32_t width, int32_t height,
+                 uint64_t *bits) override;
+  void setCells(std::span<const Cell> cells, bool value) override;
+  void getCells(std::span<const Cell> cells, uint64_t *alive) override;
+  std::optional<Bounds> getBounds() override;
+  /**
+   * Hands over the chunks as they are, with versions that go up whenever a
+   * chunk is made, set or changes in an update. A bounded board is only
+   * handed over once, not the copies of it that it wraps around to.
+   */
+  void collectChunks(int32_t x, int32_t y, int32_t width, int32_t height,
+                     ChunkFrame &frame) override;
+  /**
+   * Reads the tiles out of a DensityPyramid, so it costs about the same for
+   * any number of chunks. Tiles are the chunk size times a power of two. The
+   * counts are only worked out the first time this is called and kept up to
+   * date by update() from then on.
+   */
+  void collectDensity(int32_t x, int32_t y, int32_t width, int32_t height,
+                      int64_t tileCells, DensityFrame &frame) override;
 
-class Chunk;
+  /**
+   * Every chunk with something in it gets stepped on the next update, even
+   * the ones that were holding still under the old rule. Dying cells past
+   * the last state of the new rule are dead.
+   *
+   * Throws std::invalid_argument if the rule has more states than the chunks
+   * can hold, only a GenerationsBoard has more than two, or if it has more
+   * than two while a delta log is going.
+   */
+  void setRule(const Rule &rule) override;
+  Rule getRule() const override { return m_rule; }
 
-/**
- * Main gameboard structure for working with chunks and controlling the system.
- */
-class GameBoard {
-public:
-  void setPoint(int32_t x, int32_t y, bool value);
-  bool getPoint(int32_t x, int32_t y);
+  /**
+   * State of a cell under a Generations rule, 0 for dead, 1 for alive and 2
+   * up for dying. The rest of the LifeEngine calls only see the live cells.
+   *
+   * setState() throws std::invalid_argument if state isn't below the states
+   * of the rule.
+   */
+  uint32_t getState(int32_t x, int32_t y);
+  void setState(int32_t x, int32_t y, uint32_t state);
 
-  void update();
+  void update() override;
+  /**
+   * Number of updates since the board was made or since the generation of
+   * the snapshot it was loaded from
+   */
+  uint64_t getGeneration() const { return m_generation; }
+  /**
+   * Chunks update() has stepped and played back since the board was made,
+   * for seeing how much work a pattern is
+   */
+  uint64_t getSteppedChunks() const { return m_steppedChunks; }
+  uint64_t getReplayedChunks() const { return m_replayedChunks; }
+  /**
+   * Chunks the board has right now, empty ones included
+   */
+  size_t getChunkCount() const { return m_arena.size(); }
+  /**
+   * Times and counts of every update() so far, only kept in builds with
+   * GAME_OF_LIFE_PROFILE. Tools can poll it from another thread while the
+   * board is updating.
+   */
+  const UpdateProfiler &getProfiler() const { return m_profiler; }
+  UpdateProfiler &getProfiler() { return m_profiler; }
 
-  friend std::ostream &operator<<(std::ostream &o, GameBoard &g);
+  /**
+   * Writes every chunk with something in it to a Snapshot file in one pass.
+   * Throws std::runtime_error if the file can't be written and
+   * std::invalid_argument if the rule has more than two states, snapshots
+   * only have the live cells.
+   */
+  void saveSnapshot(const std::string &path);
+  /**
+   * Replaces everything on the board with the chunks of a Snapshot file. The
+   * rows are copied straight out of a mapping of the file into the chunks.
+   *
+   * With lazy only the key index is read, chunks are copied in the first
+   * time something looks at them and the rest all at once on the next
+   * update(). Until then the file has to stay as it is. Bounded boards
+   * always copy everything in right away.
+   *
+   * Throws std::runtime_error if the file can't be read or was saved with a
+   * different chunk layout.
+   */
+  void loadSnapshot(const std::string &path, bool lazy = false);
+
+  /**
+   * Starts writing a DeltaLog at path, every update() from now on appends
+   * the chunks it changed, made and deleted. It goes with a snapshot saved
+   * at the current generation or with the end of the log before it.
+   *
+   * A log that is already going is ended first, so calling this again is how
+   * to start a new piece of the log to compact the old one while this one
+   * keeps going.
+   *
+   * Throws std::invalid_argument if the rule has more than two states, logs
+   * only have the live cells. setRule() turns those rules down for the same
+   * reason while a log is going.
+   */
+  void startDeltaLog(const std::string &path);
+  /**
+   * Writes out cells set since the last update and closes the log
+   */
+  void stopDeltaLog();
+  /**
+   * Plays a DeltaLog that starts at the current generation forward to
+   * generation, normally right after loading the snapshot it goes with.
+   *
+   * Throws std::runtime_error if the log doesn't start at the current
+   * generation or was saved with a different chunk layout and
+   * std::out_of_range if it ends before generation, in which case the board
+   * is left at the end of it.
+   */
+  void replayDeltaLog(const std::string &path, uint64_t generation);
+
+  /**
+   * Choose the vector instruction set used to step chunks, by default the
+   * best one the CPU has. Asking for more than the CPU has gives the best it
+   * can do.
+   */
+  void setSimdLevel(SimdLevel level);
+  SimdLevel getSimdLevel() const { return m_steppers[0].getSimdLevel(); }
+
+  /**
+   * Number of threads update() reads borders and steps chunks on, 0 uses one
+   * per hardware thread. Creating and deleting chunks always happens on the
+   * calling thread so the result doesn't depend on the thread count.
+   */
+  void setThreadCount(uint32_t threads);
+  uint32_t getThreadCount() const { return m_pool->size(); }
+
+  template <typename C>
+  friend std::ostream &operator<<(std::ostream &o, BasicGameBoard<C> &g);
 
 private:
-  friend class Chunk;
+  friend ChunkT;
+
+  // All chunks live in m_arena and point at each other by index, m_chunks
+  // only finds the index for a key
+  ChunkArena<ChunkT> m_arena;
+  ChunkMap<uint32_t> m_chunks;
+  std::unique_ptr<ThreadPool> m_pool = std::make_unique<ThreadPool>(1);
+  // One per thread of m_pool since they hold the batch buffers
+  std::vector<BatchStepper<ChunkT>> m_steppers =
+      std::vector<BatchStepper<ChunkT>>(1);
+  // Chunks to step and to replay this update, kept around to not reallocate
+  // every time
+  std::vector<ChunkT *> m_stepList;
+  std::vector<ChunkT *> m_replayList;
+
+  // Only the chunks that changed and the ones around them are looked at, the
+  // rest would come out exactly the same as they are. Of those only the ones
+  // near something that broke period 2 are stepped, the others are replayed.
+  // m_changed and m_offPeriod are the chunks with Flags::CHANGED and
+  // Flags::OFF_PERIOD, m_fresh the ones made since the last update and
+  // m_active and m_parked the ones stepped and replayed in the last update.
+  // The next m_active and m_parked are put together in m_nextActive and
+  // m_nextParked with m_activeMark keeping chunks from going in twice.
+  std::vector<uint32_t> m_changed;
+  std::vector<uint32_t> m_offPeriod;
+  std::vector<uint32_t> m_fresh;
+  std::vector<uint32_t> m_active;
+  std::vector<uint32_t> m_parked;
+  std::vector<uint32_t> m_nextActive;
+  std::vector<uint32_t> m_nextParked;
+  std::vector<uint32_t> m_activeMark;
+  uint32_t m_activeStamp = 0;
+  // Chunks to check for deletion next update whatever their flags say, see
+  // update(). m_emptyChecking is the list being gone through.
+  std::vector<uint32_t> m_emptyCheck;
+  std::vector<uint32_t> m_emptyChecking;
+  uint64_t m_generation = 0;
+  uint64_t m_steppedChunks = 0;
+  uint64_t m_replayedChunks = 0;
+  UpdateProfiler m_profiler;
+  Rule m_rule;
+  // Version of each chunk for collectChunks(), taken from m_version
+  std::vector<uint64_t> m_chunkVersion;
+  uint64_t m_version = 0;
+
+  // Width and height in chunks of a bounded board, chunk (x, y) of it has
+  // index y * width + x. m_gridMark has a bit for each chunk for putting
+  // the lists in order.
+  Topology m_topology = Topology::Unbounded;
+  uint32_t m_gridSize[2] = {0, 0};
+  std::vector<uint64_t> m_gridMark;
+
+  // Live cells of every chunk by index and of the tiles above them, only
+  // there once something asked for them. Changes to them wait in
+  // m_densityChanges and m_densityEdited says chunks in m_changed were set
+  // since they were last brought up to date.
+  std::unique_ptr<DensityPyramid> m_density;
+  std::vector<uint32_t> m_chunkCount;
+  std::vector<DensityPyramid::Change> m_densityChanges;
+  bool m_densityEdited = false;
+
+  // Chunks of a lazily loaded snapshot that haven't been copied in yet, by
+  // their index in m_snapshot. The file is only kept mapped while there are
+  // any.
+  std::unique_ptr<Snapshot::View> m_snapshot;
+  ChunkMap<uint32_t> m_lazyChunks;
 
-  std::unordered_map<ChunkKey, std::shared_ptr<Chunk>, ChunkKeyHash> m_chunks;
+  // Chunks with cells set since the last record of m_log, m_logMark keeps
+  // them from going in twice
+  std::unique_ptr<DeltaLog::Writer> m_log;
+  std::vector<uint32_t> m_logEdited;
+  std::vector<uint32_t> m_logMark;
+  uint32_t m_logStamp = 1;
 
   /**
    * Take a general (x,y) coordinate and find the chunk that it cooresponds
    * with.
    */
   ChunkKey calcChunkKey(int32_t x, int32_t y);
-  void makeChunk(ChunkKey key);
   /**
-   * Delets a given chunk's border connections
+   * Where a general x or y coordinate is inside its chunk
+   */
+  static int32_t calcChunkOffset(int32_t v);
+  /**
+   * Puts a chunk that had cells set in m_changed and m_offPeriod, going by
+   * the flags it had before
+   */
+  void markEdited(uint32_t chunk, typename ChunkT::Flags before);
+  void setVersion(uint32_t chunk, uint64_t version);
+  /**
+   * Puts the counts of the chunks set since the last update and everything
+   * in m_densityChanges into m_density
+   */
+  void syncDensity();
+  /**
+   * Counts the cells of a chunk and queues the change for m_density
+   */
+  void countChunk(uint32_t chunk);
+  /**
+   * Writes the chunks in m_logEdited to m_log as a record for the current
+   * generation
+   */
+  void logEdits();
+  void logRows(uint32_t chunk);
+  /**
+   * count (up to 64) bits of a bitmap starting at bit first, and the other
+   * way around
+   */
+  static uint64_t readBits(const uint64_t *bits, int32_t first, int32_t count);
+  static void writeBits(uint64_t *bits, int32_t first, int32_t count,
+                        uint64_t word);
+  /**
+   * Morton code of the chunk key of each cell along with where the cell is
+   * in cells, sorted
+   */
+  std::vector<std::pair<uint64_t, uint32_t>>
+  sortByChunk(std::span<const Cell> cells);
+  /**
+   * Gets the chunk for key, making it and linking it up with its neighbours
+   * if it isn't there yet. Can move every chunk in m_arena so indices have to
+   * be used over pointers across it. On a bounded board it only ever finds
+   * one, k_noChunk above or below a cylinder.
+   */
+  uint32_t makeChunk(ChunkKey key);
+  /**
+   * Unlinks a chunk from its neighbours and frees it
+   */
+  void deleteChunk(uint32_t index);
+  /**
+   * Puts a chunk and its neighbours in m_emptyCheck
    */
-  void deleteChunkBorders(std::shared_ptr<Chunk> c);
-  std::shared_ptr<Chunk> getChunk(ChunkKey key);
-  std::shared_ptr<Chunk> getOrMakeChunk(ChunkKey key);
-  void makeBorderChunks(ChunkKey key, std::shared_ptr<Chunk> c);
+  void queueEmptyCheck(uint32_t index);
+  /**
+   * True if a chunk and every neighbour it has are empty right now, so it
+   * stays empty and nothing around it needs it
+   */
+  bool canDelete(uint32_t index);
+  /**
+   * Index of the chunk for key or ChunkT::k_noChunk, copying it in from the
+   * snapshot if it is still there
+   */
+  uint32_t getChunk(ChunkKey key);
+  /**
+   * Same as getChunk() but only looks at the chunks that are in m_chunks. On
+   * a bounded board key is wrapped around onto the grid instead.
+   */
+  uint32_t findChunk(ChunkKey key);
+  /**
+   * Makes the chunk for key out of its rows in m_snapshot, k_noChunk if it
+   * isn't one of the lazy chunks
+   */
+  uint32_t faultIn(ChunkKey key);
+  void faultInAll();
+  /**
+   * Empties the board and everything that keeps track of its chunks, a
+   * bounded board gets its grid back empty
+   */
+  void clear();
+  bool isBounded() const { return m_topology != Topology::Unbounded; }
+  /**
+   * Makes every chunk of a bounded board and links them up across the edges
+   */
+  void makeGrid();
+  /**
+   * Index of the chunk of a bounded board that key lands on once wrapped
+   * around, k_noChunk above or below a cylinder
+   */
+  uint32_t gridChunk(ChunkKey key) const;
+  /**
+   * True if key is one of the chunks of a bounded board without wrapping it
+   * around, always true for an unbounded one
+   */
+  bool isOnGrid(ChunkKey key) const;
+  /**
+   * Puts a list of chunks of a bounded board in index order
+   */
+  void sortByIndex(std::vector<uint32_t> &list);
+  void makeBorderChunks(uint32_t index);
+  /**
+   * Adds a chunk to list if it isn't in m_nextActive or m_nextParked yet
+   */
+  void activate(uint32_t index, std::vector<uint32_t> &list);
 };
+
+extern template class BasicGameBoard<Chunk8>;
+extern template class BasicGameBoard<Chunk30>;
+extern template class BasicGameBoard<Chunk62>;
+extern template class BasicGameBoard<Chunk64>;
+extern template class BasicGameBoard<GenerationsChunk>;
+
+using GameBoard = BasicGameBoard<Chunk>;
+/**
+ * A GameBoard for Generations rules. Snapshots, delta logs and pattern files
+ * only have the live cells, so they can only be written while it runs a rule
+ * with two states.
+ */
+using GenerationsBoard = BasicGameBoard<GenerationsChunk>;
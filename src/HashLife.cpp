@@ -0,0 +1,445 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "HashLife.h"
+#include "LifeKernel.h"
+
+HashLife::HashLife(size_t maxNodes) : m_maxNodes(maxNodes) {
+  // The two cells, they have no children and never go in the table
+  m_nodes.push_back({{k_none, k_none, k_none, k_none}, k_none, 0, 0, 0});
+  m_nodes.push_back({{k_none, k_none, k_none, k_none}, k_none, 1, 0, 0});
+  m_empty.push_back(k_dead);
+  rehash(1024);
+
+  m_root = emptyNode(k_minLevel);
+}
+
+void HashLife::setPoint(int32_t x, int32_t y, bool value) {
+  while (!inUniverse(x, y)) {
+    m_root = expand(m_root);
+  }
+
+  int64_t half = int64_t(1) << (level(m_root) - 1);
+  m_root = setCell(m_root, x + half, y + half, value);
+}
+
+bool HashLife::getPoint(int32_t x, int32_t y) {
+  if (!inUniverse(x, y)) {
+    return false;
+  }
+
+  uint32_t node = m_root;
+  int64_t half = int64_t(1) << (level(node) - 1);
+  int64_t nodeX = x + half;
+  int64_t nodeY = y + half;
+
+  while (level(node) > 0 && m_nodes[node].population != 0) {
+    half = int64_t(1) << (level(node) - 1);
+    bool east = nodeX >= half;
+    bool north = nodeY >= half;
+    node = child(node, Quadrant((north ? NW : SW) + east));
+    nodeX -= east ? half : 0;
+    nodeY -= north ? half : 0;
+  }
+
+  return node == k_alive;
+}
+
+std::optional<LifeEngine::Bounds> HashLife::getBounds() {
+  if (getPopulation() == 0) {
+    return std::nullopt;
+  }
+
+  std::unordered_map<uint32_t, Bounds> known;
+  Bounds bounds = nodeBounds(m_root, known);
+  int64_t half = int64_t(1) << (level(m_root) - 1);
+  return Bounds{bounds.minX - half, bounds.minY - half, bounds.maxX - half,
+                bounds.maxY - half};
+}
+
+void HashLife::setRule(const Rule &rule) {
+  if (rule.states != 2) {
+    throw std::invalid_argument("HashLife only has two states, not " +
+                                rule.toString());
+  }
+  m_rule = rule;
+  for (Node &node : m_nodes) {
+    node.result = k_none;
+  }
+}
+
+void HashLife::setRoot(uint32_t node) {
+  m_root = node;
+  while (level(m_root) < k_minLevel) {
+    m_root = expand(m_root);
+  }
+}
+
+void HashLife::step(uint32_t log2Generations) {
+  // The root gets expanded to at least this plus 4 levels
+  if (log2Generations + 4 > k_maxLevel) {
+    throw std::invalid_argument("Can't step that many generations at once.");
+  }
+
+  collectIfFull();
+
+  // Nothing can move more than a cell a generation, so with the pattern in
+  // the middle quarter of a node that is 2^step wide the result still holds
+  // all of it
+  while (level(m_root) < log2Generations + 2 || !isPadded(m_root)) {
+    m_root = expand(m_root);
+  }
+  if (level(m_root) + 2 > k_maxLevel) {
+    throw std::overflow_error("Pattern grew past the edge of the universe.");
+  }
+  m_root = expand(expand(m_root));
+
+  m_root = successor(m_root, log2Generations);
+  m_generation += uint64_t(1) << log2Generations;
+
+  // Shrink it back down so the root doesn't grow a level every update
+  while (level(m_root) > k_minLevel && isPadded(m_root)) {
+    m_root = centre(m_root);
+  }
+
+  collectIfFull();
+}
+
+HashLife::Stats HashLife::getStats() const {
+  Stats stats = m_stats;
+  stats.nodes = m_nodes.size();
+  return stats;
+}
+
+uint64_t HashLife::hash(const std::array<uint32_t, 4> &children) {
+  uint64_t h = ((uint64_t(children[NW]) << 32) | children[NE]) *
+                   0x9E3779B97F4A7C15ull ^
+               ((uint64_t(children[SW]) << 32) | children[SE]);
+  // splitmix64 finaliser, same as ChunkMap
+  h ^= h >> 30;
+  h *= 0xBF58476D1CE4E5B9ull;
+  h ^= h >> 27;
+  h *= 0x94D049BB133111EBull;
+  h ^= h >> 31;
+  return h;
+}
+
+uint32_t HashLife::join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+  std::array<uint32_t, 4> children{nw, ne, sw, se};
+
+  size_t slot = hash(children) & m_tableMask;
+  while (m_table[slot] != k_none) {
+    if (m_nodes[m_table[slot]].children == children) {
+      return m_table[slot];
+    }
+    slot = (slot + 1) & m_tableMask;
+  }
+
+  if (m_nodes.size() >= k_none - 1) {
+    throw std::overflow_error("Ran out of node indices.");
+  }
+
+  // Populations of huge nodes can be more than fits, they just stop at the
+  // max since all that matters is if they are 0
+  uint64_t population = 0;
+  for (uint32_t c : children) {
+    uint64_t add = m_nodes[c].population;
+    population = add > std::numeric_limits<uint64_t>::max() - population
+                     ? std::numeric_limits<uint64_t>::max()
+                     : population + add;
+  }
+
+  uint32_t index = static_cast<uint32_t>(m_nodes.size());
+  m_nodes.push_back({children, k_none, population,
+                     static_cast<uint8_t>(m_nodes[nw].level + 1), 0});
+  m_table[slot] = index;
+
+  // Kept at most half full
+  if (m_nodes.size() * 2 > m_table.size()) {
+    rehash(m_table.size() * 2);
+  }
+
+  return index;
+}
+
+void HashLife::insertIntoTable(uint32_t index) {
+  size_t slot = hash(m_nodes[index].children) & m_tableMask;
+  while (m_table[slot] != k_none) {
+    slot = (slot + 1) & m_tableMask;
+  }
+  m_table[slot] = index;
+}
+
+void HashLife::rehash(size_t capacity) {
+  m_table.assign(capacity, k_none);
+  m_tableMask = capacity - 1;
+
+  for (uint32_t i = 0; i < m_nodes.size(); i++) {
+    if (m_nodes[i].level > 0) {
+      insertIntoTable(i);
+    }
+  }
+}
+
+uint32_t HashLife::emptyNode(uint32_t level) {
+  while (m_empty.size() <= level) {
+    uint32_t below = m_empty.back();
+    uint32_t next = join(below, below, below, below);
+    m_empty.push_back(next);
+  }
+  return m_empty[level];
+}
+
+uint32_t HashLife::expand(uint32_t index) {
+  Node node = m_nodes[index];
+  uint32_t e = emptyNode(node.level - 1);
+
+  uint32_t nw = join(e, e, e, node.children[NW]);
+  uint32_t ne = join(e, e, node.children[NE], e);
+  uint32_t sw = join(e, node.children[SW], e, e);
+  uint32_t se = join(node.children[SE], e, e, e);
+  return join(nw, ne, sw, se);
+}
+
+uint32_t HashLife::centre(uint32_t index) {
+  Node node = m_nodes[index];
+  return join(child(node.children[NW], SE), child(node.children[NE], SW),
+              child(node.children[SW], NE), child(node.children[SE], NW));
+}
+
+uint32_t HashLife::horizontalCentre(uint32_t west, uint32_t east) {
+  return join(child(west, NE), child(east, NW), child(west, SE),
+              child(east, SW));
+}
+
+uint32_t HashLife::verticalCentre(uint32_t north, uint32_t south) {
+  return join(child(north, SW), child(north, SE), child(south, NW),
+              child(south, NE));
+}
+
+bool HashLife::isPadded(uint32_t index) const {
+  const Node &node = m_nodes[index];
+  uint64_t inner = m_nodes[child(node.children[NW], SE)].population +
+                   m_nodes[child(node.children[NE], SW)].population +
+                   m_nodes[child(node.children[SW], NE)].population +
+                   m_nodes[child(node.children[SE], NW)].population;
+  return inner == node.population;
+}
+
+uint32_t HashLife::successor(uint32_t index, uint32_t step) {
+  Node node = m_nodes[index];
+  if (node.population == 0) {
+    return emptyNode(node.level - 1);
+  }
+  if (node.result != k_none && node.resultStep == step) {
+    m_stats.cacheHits++;
+    return node.result;
+  }
+  m_stats.cacheMisses++;
+
+  uint32_t result;
+  if (node.level == 2) {
+    result = baseCase(index);
+  } else {
+    auto [nw, ne, sw, se] = node.children;
+
+    // Nine overlapping squares a level down covering the node, n[row][col]
+    // with row 0 at the top
+    uint32_t n[3][3] = {
+        {nw, horizontalCentre(nw, ne), ne},
+        {verticalCentre(nw, sw), centre(index), verticalCentre(ne, se)},
+        {sw, horizontalCentre(sw, se), se}};
+
+    // At full speed both halves move 2^(step - 1) generations, any slower
+    // and the first half just takes the middles and the second does all of
+    // it
+    bool fullSpeed = step + 2 == node.level;
+    uint32_t r[3][3];
+    for (int row = 0; row < 3; row++) {
+      for (int col = 0; col < 3; col++) {
+        r[row][col] = fullSpeed ? successor(n[row][col], step - 1)
+                                : centre(n[row][col]);
+      }
+    }
+
+    uint32_t secondStep = fullSpeed ? step - 1 : step;
+    uint32_t quadrants[4];
+    for (int row = 0; row < 2; row++) {
+      for (int col = 0; col < 2; col++) {
+        uint32_t combined = join(r[row][col], r[row][col + 1],
+                                 r[row + 1][col], r[row + 1][col + 1]);
+        quadrants[row * 2 + col] = successor(combined, secondStep);
+      }
+    }
+
+    result = join(quadrants[NW], quadrants[NE], quadrants[SW], quadrants[SE]);
+  }
+
+  m_nodes[index].result = result;
+  m_nodes[index].resultStep = static_cast<uint8_t>(step);
+  return result;
+}
+
+uint32_t HashLife::baseCase(uint32_t index) {
+  // The 4x4 cells as rows of bits, row 0 at the bottom and bit 0 on the left
+  uint32_t rows[4] = {};
+  for (uint32_t q = NW; q <= SE; q++) {
+    uint32_t quadrant = child(index, Quadrant(q));
+    for (uint32_t c = NW; c <= SE; c++) {
+      if (child(quadrant, Quadrant(c)) == k_alive) {
+        uint32_t x = (q & 1) * 2 + (c & 1);
+        uint32_t y = (q < SW ? 2 : 0) + (c < SW ? 1 : 0);
+        rows[y] |= 1u << x;
+      }
+    }
+  }
+
+  uint32_t next[4] = {};
+  LifeKernel::withRule(m_rule, [&](auto nextState) {
+    for (int y = 1; y <= 2; y++) {
+      next[y] = nextState(rows[y + 1] << 1, rows[y + 1], rows[y + 1] >> 1,
+                          rows[y] << 1, rows[y], rows[y] >> 1,
+                          rows[y - 1] << 1, rows[y - 1], rows[y - 1] >> 1);
+    }
+  });
+
+  auto cell = [&](int x, int y) { return (next[y] >> x) & 1; };
+  return join(cell(1, 2), cell(2, 2), cell(1, 1), cell(2, 1));
+}
+
+uint32_t HashLife::setCell(uint32_t index, int64_t x, int64_t y, bool value) {
+  if (level(index) == 0) {
+    return value ? k_alive : k_dead;
+  }
+
+  int64_t half = int64_t(1) << (level(index) - 1);
+  bool east = x >= half;
+  bool north = y >= half;
+  Quadrant q = Quadrant((north ? NW : SW) + east);
+
+  std::array<uint32_t, 4> children = m_nodes[index].children;
+  children[q] = setCell(children[q], x - (east ? half : 0),
+                        y - (north ? half : 0), value);
+  return join(children[NW], children[NE], children[SW], children[SE]);
+}
+
+bool HashLife::inUniverse(int64_t x, int64_t y) const {
+  int64_t half = int64_t(1) << (level(m_root) - 1);
+  return x >= -half && x < half && y >= -half && y < half;
+}
+
+LifeEngine::Bounds
+HashLife::nodeBounds(uint32_t index,
+                     std::unordered_map<uint32_t, Bounds> &known) const {
+  if (level(index) == 0) {
+    return {0, 0, 0, 0};
+  }
+  if (auto found = known.find(index); found != known.end()) {
+    return found->second;
+  }
+
+  int64_t half = int64_t(1) << (level(index) - 1);
+  std::optional<Bounds> bounds;
+  for (uint32_t q = NW; q <= SE; q++) {
+    uint32_t quadrant = child(index, Quadrant(q));
+    if (m_nodes[quadrant].population == 0) {
+      continue;
+    }
+
+    Bounds b = nodeBounds(quadrant, known);
+    int64_t x = (q & 1) ? half : 0;
+    int64_t y = q < SW ? half : 0;
+    b = {b.minX + x, b.minY + y, b.maxX + x, b.maxY + y};
+    if (!bounds) {
+      bounds = b;
+    } else {
+      bounds = Bounds{std::min(bounds->minX, b.minX),
+                      std::min(bounds->minY, b.minY),
+                      std::max(bounds->maxX, b.maxX),
+                      std::max(bounds->maxY, b.maxY)};
+    }
+  }
+
+  known[index] = *bounds;
+  return *bounds;
+}
+
+void HashLife::collect(bool keepResults) {
+  std::vector<uint8_t> marked(m_nodes.size(), 0);
+  std::vector<uint32_t> stack(m_empty.begin(), m_empty.end());
+  stack.push_back(k_alive);
+  stack.push_back(m_root);
+
+  while (!stack.empty()) {
+    uint32_t index = stack.back();
+    stack.pop_back();
+    if (marked[index]) {
+      continue;
+    }
+    marked[index] = 1;
+
+    const Node &node = m_nodes[index];
+    if (node.level > 0) {
+      stack.insert(stack.end(), node.children.begin(), node.children.end());
+    }
+    if (keepResults && node.result != k_none) {
+      stack.push_back(node.result);
+    }
+  }
+
+  // Children are always made before their parents so keeping the order
+  // keeps the cells at 0 and 1
+  std::vector<uint32_t> remap(m_nodes.size(), k_none);
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < m_nodes.size(); i++) {
+    if (marked[i]) {
+      remap[i] = kept++;
+    }
+  }
+
+  for (uint32_t i = 0; i < m_nodes.size(); i++) {
+    if (!marked[i]) {
+      continue;
+    }
+
+    Node node = m_nodes[i];
+    if (node.level > 0) {
+      for (uint32_t &c : node.children) {
+        c = remap[c];
+      }
+    }
+    if (node.result != k_none) {
+      node.result = remap[node.result];
+    }
+    m_nodes[remap[i]] = node;
+  }
+  m_nodes.resize(kept);
+
+  for (uint32_t &e : m_empty) {
+    e = remap[e];
+  }
+  m_root = remap[m_root];
+
+  size_t capacity = 1024;
+  while (m_nodes.size() * 2 > capacity) {
+    capacity *= 2;
+  }
+  rehash(capacity);
+
+  m_stats.collections++;
+}
+
+void HashLife::collectIfFull() {
+  if (m_nodes.size() <= m_maxNodes) {
+    return;
+  }
+
+  collect(true);
+  // Holding on to every result can be most of the nodes, then only the
+  // pattern itself is kept
+  if (m_nodes.size() > m_maxNodes / 2) {
+    collect(false);
+  }
+}
@@ -0,0 +1,195 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "LifeEngine.h"
+
+/**
+ * Gosper's HashLife, a LifeEngine that is good at patterns that repeat in
+ * space or time and can jump ahead 2^k generations at once.
+ *
+ * The universe is a quadtree where a node of level L is a 2^L x 2^L square
+ * made of four level L - 1 nodes, level 0 being a single cell. Nodes are
+ * hash-consed so each distinct square only exists once, and each one
+ * remembers its result: the middle 2^(L-1) square some number of generations
+ * later. Repeating parts of a pattern then only ever get worked out once.
+ *
+ * Nodes live in one vector and point at each other by index like the chunks
+ * of a GameBoard. Old generations stay in there until the node count goes over
+ * the limit given to the constructor, then everything the current pattern
+ * doesn't need is collected between steps. A single big step can go over the
+ * limit while it runs.
+ *
+ * Like GameBoard y goes up, the universe is centered on (0, 0) and can be up
+ * to 2^k_maxLevel cells wide.
+ */
+class HashLife : public LifeEngine {
+public:
+  struct Stats {
+    // Nodes currently stored
+    size_t nodes = 0;
+    // Results that were already worked out and ones that weren't
+    uint64_t cacheHits = 0;
+    uint64_t cacheMisses = 0;
+    uint64_t collections = 0;
+
+    double hitRate() const {
+      uint64_t lookups = cacheHits + cacheMisses;
+      return lookups == 0 ? 0.0 : static_cast<double>(cacheHits) / lookups;
+    }
+  };
+
+  static constexpr uint32_t k_maxLevel = 62;
+  static constexpr size_t k_defaultMaxNodes = size_t(1) << 22;
+
+  explicit HashLife(size_t maxNodes = k_defaultMaxNodes);
+
+  void setPoint(int32_t x, int32_t y, bool value) override;
+  bool getPoint(int32_t x, int32_t y) override;
+
+  std::optional<Bounds> getBounds() override;
+
+  /**
+   * Every node's result was worked out with the old rule so they are all
+   * forgotten. Throws std::invalid_argument for Generations rules, a node is
+   * only ever dead or alive.
+   */
+  void setRule(const Rule &rule) override;
+  Rule getRule() const override { return m_rule; }
+
+  void update() override { step(0); }
+  /**
+   * Throws std::invalid_argument if 2^log2Generations is too far to get to
+   * in one go and std::overflow_error if the pattern grows past the edge of
+   * the universe.
+   */
+  void step(uint32_t log2Generations) override;
+
+  uint64_t getGeneration() const { return m_generation; }
+  uint64_t getPopulation() const { return m_nodes[m_root].population; }
+
+  Stats getStats() const;
+
+  void setMaxNodes(size_t maxNodes) { m_maxNodes = maxNodes; }
+  size_t getMaxNodes() const { return m_maxNodes; }
+  /**
+   * Throws away every node the current pattern and its results don't need
+   */
+  void collectGarbage() { collect(true); }
+
+  // Direct access to the tree for reading and writing whole trees at once
+  // (Macrocell files). Node indices are only good until the next step() or
+  // collectGarbage().
+
+  enum Quadrant : uint32_t { NW, NE, SW, SE };
+
+  // Index of the two level 0 nodes
+  static constexpr uint32_t k_dead = 0;
+  static constexpr uint32_t k_alive = 1;
+  static constexpr uint32_t k_minLevel = 3;
+
+  uint32_t getRoot() const { return m_root; }
+  /**
+   * Replaces the pattern with node, centered on (0, 0)
+   */
+  void setRoot(uint32_t node);
+  uint32_t makeNode(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    return join(nw, ne, sw, se);
+  }
+  uint32_t emptyNode(uint32_t level);
+  uint32_t getLevel(uint32_t node) const { return m_nodes[node].level; }
+  uint64_t getPopulation(uint32_t node) const {
+    return m_nodes[node].population;
+  }
+  uint32_t getChild(uint32_t node, Quadrant q) const {
+    return m_nodes[node].children[q];
+  }
+
+private:
+  struct Node {
+    std::array<uint32_t, 4> children;
+    // Middle of the node 2^resultStep generations on, k_none if not known yet
+    uint32_t result;
+    uint64_t population;
+    uint8_t level;
+    uint8_t resultStep;
+  };
+
+  static constexpr uint32_t k_none = UINT32_MAX;
+
+  std::vector<Node> m_nodes;
+  // Open addressing table of node indices keyed on their children
+  std::vector<uint32_t> m_table;
+  size_t m_tableMask = 0;
+  // The empty node of each level
+  std::vector<uint32_t> m_empty;
+
+  uint32_t m_root;
+  uint64_t m_generation = 0;
+  Rule m_rule;
+  size_t m_maxNodes;
+  Stats m_stats;
+
+  static uint64_t hash(const std::array<uint32_t, 4> &children);
+  /**
+   * The canonical node with these four children, made if it isn't there yet.
+   * Can reallocate m_nodes so references to nodes don't survive it.
+   */
+  uint32_t join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+  void insertIntoTable(uint32_t index);
+  void rehash(size_t capacity);
+
+  uint32_t child(uint32_t index, Quadrant q) const {
+    return m_nodes[index].children[q];
+  }
+  uint32_t level(uint32_t index) const { return m_nodes[index].level; }
+
+  /**
+   * Node one level up with index in the middle
+   */
+  uint32_t expand(uint32_t index);
+  /**
+   * The middle half of a node, a level down
+   */
+  uint32_t centre(uint32_t index);
+  /**
+   * The square straddling two nodes next to each other, same level as them
+   */
+  uint32_t horizontalCentre(uint32_t west, uint32_t east);
+  uint32_t verticalCentre(uint32_t north, uint32_t south);
+  /**
+   * True if everything alive in the node is in its middle half
+   */
+  bool isPadded(uint32_t index) const;
+
+  /**
+   * The middle of a node 2^step generations later, step can be at most the
+   * level - 2
+   */
+  uint32_t successor(uint32_t index, uint32_t step);
+  /**
+   * successor() of a 4x4 node, one generation
+   */
+  uint32_t baseCase(uint32_t index);
+
+  uint32_t setCell(uint32_t index, int64_t x, int64_t y, bool value);
+  bool inUniverse(int64_t x, int64_t y) const;
+  /**
+   * Bounds of the live cells of a non empty node, relative to its bottom
+   * left corner
+   */
+  Bounds nodeBounds(uint32_t index,
+                    std::unordered_map<uint32_t, Bounds> &known) const;
+
+  /**
+   * Mark everything reachable from the root and compact m_nodes. Remembered
+   * results only count as reachable with keepResults, otherwise they are
+   * forgotten if nothing else needs the node.
+   */
+  void collect(bool keepResults);
+  void collectIfFull();
+};
@@ -0,0 +1,138 @@
+#include <stdexcept>
+#include <utility>
+
+#include "HeadlessContext.h"
+
+#ifdef GAME_OF_LIFE_EGL
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+namespace {
+
+/**
+ * The default display, or Mesa's surfaceless one when there isn't a display
+ * server to get it from
+ */
+EGLDisplay openDisplay() {
+  EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+    return display;
+  }
+
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+  auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+      eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (getPlatformDisplay) {
+    display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                 EGL_DEFAULT_DISPLAY, nullptr);
+    if (display != EGL_NO_DISPLAY &&
+        eglInitialize(display, nullptr, nullptr)) {
+      return display;
+    }
+  }
+#endif
+
+  throw std::runtime_error("Couldn't open an EGL display");
+}
+
+} // namespace
+
+HeadlessContext::HeadlessContext(int32_t width, int32_t height)
+    : m_width(width), m_height(height) {
+  EGLDisplay display = openDisplay();
+  m_display = display;
+
+  const EGLint configAttribs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                  EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                  EGL_NONE};
+  EGLConfig config;
+  EGLint configs = 0;
+  if (!eglChooseConfig(display, configAttribs, &config, 1, &configs) ||
+      configs == 0 || !eglBindAPI(EGL_OPENGL_API)) {
+    eglTerminate(display);
+    throw std::runtime_error("EGL has no desktop OpenGL");
+  }
+
+  EGLContext context = EGL_NO_CONTEXT;
+  for (auto [major, minor] : {std::pair{4, 5}, std::pair{3, 3}}) {
+    const EGLint contextAttribs[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                     major,
+                                     EGL_CONTEXT_MINOR_VERSION,
+                                     minor,
+                                     EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                     EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                     EGL_NONE};
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context != EGL_NO_CONTEXT) {
+      break;
+    }
+  }
+  if (context == EGL_NO_CONTEXT) {
+    eglTerminate(display);
+    throw std::runtime_error("Couldn't create an OpenGL 3.3 context");
+  }
+  m_context = context;
+
+  // Everything is drawn into the framebuffer below so the surface doesn't
+  // matter, a tiny pbuffer is only made if surfaceless contexts aren't there
+  EGLSurface surface = EGL_NO_SURFACE;
+  if (!eglMakeCurrent(display, surface, surface, context)) {
+    const EGLint surfaceAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+    if (surface == EGL_NO_SURFACE ||
+        !eglMakeCurrent(display, surface, surface, context)) {
+      eglDestroyContext(display, context);
+      eglTerminate(display);
+      throw std::runtime_error("Couldn't make the EGL context current");
+    }
+  }
+  m_surface = surface;
+
+  if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+    throw std::runtime_error("Failed to initialize GLAD");
+  }
+
+  glGenRenderbuffers(1, &m_colorBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glGenFramebuffers(1, &m_framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, m_colorBuffer);
+  glViewport(0, 0, width, height);
+}
+
+HeadlessContext::~HeadlessContext() {
+  glDeleteFramebuffers(1, &m_framebuffer);
+  glDeleteRenderbuffers(1, &m_colorBuffer);
+
+  eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (m_surface != EGL_NO_SURFACE) {
+    eglDestroySurface(m_display, m_surface);
+  }
+  eglDestroyContext(m_display, m_context);
+  eglTerminate(m_display);
+}
+
+std::vector<uint8_t> HeadlessContext::readPixels() {
+  std::vector<uint8_t> pixels(size_t(m_width) * m_height * 4);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE,
+               pixels.data());
+  return pixels;
+}
+
+#else
+
+HeadlessContext::HeadlessContext(int32_t width, int32_t height)
+    : m_width(width), m_height(height) {
+  throw std::runtime_error("Built without EGL, no headless contexts");
+}
+
+HeadlessContext::~HeadlessContext() {}
+
+std::vector<uint8_t> HeadlessContext::readPixels() { return {}; }
+
+#endif
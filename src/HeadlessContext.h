@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * An OpenGL context without a window, drawing into a framebuffer of its own.
+ * Goes through EGL so it also works on machines without a display, using
+ * whatever driver is there or a software one like llvmpipe.
+ *
+ * Tries for a 4.5 core context and takes 3.3 if that is all there is. Throws
+ * std::runtime_error if it can't get either or the build has no EGL.
+ */
+class HeadlessContext {
+public:
+  HeadlessContext(int32_t width, int32_t height);
+  ~HeadlessContext();
+
+  HeadlessContext(const HeadlessContext &) = delete;
+  const HeadlessContext &operator=(const HeadlessContext &) = delete;
+
+  int32_t getWidth() const { return m_width; }
+  int32_t getHeight() const { return m_height; }
+
+  /**
+   * The framebuffer as RGBA bytes, bottom row first
+   */
+  std::vector<uint8_t> readPixels();
+
+private:
+  int32_t m_width;
+  int32_t m_height;
+  void *m_display = nullptr;
+  void *m_context = nullptr;
+  void *m_surface = nullptr;
+  GLuint m_framebuffer = 0;
+  GLuint m_colorBuffer = 0;
+};
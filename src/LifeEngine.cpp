@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <bit>
+#include <optional>
+#include <vector>
+
+#include "LifeEngine.h"
+
+void LifeEngine::collectChunks(int32_t x, int32_t y, int32_t width,
+                               int32_t height, ChunkFrame &frame) {
+  constexpr int32_t k_tile = 32;
+  frame.reset(k_tile);
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+
+  // The rectangle grown out to whole tiles, lined up with (0, 0) so a tile
+  // covers the same cells from one frame to the next
+  auto floorTile = [](int64_t v) {
+    return (v >= 0 ? v : v - (k_tile - 1)) / k_tile * k_tile;
+  };
+  int64_t left = floorTile(x);
+  int64_t bottom = floorTile(y);
+  int64_t right = std::min<int64_t>(floorTile(int64_t(x) + width - 1) + k_tile,
+                                    int64_t(INT32_MAX) + 1);
+  int64_t top = std::min<int64_t>(floorTile(int64_t(y) + height - 1) + k_tile,
+                                  int64_t(INT32_MAX) + 1);
+  auto tilesWide = static_cast<int32_t>((right - left + k_tile - 1) / k_tile);
+  auto regionWidth = static_cast<int32_t>(right - left);
+  size_t stride = regionStride(regionWidth);
+
+  // A band of tiles at a time so the bitmap stays small
+  std::vector<uint64_t> band(stride * k_tile);
+  for (int64_t tileY = bottom; tileY < top; tileY += k_tile) {
+    auto rows = static_cast<int32_t>(std::min<int64_t>(k_tile, top - tileY));
+    getRegion(static_cast<int32_t>(left), static_cast<int32_t>(tileY),
+              regionWidth, rows, band.data());
+
+    for (int32_t t = 0; t < tilesWide; t++) {
+      uint32_t tile[k_tile] = {};
+      uint32_t any = 0;
+      for (int32_t r = 0; r < rows; r++) {
+        int32_t bit = t * k_tile;
+        tile[r] =
+            static_cast<uint32_t>(band[r * stride + bit / 64] >> (bit % 64));
+        any |= tile[r];
+      }
+      if (!any) {
+        continue;
+      }
+
+      // Without chunks of its own there is no telling what changed, so the
+      // version is a hash of the cells (FNV-1a)
+      uint64_t version = 0xCBF29CE484222325ull;
+      for (uint32_t word : tile) {
+        version = (version ^ word) * 0x100000001B3ull;
+      }
+
+      auto key = ChunkKey(static_cast<int32_t>((left + t * k_tile) / k_tile),
+                          static_cast<int32_t>(tileY / k_tile));
+      std::copy(tile, tile + k_tile, frame.add(key, version));
+    }
+  }
+}
+
+void LifeEngine::collectDensity(int32_t x, int32_t y, int32_t width,
+                                int32_t height, int64_t tileCells,
+                                DensityFrame &frame) {
+  frame.reset(std::max<int64_t>(tileCells, 1), x, y, width, height);
+  std::optional<Bounds> bounds = getBounds();
+  if (!bounds || frame.counts.empty()) {
+    return;
+  }
+
+  // Whole tiles are counted, but only the part with live cells in it has to
+  // be read
+  int64_t tile = frame.tileCells;
+  int64_t left = std::max(frame.x * tile, bounds->minX);
+  int64_t right = std::min((frame.x + int64_t(frame.width)) * tile - 1,
+                           bounds->maxX);
+  int64_t bottom = std::max(frame.y * tile, bounds->minY);
+  int64_t top = std::min((frame.y + int64_t(frame.height)) * tile - 1,
+                         bounds->maxY);
+  if (left > right || bottom > top) {
+    return;
+  }
+
+  auto readWidth = static_cast<int32_t>(right - left + 1);
+  size_t stride = regionStride(readWidth);
+  std::vector<uint64_t> band(stride * 64);
+  for (int64_t bandY = bottom; bandY <= top; bandY += 64) {
+    auto rows = static_cast<int32_t>(std::min<int64_t>(64, top - bandY + 1));
+    getRegion(static_cast<int32_t>(left), static_cast<int32_t>(bandY),
+              readWidth, rows, band.data());
+
+    for (int32_t r = 0; r < rows; r++) {
+      uint64_t *counts = frame.counts.data() +
+                         (frame.tileOf(bandY + r) - frame.y) * frame.width;
+      for (size_t w = 0; w < stride; w++) {
+        for (uint64_t bits = band[r * stride + w]; bits; bits &= bits - 1) {
+          int64_t cell = left + int64_t(w) * 64 + std::countr_zero(bits);
+          counts[frame.tileOf(cell) - frame.x]++;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "ChunkFrame.h"
+#include "DensityFrame.h"
+#include "Rule.h"
+
+/**
+ * What every way of running the game has in common, so the chunked GameBoard
+ * and HashLife can be swapped for each other.
+ *
+ * Points are on an unbounded grid addressed by (x, y) and time only moves
+ * forward.
+ */
+class LifeEngine {
+public:
+  /**
+   * Inclusive rectangle, 64 bit since HashLife patterns can get that big
+   */
+  struct Bounds {
+    int64_t minX, minY, maxX, maxY;
+
+    bool operator==(const Bounds &) const = default;
+  };
+
+  struct Cell {
+    int32_t x, y;
+  };
+
+  /**
+   * What happens at the edges of a board. An unbounded board grows wherever
+   * something is alive. A torus is a fixed size and wraps around both ways,
+   * a cylinder only wraps left and right with the cells above and below it
+   * always dead.
+   */
+  enum class Topology { Unbounded, Torus, Cylinder };
+
+  /**
+   * Words in each row of a region bitmap. Rows go up from the bottom of the
+   * region and each one starts on a new word, bit i % 64 of word i / 64 of a
+   * row being the cell i to the right of the left edge.
+   */
+  static constexpr size_t regionStride(int32_t width) {
+    return (static_cast<size_t>(width) + 63) / 64;
+  }
+
+  virtual ~LifeEngine() = default;
+
+  virtual void setPoint(int32_t x, int32_t y, bool value) = 0;
+  virtual bool getPoint(int32_t x, int32_t y) = 0;
+
+  /**
+   * Sets length cells going right from (x, y), engines that can do a whole
+   * row at once override this
+   */
+  virtual void setRun(int32_t x, int32_t y, int32_t length, bool value) {
+    for (int32_t i = 0; i < length; i++) {
+      setPoint(x + i, y, value);
+    }
+  }
+
+  /**
+   * Sets the live cells of a row from a bitmap, bit i % 64 of bits[i / 64]
+   * being the cell at (x + i, y). Cells that are 0 in it are left as they
+   * are. Engines that can do a whole row at once override this.
+   */
+  virtual void setRowBits(int32_t x, int32_t y, const uint64_t *bits,
+                          int32_t width) {
+    for (int32_t i = 0; i < width; i++) {
+      if ((bits[i / 64] >> (i % 64)) & 1) {
+        setPoint(x + i, y, true);
+      }
+    }
+  }
+
+  /**
+   * Overwrites every cell of the width x height rectangle with its bottom
+   * left corner at (x, y) with the region bitmap bits
+   */
+  virtual void setRegion(int32_t x, int32_t y, int32_t width, int32_t height,
+                         const uint64_t *bits) {
+    size_t stride = regionStride(width);
+    for (int32_t row = 0; row < height; row++) {
+      const uint64_t *rowBits = bits + row * stride;
+      for (int32_t i = 0; i < width; i++) {
+        setPoint(x + i, y + row, (rowBits[i / 64] >> (i % 64)) & 1);
+      }
+    }
+  }
+
+  /**
+   * Fills the region bitmap bits with the cells of the rectangle, it has to
+   * have room for height * regionStride(width) words
+   */
+  virtual void getRegion(int32_t x, int32_t y, int32_t width, int32_t height,
+                         uint64_t *bits) {
+    size_t stride = regionStride(width);
+    for (int32_t row = 0; row < height; row++) {
+      uint64_t *rowBits = bits + row * stride;
+      for (size_t w = 0; w < stride; w++) {
+        rowBits[w] = 0;
+      }
+      for (int32_t i = 0; i < width; i++) {
+        if (getPoint(x + i, y + row)) {
+          rowBits[i / 64] |= uint64_t(1) << (i % 64);
+        }
+      }
+    }
+  }
+
+  /**
+   * Sets every cell in cells to value, they can be in any order
+   */
+  virtual void setCells(std::span<const Cell> cells, bool value) {
+    for (Cell c : cells) {
+      setPoint(c.x, c.y, value);
+    }
+  }
+
+  /**
+   * Bit i % 64 of alive[i / 64] gets set to cells[i], there has to be room
+   * for (cells.size() + 63) / 64 words
+   */
+  virtual void getCells(std::span<const Cell> cells, uint64_t *alive) {
+    for (size_t i = 0; i < (cells.size() + 63) / 64; i++) {
+      alive[i] = 0;
+    }
+    for (size_t i = 0; i < cells.size(); i++) {
+      if (getPoint(cells[i].x, cells[i].y)) {
+        alive[i / 64] |= uint64_t(1) << (i % 64);
+      }
+    }
+  }
+
+  /**
+   * Puts every chunk with live cells that overlaps the rectangle into frame.
+   * Engines without chunks of their own hand over 32x32 squares of it, going
+   * by getRegion().
+   */
+  virtual void collectChunks(int32_t x, int32_t y, int32_t width,
+                             int32_t height, ChunkFrame &frame);
+
+  /**
+   * Counts the live cells of the tiles covering the rectangle, square tiles
+   * of at least tileCells cells a side, for drawing it zoomed out. Engines
+   * can make the tiles bigger than asked for to line up with what they keep
+   * track of.
+   *
+   * Engines without counts of their own go through every cell of the tiles
+   * that is inside getBounds().
+   */
+  virtual void collectDensity(int32_t x, int32_t y, int32_t width,
+                              int32_t height, int64_t tileCells,
+                              DensityFrame &frame);
+
+  /**
+   * Smallest rectangle holding every live cell, nothing if there are none
+   */
+  virtual std::optional<Bounds> getBounds() = 0;
+
+  /**
+   * The rule cells live and die by, B3/S23 until it is set to something
+   * else. Changing it leaves the cells as they are and only changes how they
+   * go on from here.
+   */
+  virtual void setRule(const Rule &rule) = 0;
+  virtual Rule getRule() const = 0;
+
+  /**
+   * Advance one generation
+   */
+  virtual void update() = 0;
+
+  /**
+   * Advance 2^log2Generations generations. Engines that can jump ahead
+   * override this, the rest just update() that many times.
+   */
+  virtual void step(uint32_t log2Generations) {
+    for (uint64_t i = 0; i < (uint64_t(1) << log2Generations); i++) {
+      update();
+    }
+  }
+};
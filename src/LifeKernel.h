@@ -0,0 +1,219 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+
+#include "Rule.h"
+
+/**
+ * Word parallel Game of Life kernel.
+ *
+ * Every bit of a word is a separate cell so one call works out a whole row at
+ * once. The eight neighbours of each cell are added up as bit-sliced numbers
+ * with half and full adders and the result is then compared against the rule
+ * without ever looking at a single cell on its own.
+ *
+ * The functions only use &, |, ^ and ~ so they work with any unsigned integer
+ * type (and anything else that has those operators).
+ */
+namespace LifeKernel {
+
+/**
+ * Adds two one bit numbers in every bit position of the words.
+ */
+template <typename Word>
+inline void halfAdd(Word a, Word b, Word &sum, Word &carry) {
+  sum = a ^ b;
+  carry = a & b;
+}
+
+/**
+ * Adds three one bit numbers in every bit position of the words.
+ */
+template <typename Word>
+inline void fullAdd(Word a, Word b, Word c, Word &sum, Word &carry) {
+  Word ab = a ^ b;
+  sum = ab ^ c;
+  carry = (a & b) | (ab & c);
+}
+
+/**
+ * Works out the next state of a row from the nine words around it. The
+ * "West" words hold the neighbour to the left of each cell in the cells bit
+ * position, the "East" words the neighbour to the right.
+ */
+template <typename Word>
+inline Word nextState(Word topWest, Word top, Word topEast, Word currWest,
+                      Word curr, Word currEast, Word botWest, Word bot,
+                      Word botEast) {
+  // Neighbour count for each of the rows, the middle row only has two since
+  // the cell itself doesn't count
+  Word top0, top1, mid0, mid1, bot0, bot1;
+  fullAdd(topWest, top, topEast, top0, top1);
+  halfAdd(currWest, currEast, mid0, mid1);
+  fullAdd(botWest, bot, botEast, bot0, bot1);
+
+  // Add up the ones, what is carried over goes in with the twos
+  Word ones, onesCarry;
+  fullAdd(top0, mid0, bot0, ones, onesCarry);
+
+  // There have to be exactly one two for a count of 2 or 3. An odd number of
+  // twos is one or three so knock out the cases with at least two of them
+  Word twosOdd = top1 ^ mid1 ^ bot1 ^ onesCarry;
+  Word twosAtLeastTwo = (top1 & mid1) | (bot1 & onesCarry) |
+                        ((top1 ^ mid1) & (bot1 ^ onesCarry));
+  Word exactlyOneTwo = twosOdd & ~twosAtLeastTwo;
+
+  // 3 neighbours is always alive, 2 neighbours only keeps a live cell alive
+  return exactlyOneTwo & (ones | curr);
+}
+
+/**
+ * Neighbour count of every cell as a four bit number, one word per bit
+ */
+template <typename Word> struct Count {
+  Word ones, twos, fours, eights;
+};
+
+template <typename Word>
+inline Count<Word> countNeighbours(Word topWest, Word top, Word topEast,
+                                   Word currWest, Word currEast, Word botWest,
+                                   Word bot, Word botEast) {
+  Word top0, top1, mid0, mid1, bot0, bot1;
+  fullAdd(topWest, top, topEast, top0, top1);
+  halfAdd(currWest, currEast, mid0, mid1);
+  fullAdd(botWest, bot, botEast, bot0, bot1);
+
+  // Same as nextState() up to here, the twos are added up all the way
+  // instead of only checking for exactly one of them
+  Count<Word> count;
+  Word onesCarry, twos, twosCarry, foursCarry;
+  fullAdd(top0, mid0, bot0, count.ones, onesCarry);
+  fullAdd(top1, mid1, bot1, twos, twosCarry);
+  halfAdd(twos, onesCarry, count.twos, foursCarry);
+  halfAdd(twosCarry, foursCarry, count.fours, count.eights);
+  return count;
+}
+
+/**
+ * Cells with exactly n neighbours
+ */
+template <typename Word> inline Word hasCount(const Count<Word> &c, int n) {
+  if (n == 8) {
+    return c.eights;
+  }
+  Word match = (n & 1 ? c.ones : ~c.ones) & (n & 2 ? c.twos : ~c.twos) &
+               (n & 4 ? c.fours : ~c.fours);
+  // 8 has the three low bits clear too, every other count has one of them set
+  return n == 0 ? match & ~c.eights : match;
+}
+
+/**
+ * Cells with any of the neighbour counts in Counts, which can't be empty
+ */
+template <uint16_t Counts, typename Word>
+inline Word hasAnyCount(const Count<Word> &c) {
+  Word match = hasCount(c, std::countr_zero(Counts));
+  if constexpr ((Counts & (Counts - 1)) != 0) {
+    return match | hasAnyCount<Counts & (Counts - 1)>(c);
+  } else {
+    return match;
+  }
+}
+
+/**
+ * Kernel for one rule picked at compile time. Each count only gets looked
+ * for if the rule has it, so it comes out as straight line code with nothing
+ * left of the rule to check while it runs. Life itself goes to nextState().
+ */
+template <uint16_t Birth, uint16_t Survive> struct FixedRule {
+  static constexpr Rule rule{Birth, Survive};
+
+  template <typename Word>
+  Word operator()(Word topWest, Word top, Word topEast, Word currWest,
+                  Word curr, Word currEast, Word botWest, Word bot,
+                  Word botEast) const {
+    if constexpr (Birth == Rules::k_life.birth &&
+                  Survive == Rules::k_life.survive) {
+      return nextState(topWest, top, topEast, currWest, curr, currEast,
+                       botWest, bot, botEast);
+    } else {
+      Count<Word> c = countNeighbours(topWest, top, topEast, currWest,
+                                      currEast, botWest, bot, botEast);
+      constexpr uint16_t both = Birth & Survive;
+      constexpr uint16_t birthOnly = Birth & ~Survive;
+      constexpr uint16_t surviveOnly = Survive & ~Birth;
+
+      Word next = curr & ~curr;
+      if constexpr (both != 0) {
+        next = hasAnyCount<both>(c);
+      }
+      if constexpr (birthOnly != 0) {
+        next = next | (hasAnyCount<birthOnly>(c) & ~curr);
+      }
+      if constexpr (surviveOnly != 0) {
+        next = next | (hasAnyCount<surviveOnly>(c) & curr);
+      }
+      return next;
+    }
+  }
+};
+
+/**
+ * Kernel for any rule, going through the counts of the rule while it runs.
+ * About twice the work of a FixedRule but nothing has to be compiled for it.
+ */
+struct AnyRule {
+  Rule rule;
+
+  template <typename Word>
+  Word operator()(Word topWest, Word top, Word topEast, Word currWest,
+                  Word curr, Word currEast, Word botWest, Word bot,
+                  Word botEast) const {
+    Count<Word> c = countNeighbours(topWest, top, topEast, currWest, currEast,
+                                    botWest, bot, botEast);
+    Word born = curr & ~curr;
+    Word survives = born;
+    for (uint16_t counts = rule.birth | rule.survive; counts != 0;
+         counts &= counts - 1) {
+      int n = std::countr_zero(counts);
+      Word match = hasCount(c, n);
+      if (rule.birth >> n & 1) {
+        born = born | match;
+      }
+      if (rule.survive >> n & 1) {
+        survives = survives | match;
+      }
+    }
+    return (born & ~curr) | (survives & curr);
+  }
+};
+
+/**
+ * Calls f with the kernel for rule, a FixedRule for the ones in Rules and an
+ * AnyRule for everything else. Called once outside the loop over the rows the
+ * kernel gets inlined into all of it.
+ *
+ * The kernels only say which cells are alive next, so the number of states
+ * doesn't matter here and Brian's Brain gets the Seeds one.
+ */
+template <typename F> inline void withRule(const Rule &rule, F &&f) {
+  using namespace Rules;
+  auto is = [&rule](const Rule &other) {
+    return rule.birth == other.birth && rule.survive == other.survive;
+  };
+  if (is(k_life)) {
+    f(FixedRule<k_life.birth, k_life.survive>());
+  } else if (is(k_highLife)) {
+    f(FixedRule<k_highLife.birth, k_highLife.survive>());
+  } else if (is(k_seeds)) {
+    f(FixedRule<k_seeds.birth, k_seeds.survive>());
+  } else if (is(k_dayAndNight)) {
+    f(FixedRule<k_dayAndNight.birth, k_dayAndNight.survive>());
+  } else if (is(k_starWars)) {
+    f(FixedRule<k_starWars.birth, k_starWars.survive>());
+  } else {
+    f(AnyRule{rule});
+  }
+}
+
+} // namespace LifeKernel
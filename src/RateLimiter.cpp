@@ -0,0 +1,29 @@
+#include <algorithm>
+#include <thread>
+
+#include "RateLimiter.h"
+
+void RateLimiter::tick() {
+  double rate = m_rate.load(std::memory_order_relaxed);
+  Clock::time_point now = Clock::now();
+
+  if (rate > 0) {
+    if (m_next > now) {
+      std::this_thread::sleep_until(m_next);
+      now = Clock::now();
+    }
+    // Falling behind doesn't get made up with a burst afterwards
+    auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / rate));
+    m_next = std::max(m_next + period, now);
+  }
+
+  m_windowTicks++;
+  std::chrono::duration<double> window = now - m_windowStart;
+  if (window.count() >= 0.5) {
+    m_measured.store(m_windowTicks / window.count(),
+                     std::memory_order_relaxed);
+    m_windowStart = now;
+    m_windowTicks = 0;
+  }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Keeps something from happening more than a set number of times a second
+ * and measures how often it actually does. tick() is meant to be called from
+ * a single thread, the rate can be set and read from any.
+ */
+class RateLimiter {
+public:
+  /**
+   * 0 means no limit
+   */
+  explicit RateLimiter(double perSecond = 0) : m_rate(perSecond) {}
+
+  void setRate(double perSecond) { m_rate.store(perSecond); }
+  double getRate() const { return m_rate.load(); }
+
+  /**
+   * Waits until it is time for the next one, then counts it
+   */
+  void tick();
+
+  /**
+   * How many ticks a second there have been lately, updated about every half
+   * a second
+   */
+  double measured() const { return m_measured.load(); }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::atomic<double> m_rate;
+  std::atomic<double> m_measured{0};
+
+  Clock::time_point m_next = Clock::now();
+  Clock::time_point m_windowStart = Clock::now();
+  uint64_t m_windowTicks = 0;
+};
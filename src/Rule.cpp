@@ -0,0 +1,120 @@
+#include <bit>
+#include <cctype>
+#include <stdexcept>
+
+#include "Rule.h"
+
+Rule Rule::parse(const std::string &text) {
+  std::string r;
+  for (char c : text) {
+    if (!std::isspace(static_cast<unsigned char>(c))) {
+      r += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+  }
+
+  auto fail = [&]() {
+    throw std::invalid_argument("Not a B/S rule: " + text);
+  };
+  auto addCount = [&](uint16_t &mask, char c) {
+    if (c < '0' || c > '8') {
+      fail();
+    }
+    mask |= uint16_t(1) << (c - '0');
+  };
+
+  auto readStates = [&](uint16_t &states, const std::string &digits) {
+    if (digits.empty() || digits.size() > 3 ||
+        digits.find_first_not_of("0123456789") != std::string::npos) {
+      fail();
+    }
+    int n = std::stoi(digits);
+    if (n < 2 || n > k_maxStates) {
+      throw std::invalid_argument("Rules need 2 to " +
+                                  std::to_string(k_maxStates) +
+                                  " states: " + text);
+    }
+    states = static_cast<uint16_t>(n);
+  };
+
+  Rule rule{0, 0};
+  size_t slash = r.find('/');
+  if (r.find_first_of("bsc") == std::string::npos) {
+    // Survive first and then birth, without the letters the slash is needed
+    // to tell them apart. A Generations rule has the states after a second
+    // one.
+    if (slash == std::string::npos) {
+      fail();
+    }
+    size_t second = r.find('/', slash + 1);
+    size_t end = second == std::string::npos ? r.size() : second;
+    for (size_t i = 0; i < end; i++) {
+      if (i != slash) {
+        addCount(i < slash ? rule.survive : rule.birth, r[i]);
+      }
+    }
+    if (second != std::string::npos) {
+      readStates(rule.states, r.substr(second + 1));
+    }
+  } else {
+    // The letters say which is which so they can go in either order, with or
+    // without the slashes. The states have to be last.
+    uint16_t *part = nullptr;
+    bool seenBirth = false, seenSurvive = false;
+    for (size_t i = 0; i < r.size(); i++) {
+      char c = r[i];
+      if (c == 'b' && !seenBirth) {
+        seenBirth = true;
+        part = &rule.birth;
+      } else if (c == 's' && !seenSurvive) {
+        seenSurvive = true;
+        part = &rule.survive;
+      } else if (c == 'c' && seenBirth && seenSurvive) {
+        readStates(rule.states, r.substr(i + 1));
+        break;
+      } else if (c == '/' && part) {
+        part = nullptr;
+      } else if (part) {
+        addCount(*part, c);
+      } else {
+        fail();
+      }
+    }
+    if (!seenBirth || !seenSurvive) {
+      fail();
+    }
+  }
+
+  if (rule.birth & 1) {
+    throw std::invalid_argument("Rules with B0 aren't supported: " + text);
+  }
+  return rule;
+}
+
+std::string Rule::toString() const {
+  std::string text = "B";
+  for (int n = 0; n <= 8; n++) {
+    if (birth >> n & 1) {
+      text += static_cast<char>('0' + n);
+    }
+  }
+  text += "/S";
+  for (int n = 0; n <= 8; n++) {
+    if (survive >> n & 1) {
+      text += static_cast<char>('0' + n);
+    }
+  }
+  if (states > 2) {
+    text += "/C" + std::to_string(states);
+  }
+  return text;
+}
+
+std::array<bool, 512> Rule::table() const {
+  std::array<bool, 512> table{};
+  for (uint32_t i = 0; i < 512; i++) {
+    int neighbours = std::popcount(i & 0b111101111);
+    bool alive = i & 0b000010000;
+    table[i] = (alive ? survive : birth) >> neighbours & 1;
+  }
+  return table;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+/**
+ * An outer totalistic rule like B3/S23, where whether a cell is alive next
+ * generation only depends on whether it is alive now and how many of its
+ * eight neighbours are.
+ *
+ * Generations rules like Brian's Brain (B2/S/C3) have more than two states.
+ * A live cell that doesn't survive goes through the dying states 2 up to
+ * states - 1 one generation at a time before it is dead again. Dying cells
+ * don't count as neighbours and nothing can be born in them.
+ *
+ * Rules where a cell is born with no neighbours at all (B0) aren't allowed.
+ * Every engine counts on empty space staying empty, an infinite board would
+ * have to fill up everywhere at once.
+ */
+struct Rule {
+  // Bit n is set if a dead cell with n live neighbours is born
+  uint16_t birth = counts({3});
+  // Bit n is set if a live cell with n live neighbours stays alive
+  uint16_t survive = counts({2, 3});
+  // Number of states a cell can be in, 2 for dead and alive and no dying
+  uint16_t states = 2;
+  static constexpr uint16_t k_maxStates = 256;
+
+  bool operator==(const Rule &) const = default;
+
+  /**
+   * Reads a rule written as "B36/S23" or "S23/B36", with letters in either
+   * case, or the old survive first "23/36". Generations rules add the number
+   * of states as "B2/S/C3" or "/2/3".
+   *
+   * Throws std::invalid_argument if it isn't a rule, it has B0 or it has
+   * more than k_maxStates states.
+   */
+  static Rule parse(const std::string &text);
+  /**
+   * Written out as "B36/S23", or "B2/S/C3" with more than two states
+   */
+  std::string toString() const;
+
+  /**
+   * Whether a cell is alive next generation for each of the 512 ways it and
+   * its neighbours can be, bit 4 of the index being the cell itself
+   */
+  std::array<bool, 512> table() const;
+
+  static constexpr uint16_t counts(std::initializer_list<int> counts) {
+    uint16_t mask = 0;
+    for (int n : counts) {
+      mask |= uint16_t(1) << n;
+    }
+    return mask;
+  }
+};
+
+/**
+ * The rules that get kernels of their own, see LifeKernel::withRule()
+ */
+namespace Rules {
+constexpr Rule k_life{};
+constexpr Rule k_highLife{Rule::counts({3, 6}), Rule::counts({2, 3})};
+constexpr Rule k_seeds{Rule::counts({2}), 0};
+constexpr Rule k_dayAndNight{Rule::counts({3, 6, 7, 8}),
+                             Rule::counts({3, 4, 6, 7, 8})};
+// Generations rules, Brian's Brain steps the same as Seeds
+constexpr Rule k_briansBrain{Rule::counts({2}), 0, 3};
+constexpr Rule k_starWars{Rule::counts({2}), Rule::counts({3, 4, 5}), 4};
+} // namespace Rules
@@ -0,0 +1,76 @@
+#include "SimulationPipeline.h"
+
+SimulationPipeline::SimulationPipeline(LifeEngine &engine)
+    : m_engine(engine) {}
+
+SimulationPipeline::~SimulationPipeline() { stop(); }
+
+void SimulationPipeline::start() {
+  if (isRunning()) {
+    return;
+  }
+
+  m_stopping = false;
+  // Whatever is on the board now is the first thing to draw
+  publish();
+  m_thread = std::thread(&SimulationPipeline::run, this);
+}
+
+void SimulationPipeline::stop() {
+  if (!isRunning()) {
+    return;
+  }
+
+  m_stopping = true;
+  m_thread.join();
+}
+
+void SimulationPipeline::setViewport(int32_t x, int32_t y, int32_t width,
+                                     int32_t height, int64_t tileCells) {
+  std::lock_guard<std::mutex> lock(m_viewportMutex);
+  m_viewport = {x, y, width, height, tileCells};
+}
+
+const SimulationPipeline::Frame &SimulationPipeline::acquireFrame() {
+  m_buffer.update();
+  return m_buffer.front();
+}
+
+void SimulationPipeline::run() {
+  while (!m_stopping.load(std::memory_order_relaxed)) {
+    m_updates.tick();
+    m_engine.update();
+    m_generation.fetch_add(1, std::memory_order_relaxed);
+
+    // No point copying out frames faster than they are drawn
+    if (m_buffer.consumed()) {
+      publish();
+    }
+  }
+}
+
+void SimulationPipeline::publish() {
+  Viewport viewport;
+  {
+    std::lock_guard<std::mutex> lock(m_viewportMutex);
+    viewport = m_viewport;
+  }
+
+  Frame &frame = m_buffer.back();
+  frame.generation = m_generation.load(std::memory_order_relaxed);
+  frame.x = viewport.x;
+  frame.y = viewport.y;
+  frame.width = viewport.width;
+  frame.height = viewport.height;
+  if (viewport.tileCells > 0) {
+    m_engine.collectDensity(viewport.x, viewport.y, viewport.width,
+                            viewport.height, viewport.tileCells,
+                            frame.density);
+    frame.chunks.reset(0);
+  } else {
+    m_engine.collectChunks(viewport.x, viewport.y, viewport.width,
+                           viewport.height, frame.chunks);
+    frame.density.reset(0, 0, 0, 0, 0);
+  }
+  m_buffer.publish();
+}
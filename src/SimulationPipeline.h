@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "ChunkFrame.h"
+#include "DensityFrame.h"
+#include "LifeEngine.h"
+#include "RateLimiter.h"
+#include "TripleBuffer.h"
+
+/**
+ * Runs an engine on a thread of its own and hands finished generations over
+ * to the thread drawing them, so the simulation doesn't have to wait on the
+ * screen or the other way around.
+ *
+ * After each update the chunks in the viewport are copied into the back frame
+ * of a TripleBuffer and published, as long as the renderer has taken the one
+ * before it. The renderer always gets the newest published frame and can keep
+ * drawing it for as long as it wants while the simulation carries on.
+ *
+ * The engine belongs to the simulation thread between start() and stop(),
+ * nothing else can touch it in that time.
+ */
+class SimulationPipeline {
+public:
+  /**
+   * A generation as it was when it was published, the chunks with live cells
+   * in the viewport or, if the viewport asked for tiles, how many live cells
+   * each tile has. Whichever one wasn't asked for is empty with a chunk or
+   * tile size of 0.
+   */
+  struct Frame {
+    uint64_t generation = 0;
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    ChunkFrame chunks;
+    DensityFrame density;
+  };
+
+  explicit SimulationPipeline(LifeEngine &engine);
+  ~SimulationPipeline();
+
+  SimulationPipeline(const SimulationPipeline &) = delete;
+  const SimulationPipeline &operator=(const SimulationPipeline &) = delete;
+
+  void start();
+  /**
+   * Waits for the update that is going on to finish
+   */
+  void stop();
+  bool isRunning() const { return m_thread.joinable(); }
+
+  /**
+   * Most updates a second the simulation runs at, 0 is as fast as it can
+   */
+  void setUpdateRate(double perSecond) { m_updates.setRate(perSecond); }
+  /**
+   * Most frames a second frameDone() lets through, 0 leaves it to vsync
+   */
+  void setFrameRate(double perSecond) { m_frames.setRate(perSecond); }
+  /**
+   * Part of the board copied into frames, takes effect from the next one.
+   * With tileCells the frames get the density of tiles at least that big
+   * instead of the chunks.
+   */
+  void setViewport(int32_t x, int32_t y, int32_t width, int32_t height,
+                   int64_t tileCells = 0);
+
+  /**
+   * Render thread only. The newest published frame, it stays the same until
+   * the next call.
+   */
+  const Frame &acquireFrame();
+  /**
+   * Render thread only, call once a frame has been drawn. Waits out the rest
+   * of the frame if the frame rate is capped.
+   */
+  void frameDone() { m_frames.tick(); }
+
+  /**
+   * Generations the simulation has gone through since it was made
+   */
+  uint64_t getGeneration() const { return m_generation.load(); }
+  double measuredUpdateRate() const { return m_updates.measured(); }
+  double measuredFrameRate() const { return m_frames.measured(); }
+
+private:
+  struct Viewport {
+    int32_t x, y, width, height;
+    int64_t tileCells;
+  };
+
+  LifeEngine &m_engine;
+  std::thread m_thread;
+  std::atomic<bool> m_stopping = false;
+  std::atomic<uint64_t> m_generation = 0;
+
+  TripleBuffer<Frame> m_buffer;
+  RateLimiter m_updates;
+  RateLimiter m_frames;
+
+  std::mutex m_viewportMutex;
+  Viewport m_viewport{0, 0, 0, 0, 0};
+
+  void run();
+  void publish();
+};
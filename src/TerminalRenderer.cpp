@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+#include "TerminalRenderer.h"
+
+namespace {
+
+// Braille dot of each cell of a character by its row from the top, for the
+// two cells of the row being left, right or both
+constexpr uint8_t k_brailleDots[4][4] = {
+    {0, 0x01, 0x08, 0x09},
+    {0, 0x02, 0x10, 0x12},
+    {0, 0x04, 0x20, 0x24},
+    {0, 0x40, 0x80, 0xc0},
+};
+
+// Upper half, lower half and full block, in UTF-8
+constexpr const char *k_halfBlocks[4] = {" ", "\xe2\x96\x80", "\xe2\x96\x84",
+                                         "\xe2\x96\x88"};
+
+} // namespace
+
+TerminalRenderer::TerminalRenderer(int32_t columns, int32_t rows,
+                                   Glyphs glyphs)
+    : m_glyphs(glyphs), m_glyphWidth(glyphs == Glyphs::Braille ? 2 : 1),
+      m_glyphHeight(glyphs == Glyphs::Braille ? 4 : 2) {
+  resize(columns, rows);
+}
+
+void TerminalRenderer::resize(int32_t columns, int32_t rows) {
+  if (columns < 1 || rows < 1) {
+    throw std::invalid_argument("A terminal frame needs at least one "
+                                "character.");
+  }
+
+  m_columns = columns;
+  m_rows = rows;
+  m_bits.assign(LifeEngine::regionStride(getCellWidth()) * getCellHeight(), 0);
+  m_next.assign(size_t(columns) * rows, 0);
+  m_shown.assign(size_t(columns) * rows, 0);
+  // Enough for every character to be the longest glyph with a cursor move in
+  // front of each row, so drawing never has to grow it
+  m_out.reserve(size_t(columns) * rows * 3 + size_t(rows + 1) * 16 + 8);
+  m_valid = false;
+}
+
+const std::string &TerminalRenderer::render(LifeEngine &engine, int32_t x,
+                                            int32_t y) {
+  engine.getRegion(x, y, getCellWidth(), getCellHeight(), m_bits.data());
+  return finish();
+}
+
+const std::string &TerminalRenderer::render(const ChunkFrame &frame,
+                                            int32_t x, int32_t y) {
+  frame.getRegion(x, y, getCellWidth(), getCellHeight(), m_bits.data());
+  return finish();
+}
+
+void TerminalRenderer::present() {
+  std::cout.flush();
+
+#ifdef _WIN32
+  std::fwrite(m_out.data(), 1, m_out.size(), stdout);
+  std::fflush(stdout);
+#else
+  const char *data = m_out.data();
+  size_t left = m_out.size();
+  while (left > 0) {
+    ssize_t written = ::write(STDOUT_FILENO, data, left);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error("Couldn't write the frame to the terminal");
+    }
+    data += written;
+    left -= written;
+  }
+#endif
+}
+
+const std::string &TerminalRenderer::finish() {
+  buildGlyphs();
+
+  m_out.clear();
+  m_stats = Stats();
+  bool everything = !m_valid;
+  if (everything) {
+    m_out += "\033[2J";
+  }
+
+  for (int32_t row = 0; row < m_rows; row++) {
+    const uint8_t *next = m_next.data() + size_t(row) * m_columns;
+    const uint8_t *shown = m_shown.data() + size_t(row) * m_columns;
+
+    int32_t column = 0;
+    while (column < m_columns) {
+      if (!everything && next[column] == shown[column]) {
+        column++;
+        continue;
+      }
+
+      // Carry the span on over short runs of unchanged characters
+      int32_t last = column;
+      for (int32_t i = column + 1; i < m_columns; i++) {
+        if (everything || next[i] != shown[i]) {
+          last = i;
+        } else if (i - last > k_mergeGap) {
+          break;
+        }
+      }
+
+      appendPosition(row, column);
+      for (int32_t i = column; i <= last; i++) {
+        appendGlyph(next[i]);
+        m_stats.changedGlyphs += everything || next[i] != shown[i];
+      }
+      m_stats.spans++;
+      column = last + 1;
+    }
+  }
+
+  appendPosition(m_rows, 0);
+  m_next.swap(m_shown);
+  m_valid = true;
+  m_stats.bytes = m_out.size();
+  return m_out;
+}
+
+void TerminalRenderer::buildGlyphs() {
+  size_t stride = LifeEngine::regionStride(getCellWidth());
+  int32_t cellHeight = getCellHeight();
+  std::fill(m_next.begin(), m_next.end(), 0);
+
+  for (int32_t row = 0; row < m_rows; row++) {
+    uint8_t *glyphs = m_next.data() + size_t(row) * m_columns;
+    for (int32_t dotRow = 0; dotRow < m_glyphHeight; dotRow++) {
+      // The bitmap goes up from the bottom and the terminal down from the top
+      const uint64_t *bits =
+          m_bits.data() +
+          size_t(cellHeight - 1 - row * m_glyphHeight - dotRow) * stride;
+
+      if (m_glyphs == Glyphs::Braille) {
+        const uint8_t *dots = k_brailleDots[dotRow];
+        for (int32_t column = 0; column < m_columns; column++) {
+          // Both cells of a character are always in the same word
+          int32_t cell = column * 2;
+          glyphs[column] |= dots[bits[cell / 64] >> (cell % 64) & 3];
+        }
+      } else {
+        for (int32_t column = 0; column < m_columns; column++) {
+          glyphs[column] |= (bits[column / 64] >> (column % 64) & 1) << dotRow;
+        }
+      }
+    }
+  }
+}
+
+void TerminalRenderer::appendGlyph(uint8_t dots) {
+  if (dots == 0) {
+    m_out += ' ';
+  } else if (m_glyphs == Glyphs::HalfBlock) {
+    m_out += k_halfBlocks[dots];
+  } else {
+    // U+2800 plus the dots
+    m_out += '\xe2';
+    m_out += char(0xa0 | dots >> 6);
+    m_out += char(0x80 | (dots & 0x3f));
+  }
+}
+
+void TerminalRenderer::appendPosition(int32_t row, int32_t column) {
+  char number[16];
+  m_out += "\033[";
+  m_out.append(number, std::to_chars(number, number + 16, row + 1).ptr);
+  m_out += ';';
+  m_out.append(number, std::to_chars(number, number + 16, column + 1).ptr);
+  m_out += 'H';
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ChunkFrame.h"
+#include "LifeEngine.h"
+
+/**
+ * Draws part of a board on a terminal, several cells to a character.
+ *
+ * The frame is put together in buffers that are kept from one frame to the
+ * next and compared against what the terminal already shows, only the spans
+ * of characters that changed are sent, all in a single write. A board that is
+ * mostly still costs almost nothing to keep on the screen, even over ssh.
+ *
+ * Half blocks are 1x2 cells a character and braille 2x4, braille needs a
+ * font that has it but fits four times as much board on the screen.
+ */
+class TerminalRenderer {
+public:
+  enum class Glyphs { HalfBlock, Braille };
+
+  /**
+   * What the last render() did
+   */
+  struct Stats {
+    uint64_t bytes = 0;
+    uint32_t changedGlyphs = 0;
+    uint32_t spans = 0;
+  };
+
+  /**
+   * Draws on the columns x rows characters in the top left corner of the
+   * terminal. Throws std::invalid_argument if either is less than 1.
+   */
+  TerminalRenderer(int32_t columns, int32_t rows,
+                   Glyphs glyphs = Glyphs::Braille);
+
+  /**
+   * Changes the size, the next frame is drawn from scratch
+   */
+  void resize(int32_t columns, int32_t rows);
+  /**
+   * Forgets what is on the terminal so the next frame clears it and is drawn
+   * from scratch, for when something else wrote over it
+   */
+  void invalidate() { m_valid = false; }
+
+  /**
+   * Cells across and up the frame, with its bottom left corner at the x and
+   * y given to render()
+   */
+  int32_t getCellWidth() const { return m_columns * m_glyphWidth; }
+  int32_t getCellHeight() const { return m_rows * m_glyphHeight; }
+
+  /**
+   * Puts together the frame and gives back what has to be sent to the
+   * terminal to show it, which leaves the cursor at the start of the line
+   * under the frame. It counts as shown from here on, whether present() is
+   * called or not.
+   */
+  const std::string &render(LifeEngine &engine, int32_t x, int32_t y);
+  const std::string &render(const ChunkFrame &frame, int32_t x, int32_t y);
+
+  /**
+   * Writes out what the last render() gave back with one write to stdout,
+   * after flushing std::cout so nothing gets in between
+   */
+  void present();
+
+  const Stats &getStats() const { return m_stats; }
+
+private:
+  // Unchanged characters between two changed ones up to this many are sent
+  // again instead of moving the cursor over them, which takes more bytes
+  static constexpr int32_t k_mergeGap = 2;
+
+  Glyphs m_glyphs;
+  int32_t m_glyphWidth;
+  int32_t m_glyphHeight;
+  int32_t m_columns = 0;
+  int32_t m_rows = 0;
+
+  // Cells of the frame as a region bitmap
+  std::vector<uint64_t> m_bits;
+  // Dots of every character, row by row from the top, for the frame being
+  // put together and for what is on the terminal
+  std::vector<uint8_t> m_next;
+  std::vector<uint8_t> m_shown;
+  bool m_valid = false;
+  std::string m_out;
+  Stats m_stats;
+
+  /**
+   * Turns m_bits into m_next, then writes out the difference to m_shown
+   */
+  const std::string &finish();
+  void buildGlyphs();
+  void appendGlyph(uint8_t dots);
+  void appendPosition(int32_t row, int32_t column);
+};
@@ -0,0 +1,69 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+    : m_threadCount(std::max(threadCount, 1u)), m_barrier(m_threadCount) {
+  for (uint32_t i = 1; i < m_threadCount; i++) {
+    m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+
+  for (auto &worker : m_workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::run(const Task &task) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_task = &task;
+    m_running = m_threadCount - 1;
+    m_round++;
+  }
+  m_wake.notify_all();
+
+  task(0, m_threadCount);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this] { return m_running == 0; });
+  m_task = nullptr;
+}
+
+void ThreadPool::workerLoop(uint32_t thread) {
+  uint64_t seenRound = 0;
+
+  while (true) {
+    const Task *task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [&] { return m_stopping || m_round != seenRound; });
+      if (m_stopping) {
+        return;
+      }
+      seenRound = m_round;
+      task = m_task;
+    }
+
+    (*task)(thread, m_threadCount);
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_running--;
+    }
+    m_done.notify_one();
+  }
+}
+
+std::pair<size_t, size_t> ThreadPool::partition(size_t count, uint32_t thread,
+                                                 uint32_t threadCount) {
+  size_t begin = count * thread / threadCount;
+  size_t end = count * (thread + 1) / threadCount;
+  return {begin, end};
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <barrier>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * A fixed set of worker threads that stay around between calls to run(), so
+ * that a parallel update doesn't pay for starting threads every generation.
+ */
+class ThreadPool {
+public:
+  using Task = std::function<void(uint32_t thread, uint32_t threadCount)>;
+
+  /**
+   * threadCount includes the thread calling run(), so a pool of 1 starts no
+   * workers at all.
+   */
+  explicit ThreadPool(uint32_t threadCount);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  const ThreadPool &operator=(const ThreadPool &) = delete;
+
+  uint32_t size() const { return m_threadCount; }
+
+  /**
+   * Runs task on every thread of the pool, including the caller as thread 0,
+   * and returns once all of them are done.
+   */
+  void run(const Task &task);
+
+  /**
+   * Only to be called from inside a task. Blocks until every thread of the
+   * pool has reached it.
+   */
+  void sync() { m_barrier.arrive_and_wait(); }
+
+  /**
+   * The [begin, end) part of count items that thread should work on
+   */
+  static std::pair<size_t, size_t> partition(size_t count, uint32_t thread,
+                                             uint32_t threadCount);
+
+private:
+  uint32_t m_threadCount;
+  std::vector<std::thread> m_workers;
+  std::barrier<> m_barrier;
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  const Task *m_task = nullptr;
+  // Bumped for every run() so a worker knows there is new work
+  uint64_t m_round = 0;
+  uint32_t m_running = 0;
+  bool m_stopping = false;
+
+  void workerLoop(uint32_t thread);
+};
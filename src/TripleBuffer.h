@@ -0,0 +1,56 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Hands the latest value from one writing thread to one reading thread
+ * without either of them ever waiting on the other.
+ *
+ * Of the three slots the writer owns one (back), the reader owns one (front)
+ * and the third sits in the middle. publish() swaps back with the middle and
+ * marks it fresh, update() swaps a fresh middle with front. Both are a single
+ * atomic exchange so neither side ever sees a slot the other one is using.
+ * Values the reader didn't get to in time are just replaced.
+ */
+template <typename T> class TripleBuffer {
+public:
+  /**
+   * Writer side, the slot to fill in before publish()
+   */
+  T &back() { return m_slots[m_back]; }
+  void publish() {
+    m_back = m_middle.exchange(m_back | k_fresh, std::memory_order_acq_rel) &
+             k_index;
+  }
+  /**
+   * True once the reader has taken the last published value
+   */
+  bool consumed() const {
+    return !(m_middle.load(std::memory_order_relaxed) & k_fresh);
+  }
+
+  /**
+   * Reader side, moves front on to the newest published value if there is
+   * one, returns false if front is already the newest
+   */
+  bool update() {
+    if (consumed()) {
+      return false;
+    }
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & k_index;
+    return true;
+  }
+  const T &front() const { return m_slots[m_front]; }
+
+private:
+  static constexpr uint8_t k_index = 0b011;
+  static constexpr uint8_t k_fresh = 0b100;
+
+  std::array<T, 3> m_slots{};
+  // Each side's index on its own cache line so they don't bounce it back and
+  // forth
+  alignas(64) uint8_t m_back = 0;
+  alignas(64) uint8_t m_front = 1;
+  alignas(64) std::atomic<uint8_t> m_middle{2};
+};
@@ -0,0 +1,284 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * The parts of GameBoard::update() that get timed, in the order they run
+ */
+namespace UpdatePhase {
+enum Index : uint32_t {
+  // Copying in a lazy snapshot, logging edits and catching up the density
+  PREPARE,
+  // Working out which chunks get stepped and which get replayed
+  SPREAD,
+  // Deleting chunks that emptied out
+  SWEEP,
+  // makeBorderChunks() for chunks with cells next to a missing neighbour
+  BORDER_CHUNKS,
+  // readInBorder() of every chunk being stepped, until the last thread is
+  // done
+  READ_BORDERS,
+  // Stepping chunks and replaying parked ones, for the slowest thread
+  STEP,
+  REPLAY,
+  // Collecting flags and bringing versions, density and the delta log up to
+  // date
+  FINISH,
+  COUNT,
+};
+
+constexpr const char *k_names[COUNT] = {
+    "prepare",      "spread", "sweep",  "border chunks",
+    "read borders", "step",   "replay", "finish"};
+} // namespace UpdatePhase
+
+/**
+ * What GameBoard::update() counts each generation
+ */
+namespace UpdateCounter {
+enum Index : uint32_t {
+  // Chunks stepped and replayed, and how many of those came out empty
+  STEPPED,
+  REPLAYED,
+  EMPTY,
+  // Chunks made by makeBorderChunks() and deleted by the sweep
+  CREATED,
+  DELETED,
+  // Every chunk and live cell on the board once the update is done
+  CHUNKS,
+  POPULATION,
+  COUNT,
+};
+
+constexpr const char *k_names[COUNT] = {"stepped", "replayed", "empty",
+                                        "created", "deleted",  "chunks",
+                                        "population"};
+} // namespace UpdateCounter
+
+/**
+ * Times the phases of every GameBoard::update() and counts what they did,
+ * keeping the last k_capacity generations in a ring that other threads can
+ * poll while the board keeps going.
+ *
+ * Like funni::Logger whether it does anything is a template argument. With
+ * enabled false every call is an empty inline function and doesn't even
+ * read the clock, so the board builds into the same code as without it.
+ * Which one GameBoard gets is picked by GAME_OF_LIFE_PROFILE, see
+ * UpdateProfiler below.
+ *
+ * The board side (begin(), lap(), threadLap(), add() and end()) is only
+ * called from inside update(). poll(), histogram() and totals() can be
+ * called from any thread at any time.
+ */
+template <bool enabled> class BasicUpdateProfiler {
+public:
+  static constexpr bool k_enabled = enabled;
+  // Generations kept for poll(), older ones are dropped
+  static constexpr size_t k_capacity = 4096;
+  // Bucket b of a histogram counts times of [2^(b-1), 2^b) ns, the last
+  // one everything longer
+  static constexpr uint32_t k_buckets = 40;
+
+  /**
+   * One generation, the times in nanoseconds
+   */
+  struct Record {
+    uint64_t generation = 0;
+    uint64_t totalNanos = 0;
+    std::array<uint64_t, UpdatePhase::COUNT> nanos{};
+    std::array<uint64_t, UpdateCounter::COUNT> counters{};
+  };
+  using Histogram = std::array<uint64_t, k_buckets>;
+
+  BasicUpdateProfiler() {
+    if constexpr (enabled) {
+      m_shared = std::make_unique<Shared>();
+    }
+  }
+
+  /**
+   * Starts a generation stepped on threads threads, returns the mark for
+   * the first lap()
+   */
+  uint64_t begin(uint64_t generation, uint32_t threads) {
+    if constexpr (enabled) {
+      m_current = Record{};
+      m_current.generation = generation;
+      m_threadNanos.assign(threads, {});
+      m_start = m_last = now();
+      return m_start;
+    }
+    return 0;
+  }
+
+  /**
+   * Adds the time since mark to phase and returns the mark for the next
+   * one
+   */
+  uint64_t lap(UpdatePhase::Index phase, uint64_t mark) {
+    if constexpr (enabled) {
+      m_last = now();
+      m_current.nanos[phase] += m_last - mark;
+      return m_last;
+    }
+    return mark;
+  }
+  /**
+   * Same for a phase every thread of the pool runs its own share of, the
+   * record gets the slowest thread. Threads only touch their own slot.
+   */
+  uint64_t threadLap(uint32_t thread, UpdatePhase::Index phase,
+                     uint64_t mark) {
+    if constexpr (enabled) {
+      uint64_t time = now();
+      m_threadNanos[thread].nanos[phase] += time - mark;
+      return time;
+    }
+    return mark;
+  }
+
+  void add(UpdateCounter::Index counter, uint64_t amount = 1) {
+    if constexpr (enabled) {
+      m_current.counters[counter] += amount;
+    }
+  }
+  void set(UpdateCounter::Index counter, uint64_t value) {
+    if constexpr (enabled) {
+      m_current.counters[counter] = value;
+    }
+  }
+
+  /**
+   * Finishes the generation and puts it in the ring. The whole update is
+   * timed up to the last lap(), so counting things after it doesn't go in
+   * the total.
+   */
+  void end() {
+    if constexpr (enabled) {
+      for (const ThreadNanos &thread : m_threadNanos) {
+        for (uint32_t p = 0; p < UpdatePhase::COUNT; p++) {
+          m_current.nanos[p] = std::max(m_current.nanos[p], thread.nanos[p]);
+        }
+      }
+      m_current.totalNanos = m_last - m_start;
+
+      std::lock_guard lock(m_shared->mutex);
+      m_shared->ring[m_shared->written % k_capacity] = m_current;
+      m_shared->written++;
+      for (uint32_t p = 0; p < UpdatePhase::COUNT; p++) {
+        m_shared->histograms[p][bucket(m_current.nanos[p])]++;
+        m_shared->totals[p] += m_current.nanos[p];
+      }
+      m_shared->histograms[UpdatePhase::COUNT]
+                          [bucket(m_current.totalNanos)]++;
+      m_shared->totals[UpdatePhase::COUNT] += m_current.totalNanos;
+    }
+  }
+
+  /**
+   * Appends the generations recorded since cursor to out and moves cursor
+   * past them, start with a cursor of 0. Returns how many generations were
+   * dropped from the ring before they could be polled.
+   */
+  uint64_t poll(uint64_t &cursor, std::vector<Record> &out) const {
+    if constexpr (enabled) {
+      std::lock_guard lock(m_shared->mutex);
+      uint64_t written = m_shared->written;
+      uint64_t oldest = written > k_capacity ? written - k_capacity : 0;
+      uint64_t dropped = cursor < oldest ? oldest - cursor : 0;
+      for (cursor = std::max(cursor, oldest); cursor < written; cursor++) {
+        out.push_back(m_shared->ring[cursor % k_capacity]);
+      }
+      return dropped;
+    }
+    return 0;
+  }
+
+  /**
+   * How long phase took over every generation since the last reset(),
+   * UpdatePhase::COUNT for the whole update
+   */
+  Histogram histogram(uint32_t phase) const {
+    if constexpr (enabled) {
+      std::lock_guard lock(m_shared->mutex);
+      return m_shared->histograms[phase];
+    }
+    return {};
+  }
+  /**
+   * Nanoseconds spent in each phase since the last reset(), the whole
+   * update last
+   */
+  std::array<uint64_t, UpdatePhase::COUNT + 1> totals() const {
+    if constexpr (enabled) {
+      std::lock_guard lock(m_shared->mutex);
+      return m_shared->totals;
+    }
+    return {};
+  }
+  /**
+   * Empties the histograms and totals, the ring is left alone
+   */
+  void reset() {
+    if constexpr (enabled) {
+      std::lock_guard lock(m_shared->mutex);
+      m_shared->histograms = {};
+      m_shared->totals = {};
+    }
+  }
+
+  /**
+   * Steady clock in nanoseconds, 0 when disabled
+   */
+  static uint64_t now() {
+    if constexpr (enabled) {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+    }
+    return 0;
+  }
+  static uint32_t bucket(uint64_t nanos) {
+    return std::min<uint32_t>(std::bit_width(nanos), k_buckets - 1);
+  }
+
+private:
+  // Everything other threads read, behind a pointer so the board stays
+  // movable
+  struct Shared {
+    std::mutex mutex;
+    std::vector<Record> ring = std::vector<Record>(k_capacity);
+    uint64_t written = 0;
+    std::array<Histogram, UpdatePhase::COUNT + 1> histograms{};
+    std::array<uint64_t, UpdatePhase::COUNT + 1> totals{};
+  };
+  // On their own cache lines so the threads don't fight over them
+  struct alignas(64) ThreadNanos {
+    std::array<uint64_t, UpdatePhase::COUNT> nanos{};
+  };
+
+  std::unique_ptr<Shared> m_shared;
+  Record m_current;
+  std::vector<ThreadNanos> m_threadNanos;
+  uint64_t m_start = 0;
+  uint64_t m_last = 0;
+};
+
+#ifdef GAME_OF_LIFE_PROFILE
+constexpr bool k_profileUpdates = true;
+#else
+constexpr bool k_profileUpdates = false;
+#endif
+
+/**
+ * The one GameBoard uses, only does anything in builds with
+ * GAME_OF_LIFE_PROFILE defined (the CMake option of the same name)
+ */
+using UpdateProfiler = BasicUpdateProfiler<k_profileUpdates>;
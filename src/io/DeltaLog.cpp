@@ -0,0 +1,270 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "../ChunkMap.h"
+#include "DeltaLog.h"
+#include "Snapshot.h"
+
+namespace {
+
+void appendKey(std::vector<int32_t> &keys, ChunkKey key) {
+  keys.push_back(key.x);
+  keys.push_back(key.y);
+}
+
+template <typename T> void append(std::vector<std::byte> &out, const T &v) {
+  const auto *bytes = reinterpret_cast<const std::byte *>(&v);
+  out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+/**
+ * Reads count keys into keys, false if the file ends first
+ */
+bool readKeys(std::istream &in, uint32_t count, std::vector<ChunkKey> &keys) {
+  std::vector<int32_t> raw(size_t(count) * 2);
+  if (!in.read(reinterpret_cast<char *>(raw.data()),
+               raw.size() * sizeof(int32_t))) {
+    return false;
+  }
+
+  keys.clear();
+  for (size_t i = 0; i < raw.size(); i += 2) {
+    keys.push_back({raw[i], raw[i + 1]});
+  }
+  return true;
+}
+
+/**
+ * Chunk rows by key, the board as far as compact() has got
+ */
+class ChunkStore {
+public:
+  explicit ChunkStore(size_t chunkBytes) : m_chunkBytes(chunkBytes) {}
+
+  void set(ChunkKey key, const void *rows) {
+    const auto *bytes = static_cast<const std::byte *>(rows);
+    // Snapshots leave out chunks with nothing in them
+    bool any = false;
+    for (size_t i = 0; i < m_chunkBytes && !any; i++) {
+      any = bytes[i] != std::byte{0};
+    }
+    if (!any) {
+      erase(key);
+      return;
+    }
+
+    uint32_t slot;
+    if (const uint32_t *found = m_slots.find(key)) {
+      slot = *found;
+    } else if (!m_free.empty()) {
+      slot = m_free.back();
+      m_free.pop_back();
+      m_slots.insert(key, slot);
+    } else {
+      slot = static_cast<uint32_t>(m_rows.size() / m_chunkBytes);
+      m_rows.resize(m_rows.size() + m_chunkBytes);
+      m_slots.insert(key, slot);
+    }
+    std::memcpy(m_rows.data() + slot * m_chunkBytes, rows, m_chunkBytes);
+  }
+
+  void erase(ChunkKey key) {
+    if (const uint32_t *found = m_slots.find(key)) {
+      m_free.push_back(*found);
+      m_slots.erase(key);
+    }
+  }
+
+  void write(const std::string &path, uint32_t chunkSize, uint32_t rowBytes,
+             uint64_t generation) const {
+    std::vector<ChunkMap<uint32_t>::Entry> entries = m_slots.spatialOrder();
+    std::vector<ChunkKey> keys;
+    keys.reserve(entries.size());
+    for (auto [key, slot] : entries) {
+      keys.push_back(key);
+    }
+
+    Snapshot::Writer writer(path, chunkSize, rowBytes, generation, keys);
+    for (auto [key, slot] : entries) {
+      writer.writeRows(m_rows.data() + slot * m_chunkBytes);
+    }
+    writer.finish();
+  }
+
+private:
+  size_t m_chunkBytes;
+  ChunkMap<uint32_t> m_slots;
+  std::vector<std::byte> m_rows;
+  std::vector<uint32_t> m_free;
+};
+
+} // namespace
+
+namespace DeltaLog {
+
+Writer::Writer(const std::string &path, uint32_t chunkSize, uint32_t rowBytes,
+               uint64_t baseGeneration)
+    : m_out(path, std::ios::binary | std::ios::trunc), m_path(path),
+      m_chunkBytes(size_t(chunkSize) * rowBytes) {
+  if (!m_out) {
+    throw std::runtime_error("Failed to open " + path + " for writing");
+  }
+
+  Header header{};
+  std::memcpy(header.magic, k_magic, sizeof(k_magic));
+  header.version = k_version;
+  header.byteOrder = k_byteOrder;
+  header.chunkSize = chunkSize;
+  header.rowBytes = rowBytes;
+  header.baseGeneration = baseGeneration;
+  m_out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  m_out.flush();
+  if (!m_out) {
+    throw std::runtime_error("Failed to write " + path);
+  }
+}
+
+void Writer::addCreated(ChunkKey key) { appendKey(m_created, key); }
+
+void Writer::addDeleted(ChunkKey key) { appendKey(m_deleted, key); }
+
+void Writer::addRows(ChunkKey key, const void *rows) {
+  append(m_changed, key.x);
+  append(m_changed, key.y);
+  const auto *bytes = static_cast<const std::byte *>(rows);
+  m_changed.insert(m_changed.end(), bytes, bytes + m_chunkBytes);
+  m_changedCount++;
+}
+
+void Writer::writeRecord(uint64_t generation) {
+  RecordHeader header{generation,
+                      static_cast<uint32_t>(m_created.size() / 2),
+                      static_cast<uint32_t>(m_deleted.size() / 2),
+                      m_changedCount, 0};
+
+  m_out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  m_out.write(reinterpret_cast<const char *>(m_created.data()),
+              m_created.size() * sizeof(int32_t));
+  m_out.write(reinterpret_cast<const char *>(m_deleted.data()),
+              m_deleted.size() * sizeof(int32_t));
+  m_out.write(reinterpret_cast<const char *>(m_changed.data()),
+              m_changed.size());
+  m_out.flush();
+  if (!m_out) {
+    throw std::runtime_error("Failed to write " + m_path);
+  }
+
+  m_created.clear();
+  m_deleted.clear();
+  m_changed.clear();
+  m_changedCount = 0;
+}
+
+Reader::Reader(const std::string &path) : m_in(path, std::ios::binary) {
+  if (!m_in) {
+    throw std::runtime_error("Failed to open " + path);
+  }
+  if (!m_in.read(reinterpret_cast<char *>(&m_header), sizeof(Header)) ||
+      std::memcmp(m_header.magic, k_magic, sizeof(k_magic)) != 0) {
+    throw std::runtime_error(path + " isn't a delta log");
+  }
+  if (m_header.version != k_version) {
+    throw std::runtime_error(path + " is delta log version " +
+                             std::to_string(m_header.version) +
+                             ", only version " + std::to_string(k_version) +
+                             " can be read");
+  }
+  if (m_header.byteOrder != k_byteOrder) {
+    throw std::runtime_error(path + " was written with another byte order");
+  }
+
+  m_chunkBytes = size_t(m_header.chunkSize) * m_header.rowBytes;
+  m_in.seekg(0, std::ios::end);
+  m_size = static_cast<uint64_t>(m_in.tellg());
+  m_in.seekg(sizeof(Header));
+}
+
+bool Reader::next(Record &record) {
+  RecordHeader header;
+  if (!m_in.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    return false;
+  }
+
+  // Counts asking for more than what's left of the file are a record cut
+  // short (or a corrupt one), there's nothing to make room for
+  constexpr uint64_t keyBytes = sizeof(int32_t) * 2;
+  uint64_t left = m_size - static_cast<uint64_t>(m_in.tellg());
+  uint64_t keys = uint64_t(header.created) + header.deleted;
+  if (keys > left / keyBytes) {
+    return false;
+  }
+  left -= keys * keyBytes;
+  if (header.changed != 0 &&
+      (m_chunkBytes > left ||
+       header.changed > left / (keyBytes + m_chunkBytes))) {
+    return false;
+  }
+
+  if (!readKeys(m_in, header.created, record.created) ||
+      !readKeys(m_in, header.deleted, record.deleted)) {
+    return false;
+  }
+
+  record.generation = header.generation;
+  record.chunkBytes = m_chunkBytes;
+  record.changed.clear();
+  record.rows.resize(size_t(header.changed) * m_chunkBytes);
+  for (uint32_t i = 0; i < header.changed; i++) {
+    int32_t key[2];
+    if (!m_in.read(reinterpret_cast<char *>(key), sizeof(key)) ||
+        !m_in.read(reinterpret_cast<char *>(record.rows.data() +
+                                            i * m_chunkBytes),
+                   m_chunkBytes)) {
+      return false;
+    }
+    record.changed.push_back({key[0], key[1]});
+  }
+  return true;
+}
+
+uint64_t compact(const std::string &snapshotPath, const std::string &logPath,
+                 const std::string &outPath) {
+  Snapshot::View base(snapshotPath);
+  Reader log(logPath);
+  const Snapshot::Header &header = base.header();
+  if (header.chunkSize != log.header().chunkSize ||
+      header.rowBytes != log.header().rowBytes ||
+      header.generation != log.header().baseGeneration) {
+    throw std::runtime_error(logPath + " doesn't start from " + snapshotPath);
+  }
+
+  size_t chunkBytes = size_t(header.chunkSize) * header.rowBytes;
+  ChunkStore store(chunkBytes);
+  for (size_t i = 0; i < base.size(); i++) {
+    store.set(base.key(i), base.rows(i));
+  }
+
+  // Made chunks are empty so only deletions and rows matter here
+  uint64_t generation = header.generation;
+  Record record;
+  while (log.next(record)) {
+    for (ChunkKey key : record.deleted) {
+      store.erase(key);
+    }
+    for (size_t i = 0; i < record.changed.size(); i++) {
+      store.set(record.changed[i], record.rowsOf(i));
+    }
+    generation = record.generation;
+  }
+
+  store.write(outPath, header.chunkSize, header.rowBytes, generation);
+  return generation;
+}
+
+std::future<uint64_t> compactAsync(std::string snapshotPath,
+                                   std::string logPath, std::string outPath) {
+  return std::async(std::launch::async, compact, std::move(snapshotPath),
+                    std::move(logPath), std::move(outPath));
+}
+
+} // namespace DeltaLog
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "../ChunkKey.h"
+
+/**
+ * Append only log of what changed on a board, one record per generation, to
+ * go along with a Snapshot taken at the generation the log starts at.
+ *
+ * The file is a Header and then the records one after the other. A record is
+ * a RecordHeader, the keys of the chunks made and deleted in that generation
+ * and then every chunk whose rows changed as its key followed by all of its
+ * rows, laid out the same way as in a snapshot. Cells set between updates go
+ * in a record of their own with the generation they were set in, so there can
+ * be two records for a generation. Applying every record up to and including
+ * the ones for generation n gives the board at n.
+ *
+ * Only whole records count, one cut short at the end of the file (like when
+ * the program died writing it) is ignored.
+ */
+namespace DeltaLog {
+
+constexpr char k_magic[8] = {'G', 'O', 'L', 'D', 'E', 'L', 'T', 'A'};
+constexpr uint32_t k_version = 1;
+constexpr uint32_t k_byteOrder = 0x01020304;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t chunkSize;
+  uint32_t rowBytes;
+  // Generation of the snapshot the log starts from
+  uint64_t baseGeneration;
+};
+
+struct RecordHeader {
+  uint64_t generation;
+  uint32_t created;
+  uint32_t deleted;
+  uint32_t changed;
+  uint32_t padding;
+};
+
+struct Record {
+  uint64_t generation = 0;
+  std::vector<ChunkKey> created;
+  std::vector<ChunkKey> deleted;
+  std::vector<ChunkKey> changed;
+  // Rows of changed, chunkBytes for each of them
+  std::vector<std::byte> rows;
+  size_t chunkBytes = 0;
+
+  const void *rowsOf(size_t i) const { return rows.data() + i * chunkBytes; }
+};
+
+/**
+ * Builds up a record at a time and appends it to the log, flushing it out
+ * right away so a crash only loses the generation being written
+ */
+class Writer {
+public:
+  /**
+   * Starts a new log at path, throws std::runtime_error if it can't be
+   * written
+   */
+  Writer(const std::string &path, uint32_t chunkSize, uint32_t rowBytes,
+         uint64_t baseGeneration);
+
+  void addCreated(ChunkKey key);
+  void addDeleted(ChunkKey key);
+  void addRows(ChunkKey key, const void *rows);
+  /**
+   * Writes out what was added since the last record as the record for
+   * generation. Throws std::runtime_error if the write failed.
+   */
+  void writeRecord(uint64_t generation);
+
+private:
+  std::ofstream m_out;
+  std::string m_path;
+  size_t m_chunkBytes;
+  std::vector<int32_t> m_created;
+  std::vector<int32_t> m_deleted;
+  std::vector<std::byte> m_changed;
+  uint32_t m_changedCount = 0;
+};
+
+/**
+ * Reads the records of a log front to back
+ */
+class Reader {
+public:
+  /**
+   * Throws std::runtime_error if the file isn't a log that this version and
+   * this machine can read. Only the records already in the file when it's
+   * opened get read.
+   */
+  explicit Reader(const std::string &path);
+
+  const Header &header() const { return m_header; }
+
+  /**
+   * Reads the next record into record, false once there are no more whole
+   * records
+   */
+  bool next(Record &record);
+
+private:
+  std::ifstream m_in;
+  Header m_header;
+  size_t m_chunkBytes;
+  // Size of the file when it was opened, records can't be any bigger than
+  // what's left of it
+  uint64_t m_size;
+};
+
+/**
+ * Folds every record of the log at logPath into the snapshot at
+ * snapshotPath, writing the board as of the end of the log to a new snapshot
+ * at outPath. The log has to start at the generation of the snapshot and
+ * can't still be getting written. Gives back the generation of the new
+ * snapshot.
+ *
+ * Throws std::runtime_error if the files can't be read or written or don't
+ * go together.
+ */
+uint64_t compact(const std::string &snapshotPath, const std::string &logPath,
+                 const std::string &outPath);
+/**
+ * compact() on a thread of its own
+ */
+std::future<uint64_t> compactAsync(std::string snapshotPath,
+                                   std::string logPath, std::string outPath);
+
+} // namespace DeltaLog
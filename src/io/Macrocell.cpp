@@ -0,0 +1,289 @@
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../HashLife.h"
+#include "Macrocell.h"
+#include "Rle.h"
+
+namespace {
+
+constexpr uint32_t k_leafLevel = 3;
+constexpr int32_t k_leafSize = 1 << k_leafLevel;
+
+/**
+ * Cell of a leaf, x going right and y going up from the bottom left
+ */
+bool leafCell(const HashLife &tree, uint32_t node, int32_t x, int32_t y) {
+  for (uint32_t level = k_leafLevel; level > 0; level--) {
+    int32_t half = 1 << (level - 1);
+    bool east = x >= half;
+    bool north = y >= half;
+    node = tree.getChild(node, HashLife::Quadrant((north ? 0 : 2) + east));
+    x -= east ? half : 0;
+    y -= north ? half : 0;
+  }
+  return node == HashLife::k_alive;
+}
+
+/**
+ * Builds the node for the square of cells with its top left corner at (x, y)
+ * in rows, row 0 being the top
+ */
+uint32_t makeSquare(HashLife &tree, const bool (&rows)[k_leafSize][k_leafSize],
+                    uint32_t level, int32_t x, int32_t y) {
+  if (level == 0) {
+    return rows[y][x] ? HashLife::k_alive : HashLife::k_dead;
+  }
+
+  int32_t half = 1 << (level - 1);
+  return tree.makeNode(makeSquare(tree, rows, level - 1, x, y),
+                       makeSquare(tree, rows, level - 1, x + half, y),
+                       makeSquare(tree, rows, level - 1, x, y + half),
+                       makeSquare(tree, rows, level - 1, x + half, y + half));
+}
+
+uint32_t parseLeaf(HashLife &tree, const std::string &line) {
+  bool rows[k_leafSize][k_leafSize] = {};
+  int32_t x = 0, y = 0;
+
+  for (char c : line) {
+    if (c == '$') {
+      x = 0;
+      y++;
+      continue;
+    }
+    if (x >= k_leafSize || y >= k_leafSize) {
+      throw std::runtime_error("Macrocell leaf is bigger than 8x8: " + line);
+    }
+    if (c == '*') {
+      rows[y][x] = true;
+    } else if (c != '.') {
+      throw std::runtime_error("Bad Macrocell leaf: " + line);
+    }
+    x++;
+  }
+
+  return makeSquare(tree, rows, k_leafLevel, 0, 0);
+}
+
+uint32_t parseNode(HashLife &tree, const std::string &line,
+                   const std::vector<uint32_t> &nodes) {
+  std::istringstream fields(line);
+  uint32_t level;
+  uint64_t ids[4];
+  if (!(fields >> level >> ids[0] >> ids[1] >> ids[2] >> ids[3])) {
+    throw std::runtime_error("Bad Macrocell node: " + line);
+  }
+  if (level <= k_leafLevel || level > HashLife::k_maxLevel) {
+    throw std::runtime_error("Macrocell node level " + std::to_string(level) +
+                             " isn't supported (only 2 state patterns are)");
+  }
+
+  uint32_t children[4];
+  for (int i = 0; i < 4; i++) {
+    if (ids[i] == 0) {
+      children[i] = tree.emptyNode(level - 1);
+    } else if (ids[i] < nodes.size() &&
+               tree.getLevel(nodes[ids[i]]) == level - 1) {
+      children[i] = nodes[ids[i]];
+    } else {
+      throw std::runtime_error("Bad Macrocell child in: " + line);
+    }
+  }
+
+  return tree.makeNode(children[0], children[1], children[2], children[3]);
+}
+
+/**
+ * Sets the live cells of node on engine, with its bottom left corner at
+ * (x, y)
+ */
+void copyCells(const HashLife &tree, uint32_t node, int64_t x, int64_t y,
+               LifeEngine &engine) {
+  if (tree.getPopulation(node) == 0) {
+    return;
+  }
+
+  uint32_t level = tree.getLevel(node);
+  if (level > k_leafLevel) {
+    int64_t half = int64_t(1) << (level - 1);
+    copyCells(tree, tree.getChild(node, HashLife::NW), x, y + half, engine);
+    copyCells(tree, tree.getChild(node, HashLife::NE), x + half, y + half,
+              engine);
+    copyCells(tree, tree.getChild(node, HashLife::SW), x, y, engine);
+    copyCells(tree, tree.getChild(node, HashLife::SE), x + half, y, engine);
+    return;
+  }
+
+  if (x < std::numeric_limits<int32_t>::min() ||
+      y < std::numeric_limits<int32_t>::min() ||
+      x + k_leafSize - 1 > std::numeric_limits<int32_t>::max() ||
+      y + k_leafSize - 1 > std::numeric_limits<int32_t>::max()) {
+    throw std::out_of_range("Macrocell pattern doesn't fit on the board");
+  }
+
+  for (int32_t row = 0; row < k_leafSize; row++) {
+    int32_t runStart = 0;
+    for (int32_t col = 0; col <= k_leafSize; col++) {
+      bool alive = col < k_leafSize && leafCell(tree, node, col, row);
+      if (!alive) {
+        if (col > runStart) {
+          engine.setRun(static_cast<int32_t>(x + runStart),
+                        static_cast<int32_t>(y + row), col - runStart, true);
+        }
+        runStart = col + 1;
+      }
+    }
+  }
+}
+
+/**
+ * Writes node and everything under it that isn't written yet, gives back its
+ * line number
+ */
+uint64_t writeNode(std::ostream &out, const HashLife &tree, uint32_t node,
+                   std::unordered_map<uint32_t, uint64_t> &ids) {
+  if (tree.getPopulation(node) == 0) {
+    return 0;
+  }
+  if (auto found = ids.find(node); found != ids.end()) {
+    return found->second;
+  }
+
+  uint32_t level = tree.getLevel(node);
+  if (level == k_leafLevel) {
+    // Dots at the end of a row and empty rows at the bottom are left out
+    std::string leaf, pendingRows;
+    for (int32_t y = k_leafSize - 1; y >= 0; y--) {
+      std::string row;
+      for (int32_t x = 0; x < k_leafSize; x++) {
+        row += leafCell(tree, node, x, y) ? '*' : '.';
+      }
+      row.erase(row.find_last_not_of('.') + 1);
+
+      pendingRows += row + '$';
+      if (!row.empty()) {
+        leaf += pendingRows;
+        pendingRows.clear();
+      }
+    }
+    out << leaf << '\n';
+  } else {
+    uint64_t children[4];
+    for (uint32_t q = HashLife::NW; q <= HashLife::SE; q++) {
+      uint32_t child = tree.getChild(node, HashLife::Quadrant(q));
+      children[q] = writeNode(out, tree, child, ids);
+    }
+    out << level << ' ' << children[0] << ' ' << children[1] << ' '
+        << children[2] << ' ' << children[3] << '\n';
+  }
+
+  uint64_t id = ids.size() + 1;
+  ids[node] = id;
+  return id;
+}
+
+} // namespace
+
+namespace Macrocell {
+
+void read(std::istream &in, LifeEngine &engine) {
+  HashLife *target = dynamic_cast<HashLife *>(&engine);
+  bool direct = target && target->getPopulation() == 0;
+  HashLife scratch;
+  HashLife &tree = direct ? *target : scratch;
+
+  // Line number to node, 0 is the empty square of whatever level
+  std::vector<uint32_t> nodes(1, 0);
+  std::string line;
+  bool header = false;
+  // Files without a rule line are Life
+  Rule rule;
+
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+
+    if (!header) {
+      if (line.rfind("[M2]", 0) != 0) {
+        throw std::runtime_error("Not a Macrocell file, missing [M2]");
+      }
+      header = true;
+    } else if (line.empty()) {
+      continue;
+    } else if (line[0] == '#') {
+      if (line.rfind("#R", 0) == 0) {
+        rule = Rule::parse(line.substr(2));
+      }
+    } else if (line[0] == '.' || line[0] == '*' || line[0] == '$') {
+      nodes.push_back(parseLeaf(tree, line));
+    } else {
+      nodes.push_back(parseNode(tree, line, nodes));
+    }
+  }
+
+  if (!header) {
+    throw std::runtime_error("Not a Macrocell file, missing [M2]");
+  }
+  engine.setRule(rule);
+  if (nodes.size() == 1) {
+    return;
+  }
+
+  tree.setRoot(nodes.back());
+  if (!direct) {
+    uint32_t root = tree.getRoot();
+    int64_t half = int64_t(1) << (tree.getLevel(root) - 1);
+    copyCells(tree, root, -half, -half, engine);
+  }
+}
+
+void write(std::ostream &out, LifeEngine &engine) {
+  if (engine.getRule().states > 2) {
+    throw std::invalid_argument("Macrocell files only have live cells, " +
+                                engine.getRule().toString() +
+                                " has dying ones too");
+  }
+
+  HashLife *source = dynamic_cast<HashLife *>(&engine);
+  HashLife scratch;
+
+  if (!source) {
+    // Copied over a row at a time
+    if (std::optional<LifeEngine::Bounds> bounds = engine.getBounds()) {
+      int64_t width = bounds->maxX - bounds->minX + 1;
+      if (width > std::numeric_limits<int32_t>::max()) {
+        throw std::out_of_range("Pattern is too wide to copy");
+      }
+
+      std::vector<uint64_t> row(LifeEngine::regionStride(width));
+      for (int64_t y = bounds->minY; y <= bounds->maxY; y++) {
+        auto x = static_cast<int32_t>(bounds->minX);
+        engine.getRegion(x, static_cast<int32_t>(y),
+                         static_cast<int32_t>(width), 1, row.data());
+        scratch.setRowBits(x, static_cast<int32_t>(y), row.data(),
+                           static_cast<int32_t>(width));
+      }
+    }
+    source = &scratch;
+  }
+
+  out << "[M2] (Game_Of_Life)\n#R " << engine.getRule().toString() << '\n';
+  if (source->getGeneration() > 0) {
+    out << "#G " << source->getGeneration() << '\n';
+  }
+
+  std::unordered_map<uint32_t, uint64_t> ids;
+  writeNode(out, *source, source->getRoot(), ids);
+}
+
+} // namespace Macrocell
@@ -0,0 +1,43 @@
+#pragma once
+#include <iosfwd>
+
+#include "../LifeEngine.h"
+
+/**
+ * Golly's Macrocell format, a HashLife tree written out node by node so huge
+ * but repetitive patterns stay small.
+ *
+ * After a "[M2]" line and "#" comment lines every line is a node. Leaves are
+ * 8x8 squares written as rows of '.' and '*' ended by '$', from the top down.
+ * Other nodes are "level nw ne sw se" where the children are the line number
+ * of an earlier node (starting at 1, not counting the header and comments) or
+ * 0 for an empty square. The last node is the whole pattern, centered on
+ * (0, 0).
+ */
+namespace Macrocell {
+
+/**
+ * Reads a pattern from in and switches engine to its rule. A HashLife with
+ * nothing in it just takes the tree as is, anything else gets the live cells
+ * added a row at a time.
+ *
+ * The file is streamed a line at a time but the nodes have to be kept since
+ * any later one can point back at them, so memory goes with the number of
+ * distinct nodes and not the size of the file or the pattern.
+ *
+ * Throws std::runtime_error if the file is malformed, std::invalid_argument if
+ * its rule isn't one Rule::parse() can read and std::out_of_range if a
+ * pattern read into anything but a HashLife doesn't fit on the board.
+ */
+void read(std::istream &in, LifeEngine &engine);
+
+/**
+ * Writes all the live cells of engine and its rule. A HashLife is written
+ * straight from its tree, anything else is copied into one first.
+ *
+ * Throws std::invalid_argument if the rule has more than two states, there's
+ * nowhere to put the dying cells.
+ */
+void write(std::ostream &out, LifeEngine &engine);
+
+} // namespace Macrocell
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * A whole file mapped read only into memory. Pages are only read from disk
+ * when they are first touched.
+ */
+class MappedFile {
+public:
+  enum class Access {
+    // The whole file is going to be read front to back
+    SEQUENTIAL,
+    // Only bits and pieces of it are going to be read
+    RANDOM,
+  };
+
+  /**
+   * Throws std::runtime_error if the file can't be opened or mapped
+   */
+  explicit MappedFile(const std::string &path,
+                      Access access = Access::SEQUENTIAL);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  const MappedFile &operator=(const MappedFile &) = delete;
+
+  const std::byte *data() const { return m_data; }
+  size_t size() const { return m_size; }
+
+private:
+  const std::byte *m_data = nullptr;
+  size_t m_size = 0;
+#ifdef _WIN32
+  void *m_file = nullptr;
+  void *m_mapping = nullptr;
+#endif
+};
@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstdio>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Rle.h"
+
+namespace {
+
+/**
+ * Reads in through a fixed size buffer a character at a time
+ */
+class BufferedReader {
+public:
+  explicit BufferedReader(std::istream &in) : m_in(in), m_buffer(1 << 16) {}
+
+  int peek() {
+    if (m_pos == m_end && !fill()) {
+      return EOF;
+    }
+    return static_cast<unsigned char>(m_buffer[m_pos]);
+  }
+
+  int get() {
+    if (m_pos == m_end && !fill()) {
+      return EOF;
+    }
+    return static_cast<unsigned char>(m_buffer[m_pos++]);
+  }
+
+  std::string getLine() {
+    std::string line;
+    for (int c = get(); c != EOF && c != '\n'; c = get()) {
+      line += static_cast<char>(c);
+    }
+    return line;
+  }
+
+private:
+  std::istream &m_in;
+  std::vector<char> m_buffer;
+  size_t m_pos = 0;
+  size_t m_end = 0;
+
+  bool fill() {
+    m_in.read(m_buffer.data(), m_buffer.size());
+    m_pos = 0;
+    m_end = static_cast<size_t>(m_in.gcount());
+    return m_end != 0;
+  }
+};
+
+std::string trim(const std::string &s) {
+  size_t first = s.find_first_not_of(" \t\r");
+  if (first == std::string::npos) {
+    return "";
+  }
+  return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+}
+
+/**
+ * Fills in the header from a "x = 3, y = 3, rule = B3/S23" line
+ */
+void parseHeader(const std::string &line, Rle::Header &header) {
+  size_t start = 0;
+  while (start <= line.size()) {
+    size_t end = std::min(line.find(',', start), line.size());
+    std::string field = line.substr(start, end - start);
+    start = end + 1;
+
+    size_t equals = field.find('=');
+    if (equals == std::string::npos) {
+      throw std::runtime_error("Bad RLE header: " + line);
+    }
+    std::string key = trim(field.substr(0, equals));
+    std::string value = trim(field.substr(equals + 1));
+
+    try {
+      if (key == "x") {
+        header.width = std::stoll(value);
+      } else if (key == "y") {
+        header.height = std::stoll(value);
+      } else if (key == "rule") {
+        header.rule = value;
+      }
+    } catch (const std::logic_error &) {
+      throw std::runtime_error("Bad RLE header: " + line);
+    }
+  }
+}
+
+/**
+ * Adds a token to the pattern, keeping lines under 70 characters like
+ * everything else that writes RLE
+ */
+class LineWriter {
+public:
+  explicit LineWriter(std::ostream &out) : m_out(out) {}
+
+  void add(int64_t count, char tag) {
+    std::string token = count > 1 ? std::to_string(count) + tag
+                                   : std::string(1, tag);
+    if (m_length + token.size() > k_maxLine) {
+      m_out << '\n';
+      m_length = 0;
+    }
+    m_out << token;
+    m_length += token.size();
+  }
+
+private:
+  static constexpr size_t k_maxLine = 70;
+
+  std::ostream &m_out;
+  size_t m_length = 0;
+};
+
+/**
+ * Puts the runs of a row together into a bitmap so the engine can set them
+ * all at once. Rows wider than the bitmap are handed over a piece at a time.
+ */
+class RowCollector {
+public:
+  explicit RowCollector(LifeEngine &engine)
+      : m_engine(engine), m_bits(k_maxBits / 64) {}
+
+  void add(int64_t x, int64_t y, int64_t length) {
+    // Without a row yet m_left means nothing, the first run always starts
+    // one
+    if (!m_y || y != *m_y || x + length - m_left > k_maxBits) {
+      flush();
+      m_left = x;
+      m_y = y;
+    }
+
+    // A run too long to fit is set on its own
+    if (length > k_maxBits) {
+      m_engine.setRun(static_cast<int32_t>(x), static_cast<int32_t>(y),
+                      static_cast<int32_t>(length), true);
+      return;
+    }
+
+    for (int64_t i = x - m_left; i < x - m_left + length; i++) {
+      m_bits[i / 64] |= uint64_t(1) << (i % 64);
+    }
+    m_width = std::max(m_width, x - m_left + length);
+  }
+
+  void flush() {
+    if (m_width == 0) {
+      return;
+    }
+
+    m_engine.setRowBits(static_cast<int32_t>(m_left),
+                        static_cast<int32_t>(*m_y), m_bits.data(),
+                        static_cast<int32_t>(m_width));
+    std::fill(m_bits.begin(), m_bits.begin() + (m_width + 63) / 64, 0);
+    m_width = 0;
+  }
+
+private:
+  static constexpr int64_t k_maxBits = 1 << 16;
+
+  LifeEngine &m_engine;
+  std::vector<uint64_t> m_bits;
+  int64_t m_left = 0;
+  std::optional<int64_t> m_y;
+  int64_t m_width = 0;
+};
+
+constexpr int64_t k_bandWords = 1 << 16;
+
+/**
+ * First bit from from on that is value, or width if there isn't one
+ */
+int64_t findBit(const uint64_t *row, int64_t from, int64_t width,
+                bool value) {
+  while (from < width) {
+    uint64_t word = value ? row[from / 64] : ~row[from / 64];
+    word >>= from % 64;
+    if (word) {
+      return std::min(width, from + std::countr_zero(word));
+    }
+    from += 64 - from % 64;
+  }
+  return width;
+}
+
+} // namespace
+
+namespace Rle {
+
+Header parse(std::istream &in, const RunCallback &run) {
+  BufferedReader reader(in);
+  Header header;
+
+  // Comment lines and then the header line
+  for (int c = reader.peek(); c != EOF; c = reader.peek()) {
+    if (c == '#') {
+      reader.getLine();
+    } else if (std::isspace(c)) {
+      reader.get();
+    } else if (c == 'x') {
+      parseHeader(reader.getLine(), header);
+      break;
+    } else {
+      break;
+    }
+  }
+
+  // Only to check it, the engine gets it in read()
+  Rule::parse(header.rule);
+
+  // Runs next to each other on the same row are handed over as one
+  int64_t runX = 0, runY = 0, runLength = 0;
+  auto flush = [&]() {
+    if (runLength > 0) {
+      run(runX, runY, runLength);
+    }
+    runLength = 0;
+  };
+
+  int64_t x = 0, y = 0, count = 0;
+  for (int c = reader.get(); c != EOF && c != '!'; c = reader.get()) {
+    if (c >= '0' && c <= '9') {
+      if (count > std::numeric_limits<int64_t>::max() / 20) {
+        throw std::runtime_error("RLE run count is too big");
+      }
+      count = count * 10 + (c - '0');
+      continue;
+    }
+    if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+      continue;
+    }
+
+    int64_t n = count == 0 ? 1 : count;
+    count = 0;
+
+    if (c == 'b' || c == '.') {
+      x += n;
+    } else if (c == '$') {
+      flush();
+      x = 0;
+      y += n;
+    } else if (c == 'o' || (c >= 'A' && c <= 'Z')) {
+      if (runLength > 0 && runY == y && runX + runLength == x) {
+        runLength += n;
+      } else {
+        flush();
+        runX = x;
+        runY = y;
+        runLength = n;
+      }
+      x += n;
+    } else {
+      throw std::runtime_error(std::string("Unexpected character in RLE: ") +
+                               static_cast<char>(c));
+    }
+  }
+  flush();
+
+  return header;
+}
+
+Header read(std::istream &in, LifeEngine &engine, int32_t x, int32_t y) {
+  RowCollector rows(engine);
+  Header header =
+      parse(in, [&](int64_t runX, int64_t runY, int64_t length) {
+        int64_t left = x + runX;
+        int64_t right = left + length - 1;
+        int64_t row = y - runY;
+        if (right > std::numeric_limits<int32_t>::max() ||
+            row < std::numeric_limits<int32_t>::min()) {
+          throw std::out_of_range("RLE pattern doesn't fit on the board");
+        }
+
+        rows.add(left, row, length);
+      });
+  rows.flush();
+  engine.setRule(Rule::parse(header.rule));
+
+  return header;
+}
+
+void write(std::ostream &out, LifeEngine &engine) {
+  if (engine.getRule().states > 2) {
+    throw std::invalid_argument("RLE only has live cells, " +
+                                engine.getRule().toString() +
+                                " has dying ones too");
+  }
+
+  std::optional<LifeEngine::Bounds> bounds = engine.getBounds();
+  if (!bounds) {
+    out << "x = 0, y = 0, rule = " << engine.getRule().toString() << "\n!\n";
+    return;
+  }
+
+  auto [minX, minY, maxX, maxY] = *bounds;
+  int64_t width = maxX - minX + 1;
+  if (minX < std::numeric_limits<int32_t>::min() ||
+      minY < std::numeric_limits<int32_t>::min() ||
+      maxX > std::numeric_limits<int32_t>::max() ||
+      maxY > std::numeric_limits<int32_t>::max() ||
+      width > std::numeric_limits<int32_t>::max()) {
+    throw std::out_of_range("Pattern is too big for RLE");
+  }
+
+  out << "x = " << width << ", y = " << (maxY - minY + 1)
+      << ", rule = " << engine.getRule().toString() << '\n';
+
+  // Read a band of rows at a time, as many as fit in k_bandWords
+  size_t stride = LifeEngine::regionStride(static_cast<int32_t>(width));
+  int64_t bandRows =
+      std::clamp<int64_t>(k_bandWords / static_cast<int64_t>(stride), 1, 64);
+  std::vector<uint64_t> band(bandRows * stride);
+
+  LineWriter writer(out);
+  // Row ends not written yet, they are only written once there is a row with
+  // something in it after them
+  int64_t rowEnds = 0;
+  for (int64_t top = maxY; top >= minY; top -= bandRows) {
+    int64_t rows = std::min(bandRows, top - minY + 1);
+    engine.getRegion(static_cast<int32_t>(minX),
+                     static_cast<int32_t>(top - rows + 1),
+                     static_cast<int32_t>(width), static_cast<int32_t>(rows),
+                     band.data());
+
+    for (int64_t r = rows - 1; r >= 0; r--) {
+      const uint64_t *row = band.data() + r * stride;
+      int64_t x = findBit(row, 0, width, true);
+      if (x < width && rowEnds > 0) {
+        writer.add(rowEnds, '$');
+        rowEnds = 0;
+      }
+
+      // Dead cells at the end of a row are left out
+      int64_t deadFrom = 0;
+      while (x < width) {
+        int64_t end = findBit(row, x, width, false);
+        if (x > deadFrom) {
+          writer.add(x - deadFrom, 'b');
+        }
+        writer.add(end - x, 'o');
+        deadFrom = end;
+        x = findBit(row, end, width, true);
+      }
+
+      rowEnds++;
+    }
+  }
+
+  writer.add(1, '!');
+  out << '\n';
+}
+
+} // namespace Rle
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+#include "../LifeEngine.h"
+
+/**
+ * The run length encoded pattern format most Life software reads and writes.
+ *
+ * A header line "x = 3, y = 3, rule = B3/S23" is followed by rows from the top
+ * of the pattern down, "3o" being 3 live cells, "2b" 2 dead ones, "$" the end
+ * of a row and "!" the end of the pattern.
+ */
+namespace Rle {
+
+struct Header {
+  // Size from the header line, 0 if there wasn't one
+  int64_t width = 0;
+  int64_t height = 0;
+  std::string rule = "B3/S23";
+};
+
+/**
+ * Gets a run of live cells, x going right and y going down from the top left
+ * corner of the pattern
+ */
+using RunCallback = std::function<void(int64_t x, int64_t y, int64_t length)>;
+
+/**
+ * Streams a pattern out of in, calling run for every run of live cells in the
+ * order they are in the file. Only a small buffer of the file is held at a
+ * time so it can be any size.
+ *
+ * Throws std::runtime_error if the pattern is malformed and
+ * std::invalid_argument if its rule isn't one Rule::parse() can read.
+ */
+Header parse(std::istream &in, const RunCallback &run);
+
+/**
+ * Adds the live cells of a pattern to engine with the top left corner of the
+ * pattern at (x, y) and switches engine to the rule of the pattern. Throws
+ * std::out_of_range if it doesn't fit.
+ */
+Header read(std::istream &in, LifeEngine &engine, int32_t x = 0,
+            int32_t y = 0);
+
+/**
+ * Writes all the live cells of engine and its rule, the top left corner of
+ * their bounds becomes the top left corner of the pattern. Throws
+ * std::invalid_argument if the rule has more than two states, there's
+ * nowhere to put the dying cells.
+ */
+void write(std::ostream &out, LifeEngine &engine);
+
+} // namespace Rle
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "Snapshot.h"
+
+namespace {
+
+constexpr uint64_t pageAlign(uint64_t offset) {
+  return (offset + Snapshot::k_pageSize - 1) / Snapshot::k_pageSize *
+         Snapshot::k_pageSize;
+}
+
+} // namespace
+
+namespace Snapshot {
+
+Writer::Writer(const std::string &path, uint32_t chunkSize, uint32_t rowBytes,
+               uint64_t generation, std::span<const ChunkKey> keys)
+    : m_out(path, std::ios::binary | std::ios::trunc), m_path(path),
+      m_chunkBytes(size_t(chunkSize) * rowBytes), m_left(keys.size()) {
+  if (!m_out) {
+    throw std::runtime_error("Failed to open " + path + " for writing");
+  }
+
+  Header header{};
+  std::memcpy(header.magic, k_magic, sizeof(k_magic));
+  header.version = k_version;
+  header.byteOrder = k_byteOrder;
+  header.chunkSize = chunkSize;
+  header.rowBytes = rowBytes;
+  header.chunkCount = keys.size();
+  header.generation = generation;
+  header.indexOffset = pageAlign(sizeof(Header));
+  header.rowsOffset =
+      pageAlign(header.indexOffset + keys.size() * sizeof(int32_t) * 2);
+
+  // Header, index and the padding after them go out as one block
+  std::vector<char> start(header.rowsOffset, 0);
+  std::memcpy(start.data(), &header, sizeof(header));
+  char *index = start.data() + header.indexOffset;
+  for (ChunkKey key : keys) {
+    std::memcpy(index, &key.x, sizeof(int32_t));
+    std::memcpy(index + sizeof(int32_t), &key.y, sizeof(int32_t));
+    index += sizeof(int32_t) * 2;
+  }
+  m_out.write(start.data(), start.size());
+}
+
+void Writer::writeRows(const void *rows) {
+  if (m_left == 0) {
+    throw std::logic_error("More rows written than there are chunks");
+  }
+  m_out.write(static_cast<const char *>(rows), m_chunkBytes);
+  m_left--;
+}
+
+void Writer::finish() {
+  if (m_left != 0) {
+    throw std::logic_error("Not every chunk got its rows written");
+  }
+  m_out.flush();
+  if (!m_out) {
+    throw std::runtime_error("Failed to write " + m_path);
+  }
+}
+
+View::View(const std::string &path, bool lazy)
+    : m_file(path, lazy ? MappedFile::Access::RANDOM
+                        : MappedFile::Access::SEQUENTIAL) {
+  if (m_file.size() < sizeof(Header)) {
+    throw std::runtime_error(path + " is too small to be a snapshot");
+  }
+  std::memcpy(&m_header, m_file.data(), sizeof(Header));
+
+  if (std::memcmp(m_header.magic, k_magic, sizeof(k_magic)) != 0) {
+    throw std::runtime_error(path + " isn't a snapshot");
+  }
+  if (m_header.version != k_version) {
+    throw std::runtime_error(path + " is snapshot version " +
+                             std::to_string(m_header.version) +
+                             ", only version " + std::to_string(k_version) +
+                             " can be read");
+  }
+  if (m_header.byteOrder != k_byteOrder) {
+    throw std::runtime_error(path + " was written with another byte order");
+  }
+
+  // Counts checked by dividing the space there is, so a huge one can't
+  // wrap around to something that looks like it fits
+  m_chunkBytes = size_t(m_header.chunkSize) * m_header.rowBytes;
+  if (m_chunkBytes == 0 || m_header.indexOffset % k_pageSize != 0 ||
+      m_header.rowsOffset % k_pageSize != 0 ||
+      m_header.indexOffset > m_header.rowsOffset ||
+      m_header.rowsOffset > m_file.size() ||
+      m_header.chunkCount >
+          (m_header.rowsOffset - m_header.indexOffset) /
+              (sizeof(int32_t) * 2) ||
+      m_header.chunkCount >
+          (m_file.size() - m_header.rowsOffset) / m_chunkBytes) {
+    throw std::runtime_error(path + " is cut short or corrupt");
+  }
+}
+
+ChunkKey View::key(size_t i) const {
+  const std::byte *entry =
+      m_file.data() + m_header.indexOffset + i * sizeof(int32_t) * 2;
+  int32_t x, y;
+  std::memcpy(&x, entry, sizeof(int32_t));
+  std::memcpy(&y, entry + sizeof(int32_t), sizeof(int32_t));
+  return {x, y};
+}
+
+} // namespace Snapshot
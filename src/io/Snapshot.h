@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "../ChunkKey.h"
+#include "MappedFile.h"
+
+/**
+ * Binary checkpoint of the chunks of a board, made to be loaded straight
+ * from a memory mapping.
+ *
+ * The file is a Header, the key of every chunk sorted by Morton code and then
+ * the data rows of every chunk in that same order, each chunk's k_size rows
+ * one after the other exactly as BasicChunk::getRow() gives them. The key
+ * index and the rows both start on a page boundary. Everything is in the byte
+ * order of the machine that wrote it, byteOrder tells if that isn't this one.
+ */
+namespace Snapshot {
+
+constexpr char k_magic[8] = {'G', 'O', 'L', 'S', 'N', 'A', 'P', '\0'};
+constexpr uint32_t k_version = 2;
+constexpr uint32_t k_byteOrder = 0x01020304;
+constexpr uint64_t k_pageSize = 4096;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  // Cells along the side of a chunk and bytes in one of its rows
+  uint32_t chunkSize;
+  uint32_t rowBytes;
+  uint64_t chunkCount;
+  // Generations the board had been run for
+  uint64_t generation;
+  uint64_t indexOffset;
+  uint64_t rowsOffset;
+};
+
+/**
+ * Writes a snapshot front to back in one go. The keys have to be sorted
+ * already and writeRows() called once for each of them, in the same order.
+ */
+class Writer {
+public:
+  /**
+   * Throws std::runtime_error if the file can't be written
+   */
+  Writer(const std::string &path, uint32_t chunkSize, uint32_t rowBytes,
+         uint64_t generation, std::span<const ChunkKey> keys);
+
+  void writeRows(const void *rows);
+  /**
+   * Throws std::runtime_error if anything failed to be written
+   */
+  void finish();
+
+private:
+  std::ofstream m_out;
+  std::string m_path;
+  size_t m_chunkBytes;
+  uint64_t m_left;
+};
+
+/**
+ * A snapshot file mapped into memory. Only the header is read up front, the
+ * rest is paged in as it is used.
+ */
+class View {
+public:
+  /**
+   * Throws std::runtime_error if the file isn't a snapshot that this version
+   * and this machine can read. lazy tells the OS the rows are going to be
+   * read here and there instead of front to back.
+   */
+  explicit View(const std::string &path, bool lazy = false);
+
+  const Header &header() const { return m_header; }
+  size_t size() const { return m_header.chunkCount; }
+
+  ChunkKey key(size_t i) const;
+  /**
+   * The chunkSize rows of chunk i
+   */
+  const void *rows(size_t i) const {
+    return m_file.data() + m_header.rowsOffset + i * m_chunkBytes;
+  }
+
+private:
+  MappedFile m_file;
+  Header m_header;
+  size_t m_chunkBytes;
+};
+
+} // namespace Snapshot
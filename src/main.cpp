@@ -1,18 +1,37 @@
+#include <algorithm>
 #include <bitset>
 #include <chrono>
+#include <cmath>
 #include <iostream>
+#include <random>
+#include <thread>
+#include <unordered_map>
 
 #include "BitArray.h"
+#include "CellRenderer.h"
 #include "Chunk.h"
+#include "ChunkMap.h"
+#include "DenseBoard.h"
 #include "GameBoard.h"
+#include "HashLife.h"
 #include "LibFunni/log.h"
 #include "Shader.h"
+#include "SimulationPipeline.h"
+#include "TerminalRenderer.h"
 #include "Window.h"
 #include "utils/Console.h"
 #include "utils/WrappedPoint.h"
 
 void simpleBitArrayTest();
 void simpleChunkTest();
+void simpleChunkSizeBenchmark();
+void simpleThreadScalingBenchmark();
+void simpleHashLifeBenchmark();
+void simpleDenseBoardBenchmark();
+void simpleRuleBenchmark();
+void simpleGenerationsBenchmark();
+void simpleTerminalMonitor();
+void simpleChunkMapBenchmark();
 void simpleGameBoardTest();
 void simpleWrappedPointTest();
 void simpleLoggerTest();
@@ -23,6 +42,14 @@ int main() {
   simpleWrappedPointTest();
   // simpleChunkTest();
   // simpleGameBoardTest();
+  // simpleTerminalMonitor();
+  // simpleChunkSizeBenchmark();
+  // simpleThreadScalingBenchmark();
+  // simpleChunkMapBenchmark();
+  // simpleHashLifeBenchmark();
+  // simpleDenseBoardBenchmark();
+  // simpleRuleBenchmark();
+  // simpleGenerationsBenchmark();
   simpleLoggerTest();
   simpleGLFWWindow();
 }
@@ -85,6 +112,185 @@ void simpleChunkTest() {
   }
 }
 
+/**
+ * Fills a square with a random soup through the LifeEngine interface so the
+ * same soup goes into every engine
+ */
+void fillSoup(LifeEngine &engine, int32_t x, int32_t y, int32_t size,
+              uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::bernoulli_distribution alive(0.35);
+  for (int32_t dy = 0; dy < size; dy++) {
+    for (int32_t dx = 0; dx < size; dx++) {
+      engine.setPoint(x + dx, y + dy, alive(rng));
+    }
+  }
+}
+
+/**
+ * A soup left to settle and then jumped far ahead, what is left is mostly
+ * still lifes, oscillators and gliders flying off which HashLife is great at
+ */
+void simpleHashLifeBenchmark() {
+  HashLife hl;
+  fillSoup(hl, 0, 0, 256, 42);
+
+  std::cout << '\n' << "HashLife benchmark (256x256 soup)" << '\n';
+  for (uint32_t k = 10; k <= 30; k += 5) {
+    auto start = std::chrono::steady_clock::now();
+    hl.step(k);
+    auto end = std::chrono::steady_clock::now();
+
+    HashLife::Stats stats = hl.getStats();
+    std::cout << "step 2^" << k << " | "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end -
+                                                                       start)
+                     .count()
+              << " ms | generation " << hl.getGeneration() << " | population "
+              << hl.getPopulation() << " | " << stats.nodes << " nodes | "
+              << stats.hitRate() * 100 << "% hit rate" << '\n';
+  }
+}
+
+/**
+ * Runs soups of a few densities on a bounded GameBoard and on a DenseBoard
+ * of the same size, to see where one overtakes the other
+ */
+void simpleDenseBoardBenchmark() {
+  using Topology = LifeEngine::Topology;
+  constexpr int32_t size = 2048;
+  constexpr uint32_t generations = 100;
+
+  for (double density : {0.001, 0.01, 0.05, 0.35}) {
+    GameBoard gb(Topology::Torus, size, size);
+    DenseBoard db(Topology::Torus, size, size);
+    std::mt19937 rng(5);
+    std::bernoulli_distribution alive(density);
+    for (int32_t y = 0; y < size; y++) {
+      for (int32_t x = 0; x < size; x++) {
+        if (alive(rng)) {
+          gb.setPoint(x, y, true);
+          db.setPoint(x, y, true);
+        }
+      }
+    }
+
+    auto time = [&](LifeEngine &engine) {
+      auto start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < generations; i++) {
+        engine.update();
+      }
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      return elapsed.count() / generations;
+    };
+    double chunked = time(gb);
+    double dense = time(db);
+
+    std::cout << "density " << density << ": GameBoard " << chunked
+              << " ms, DenseBoard " << dense << " ms a generation" << '\n';
+  }
+}
+
+/**
+ * The same soup with Life, with the other rules that have kernels of their
+ * own and with ones that don't, to see what a rule costs
+ */
+void simpleRuleBenchmark() {
+  constexpr int32_t size = 1024;
+  constexpr uint32_t generations = 100;
+
+  for (const char *text : {"B3/S23", "B36/S23", "B3678/S34678", "B36/S125",
+                           "B3/S012345678"}) {
+    Rule rule = Rule::parse(text);
+    GameBoard gb(LifeEngine::Topology::Torus, size, size);
+    DenseBoard db(LifeEngine::Topology::Torus, size, size);
+    gb.setRule(rule);
+    db.setRule(rule);
+    fillSoup(gb, 0, 0, size, 8);
+    fillSoup(db, 0, 0, size, 8);
+
+    auto time = [&](LifeEngine &engine) {
+      auto start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < generations; i++) {
+        engine.update();
+      }
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      return elapsed.count() / generations;
+    };
+    double chunked = time(gb);
+    double dense = time(db);
+
+    std::cout << text << ": GameBoard " << chunked << " ms, DenseBoard "
+              << dense << " ms a generation" << '\n';
+  }
+}
+
+/**
+ * Brian's Brain and Star Wars on a GenerationsBoard against Seeds, which
+ * steps the live cells the same as Brian's Brain, on a GameBoard
+ */
+void simpleGenerationsBenchmark() {
+  constexpr int32_t size = 1024;
+  constexpr uint32_t generations = 100;
+
+  auto time = [&](LifeEngine &engine, const Rule &rule) {
+    engine.setRule(rule);
+    fillSoup(engine, 0, 0, size, 8);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < generations; i++) {
+      engine.update();
+    }
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / generations;
+  };
+
+  GameBoard seeds(LifeEngine::Topology::Torus, size, size);
+  GenerationsBoard briansBrain(LifeEngine::Topology::Torus, size, size);
+  GenerationsBoard starWars(LifeEngine::Topology::Torus, size, size);
+  std::cout << "Seeds on a GameBoard: " << time(seeds, Rules::k_seeds)
+            << " ms a generation" << '\n';
+  std::cout << "Brian's Brain: " << time(briansBrain, Rules::k_briansBrain)
+            << " ms a generation" << '\n';
+  std::cout << "Star Wars: " << time(starWars, Rules::k_starWars)
+            << " ms a generation" << '\n';
+}
+
+/**
+ * Runs a soup in the background and shows it on the terminal for a while,
+ * the way it would be watched over ssh
+ */
+void simpleTerminalMonitor() {
+  GameBoard gb;
+  fillSoup(gb, -100, -50, 200, 99);
+
+  TerminalRenderer terminal(100, 30);
+  int32_t x = -terminal.getCellWidth() / 2;
+  int32_t y = -terminal.getCellHeight() / 2;
+
+  SimulationPipeline pipeline(gb);
+  pipeline.setViewport(x, y, terminal.getCellWidth(),
+                       terminal.getCellHeight());
+  pipeline.setUpdateRate(60);
+  pipeline.setFrameRate(30);
+  pipeline.start();
+
+  for (int i = 0; i < 30 * 20; i++) {
+    const SimulationPipeline::Frame &frame = pipeline.acquireFrame();
+    terminal.render(frame.chunks, x, y);
+    terminal.present();
+    std::cout << "Generation " << frame.generation << " | "
+              << terminal.getStats().bytes << " bytes" << "\033[K"
+              << std::flush;
+    pipeline.frameDone();
+  }
+
+  pipeline.stop();
+  std::cout << std::endl;
+}
+
 void simpleGameBoardTest() {
   GameBoard gb;
   char input;
@@ -123,6 +329,187 @@ void simpleGameBoardTest() {
   }
 }
 
+/**
+ * Runs the same random soup on a board with each of the chunk layouts and
+ * prints how long a generation takes on average
+ */
+template <typename ChunkT>
+void benchmarkChunkSize(const char *name, int32_t soupSize,
+                        uint32_t generations) {
+  BasicGameBoard<ChunkT> gb;
+  std::mt19937 rng(42);
+  std::bernoulli_distribution alive(0.35);
+
+  for (int32_t y = 0; y < soupSize; y++) {
+    for (int32_t x = 0; x < soupSize; x++) {
+      if (alive(rng)) {
+        gb.setPoint(x, y, true);
+      }
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < generations; i++) {
+    gb.update();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double totalMuS =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+          .count() /
+      1000.0;
+  double cellsPerGen = static_cast<double>(soupSize) * soupSize;
+
+  std::cout << name << " | Avg time: " << (totalMuS / generations)
+            << " micro sec/gen | "
+            << (totalMuS * 1000.0 / generations / cellsPerGen)
+            << " ns/soup cell" << '\n';
+}
+
+void simpleChunkSizeBenchmark() {
+  constexpr int32_t soupSize = 512;
+  constexpr uint32_t generations = 200;
+
+  std::cout << '\n'
+            << "Chunk size benchmark (" << soupSize << "x" << soupSize
+            << " soup, " << generations << " generations)" << '\n';
+  benchmarkChunkSize<Chunk8>(" 8x8  uint16_t", soupSize, generations);
+  benchmarkChunkSize<Chunk30>("30x30 uint32_t", soupSize, generations);
+  benchmarkChunkSize<Chunk62>("62x62 uint64_t", soupSize, generations);
+  benchmarkChunkSize<Chunk64>("64x64 uint64_t + halo", soupSize, generations);
+}
+
+void simpleThreadScalingBenchmark() {
+  constexpr int32_t soupSize = 2048;
+  constexpr uint32_t generations = 50;
+  uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  std::cout << '\n'
+            << "Thread scaling benchmark (" << soupSize << "x" << soupSize
+            << " soup, " << generations << " generations each)" << '\n';
+
+  double oneThreadMuS = 0;
+  for (uint32_t threads = 1; threads <= maxThreads;
+       threads = threads == maxThreads ? threads + 1
+                                       : std::min(threads * 2, maxThreads)) {
+    // Same soup every time so the runs are comparable
+    GameBoard gb;
+    gb.setThreadCount(threads);
+    std::mt19937 rng(42);
+    std::bernoulli_distribution alive(0.35);
+    for (int32_t y = 0; y < soupSize; y++) {
+      for (int32_t x = 0; x < soupSize; x++) {
+        if (alive(rng)) {
+          gb.setPoint(x, y, true);
+        }
+      }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < generations; i++) {
+      gb.update();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double avgMuS =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+            .count() /
+        1000.0 / generations;
+    if (threads == 1) {
+      oneThreadMuS = avgMuS;
+    }
+
+    std::cout << threads << " threads | Avg time: " << avgMuS
+              << " micro sec/gen | Speedup: " << (oneThreadMuS / avgMuS)
+              << '\n';
+  }
+}
+
+// Just enough of a common interface to time both maps with the same code
+using StdChunkMap = std::unordered_map<ChunkKey, uint32_t, ChunkKeyHash>;
+
+void mapInsert(StdChunkMap &m, ChunkKey k, uint32_t v) { m.emplace(k, v); }
+void mapInsert(ChunkMap<uint32_t> &m, ChunkKey k, uint32_t v) {
+  m.insert(k, v);
+}
+uint32_t mapFind(StdChunkMap &m, ChunkKey k) { return m.find(k)->second; }
+uint32_t mapFind(ChunkMap<uint32_t> &m, ChunkKey k) { return *m.find(k); }
+uint64_t mapSum(const StdChunkMap &m) {
+  uint64_t sum = 0;
+  for (auto &entry : m) {
+    sum += entry.second;
+  }
+  return sum;
+}
+uint64_t mapSum(const ChunkMap<uint32_t> &m) {
+  uint64_t sum = 0;
+  for (auto entry : m) {
+    sum += entry.value;
+  }
+  return sum;
+}
+
+/**
+ * Times insert, lookup, iteration and erase of all the keys
+ */
+template <typename Map>
+void benchmarkMap(const char *name, const std::vector<ChunkKey> &keys) {
+  using Clock = std::chrono::steady_clock;
+  auto nsPerKey = [&](Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+               .count() /
+           static_cast<double>(keys.size());
+  };
+
+  Map map;
+  uint64_t sum = 0;
+
+  auto start = Clock::now();
+  for (size_t i = 0; i < keys.size(); i++) {
+    mapInsert(map, keys[i], static_cast<uint32_t>(i));
+  }
+  auto inserted = Clock::now();
+
+  for (const ChunkKey &key : keys) {
+    sum += mapFind(map, key);
+  }
+  auto found = Clock::now();
+
+  sum += mapSum(map);
+  auto iterated = Clock::now();
+
+  for (const ChunkKey &key : keys) {
+    map.erase(key);
+  }
+  auto erased = Clock::now();
+
+  // sum is printed so the lookups can't be optimised away
+  std::cout << name << " | insert " << nsPerKey(start, inserted) << " | find "
+            << nsPerKey(inserted, found) << " | iterate "
+            << nsPerKey(found, iterated) << " | erase "
+            << nsPerKey(iterated, erased) << " ns/key | " << sum << '\n';
+}
+
+void simpleChunkMapBenchmark() {
+  std::cout << '\n' << "Chunk map benchmark" << '\n';
+
+  for (size_t count = 10000; count <= 10000000; count *= 10) {
+    // A solid block of chunks around the origin like a board ends up with,
+    // shuffled so the lookups don't just go in the order they went in
+    int32_t side = static_cast<int32_t>(std::ceil(std::sqrt(count)));
+    std::vector<ChunkKey> keys;
+    keys.reserve(count);
+    for (int32_t i = 0; keys.size() < count; i++) {
+      keys.emplace_back(i % side - side / 2, i / side - side / 2);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(3));
+
+    std::cout << count << " keys" << '\n';
+    benchmarkMap<StdChunkMap>("  unordered_map", keys);
+    benchmarkMap<ChunkMap<uint32_t>>("  ChunkMap     ", keys);
+  }
+}
+
 void simpleWrappedPointTest() {
   // test WrappedPoint -- imagine all the unit tests yay
 
@@ -148,10 +535,10 @@ void simpleLoggerTest() {
 
   logger.Start();
 
-  logger.logd();
-  logger.logi();
-  logger.logw();
-  logger.logi();
+  logger.logd("testing logging d");
+  logger.logi("testing logging i");
+  logger.logw("testing logging w");
+  logger.logi("testing logging i");
 }
 
 void processInput(Window &window) {
@@ -162,34 +549,60 @@ void processInput(Window &window) {
 
 void simpleGLFWWindow() {
   Window gameWindow("Game Of Life", 800, 600);
-  float vertices[] = {-0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, 0.0f, 0.5f, 0.0f};
-
-  unsigned int vao;
-  glGenVertexArrays(1, &vao);
-  glBindVertexArray(vao);
-
-  GLuint vbo;
-  glGenBuffers(1, &vbo);
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-  glEnableVertexAttribArray(0);
-
-  Shader shaderProgram("basic.vert", "basic.frag");
+  // The board runs on its own thread at its own rate, this loop only has to
+  // draw the frames it hands over
+  GameBoard board;
+  fillSoup(board, 0, 0, 256, 1);
+  SimulationPipeline pipeline(board);
+  pipeline.setUpdateRate(30);
+  pipeline.start();
+
+  CellRenderer renderer;
+  renderer.setColor(1.0f, 0.5f, 0.2f, 1.0f);
+  CellRenderer::Camera camera;
+  camera.x = -72;
+  camera.y = -22;
+  camera.cellPixels = 2;
 
   while (!gameWindow.shouldClose()) {
     processInput(gameWindow);
 
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    camera.width = viewport[2];
+    camera.height = viewport[3];
+
+    // = and - zoom in and out around the middle of the screen
+    double zoom = gameWindow.keyPressed(GLFW_KEY_EQUAL)   ? 1.05
+                  : gameWindow.keyPressed(GLFW_KEY_MINUS) ? 1 / 1.05
+                                                          : 1;
+    double middleX = camera.x + camera.width / 2 / camera.cellPixels;
+    double middleY = camera.y + camera.height / 2 / camera.cellPixels;
+    camera.cellPixels *= zoom;
+    camera.x = middleX - camera.width / 2 / camera.cellPixels;
+    camera.y = middleY - camera.height / 2 / camera.cellPixels;
+
+    // Once cells are smaller than pixels it only draws how full each pixel
+    // is
+    int64_t tileCells = camera.cellPixels < 1
+                            ? static_cast<int64_t>(1 / camera.cellPixels)
+                            : 0;
+    CellRenderer::Camera::Rect visible = camera.visibleCells();
+    pipeline.setViewport(visible.x, visible.y, visible.width, visible.height,
+                         tileCells);
+
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
-
-    shaderProgram.use();
-    glBindVertexArray(vao);
-    glDrawArrays(GL_TRIANGLES, 0, 3);
+    const SimulationPipeline::Frame &frame = pipeline.acquireFrame();
+    if (frame.density.tileCells > 0) {
+      renderer.drawDensity(frame.density, camera);
+    } else {
+      renderer.draw(frame.chunks, camera);
+    }
 
     gameWindow.swapBuffers();
     Window::pollEvents();
+    pipeline.frameDone();
   }
 }
@@ -0,0 +1,23 @@
+#version 330 core
+in vec2 vCell;
+flat in uint vSlot;
+
+// Rows of every chunk, see ChunkFrame for the layout
+uniform usamplerBuffer uRows;
+uniform int uChunkSize;
+uniform int uRowWords;
+uniform vec4 uColor;
+
+out vec4 FragColor;
+
+void main()
+{
+    ivec2 cell = clamp(ivec2(floor(vCell)), 0, uChunkSize - 1);
+    int word = int(vSlot) * uChunkSize * uRowWords + cell.y * uRowWords +
+               cell.x / 32;
+    uint row = texelFetch(uRows, word).r;
+    if (((row >> uint(cell.x % 32)) & 1u) == 0u)
+        discard;
+
+    FragColor = uColor;
+}
@@ -0,0 +1,24 @@
+#version 330 core
+// One instance per chunk, drawn as a strip of 4 vertices
+layout(location = 0) in ivec2 aOrigin;
+layout(location = 1) in uint aSlot;
+
+// The camera is split into a whole cell and the rest so cells far out on the
+// board still land on the right pixel
+uniform ivec2 uCameraCell;
+uniform vec2 uCameraOffset;
+uniform vec2 uCellScale;
+uniform int uChunkSize;
+
+out vec2 vCell;
+flat out uint vSlot;
+
+void main()
+{
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vCell = corner * float(uChunkSize);
+    vSlot = aSlot;
+
+    vec2 cell = vec2(aOrigin - uCameraCell) - uCameraOffset + vCell;
+    gl_Position = vec4(cell * uCellScale - 1.0, 0.0, 1.0);
+}
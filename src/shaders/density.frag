@@ -0,0 +1,20 @@
+#version 330 core
+in vec2 vTile;
+
+// Part of the cells of each tile that are alive
+uniform sampler2D uDensity;
+uniform ivec2 uTiles;
+uniform vec4 uColor;
+
+out vec4 FragColor;
+
+void main()
+{
+    ivec2 tile = clamp(ivec2(floor(vTile)), ivec2(0), uTiles - 1);
+    float density = texelFetch(uDensity, tile, 0).r;
+    if (density == 0.0)
+        discard;
+
+    // Anything alive at all shows up, denser tiles get brighter
+    FragColor = vec4(uColor.rgb * (0.25 + 0.75 * sqrt(density)), uColor.a);
+}
@@ -0,0 +1,15 @@
+#version 330 core
+// One quad over all the tiles, drawn as a strip of 4 vertices. The corners
+// are worked out on the CPU in doubles since tiles far out on the board are
+// past what a float can place to the pixel.
+uniform vec4 uRect;
+uniform ivec2 uTiles;
+
+out vec2 vTile;
+
+void main()
+{
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vTile = corner * vec2(uTiles);
+    gl_Position = vec4(mix(uRect.xy, uRect.zw, corner), 0.0, 1.0);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+#include "../Rule.h"
+
+/**
+ * Steps many chunks at once with the LifeKernel adders, one chunk per vector
+ * lane.
+ *
+ * The rows of all the chunks in a batch are laid out structure of arrays
+ * style: row r of the chunk in lane l is at in[r * lanes + l], so loading a
+ * vector from a row gives the same row of several chunks next to each other.
+ * Only &, |, ^ and shifts within each lane are used so the output is bit for
+ * bit what stepping each chunk on its own gives.
+ */
+namespace BatchKernel {
+
+template <typename RowType> struct Rows {
+  // (size + 2) rows of input including the top and bottom border
+  const RowType *in;
+  // Bits to or into each row after lining it up with the cell to the left or
+  // right, only needed for chunks that keep their border in a separate halo.
+  // nullptr when the border is already part of the rows
+  const RowType *haloWest;
+  const RowType *haloEast;
+  // size rows of output, without the borders
+  RowType *out;
+  int32_t size;
+  // Number of chunks in the batch, has to be a multiple of the lanes of the
+  // widest vector used
+  int32_t lanes;
+  RowType dataBits;
+  Rule rule;
+};
+
+// How many bytes of a row each instruction set works on at once
+constexpr int32_t k_avx2Bytes = 32;
+constexpr int32_t k_avx512Bytes = 64;
+
+/**
+ * Only defined for uint16_t, uint32_t and uint64_t rows. These must only be
+ * called when detectSimdLevel() says the instruction set is there.
+ */
+template <typename RowType> void stepAvx2(const Rows<RowType> &rows);
+template <typename RowType> void stepAvx512(const Rows<RowType> &rows);
+
+} // namespace BatchKernel
@@ -0,0 +1,95 @@
+// Built with AVX2 enabled, see CMakeLists.txt. Nothing in here may run
+// before detectSimdLevel() has said AVX2 is available.
+#include "BatchKernel.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+#include "BatchKernelImpl.h"
+
+namespace {
+
+struct Avx2Vec {
+  __m256i v;
+
+  template <typename RowType> static Avx2Vec broadcast(RowType x) {
+    if constexpr (sizeof(RowType) == 2) {
+      return {_mm256_set1_epi16(static_cast<short>(x))};
+    } else if constexpr (sizeof(RowType) == 4) {
+      return {_mm256_set1_epi32(static_cast<int>(x))};
+    } else {
+      return {_mm256_set1_epi64x(static_cast<long long>(x))};
+    }
+  }
+
+  template <typename RowType> static Avx2Vec load(const RowType *p) {
+    return {_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))};
+  }
+
+  template <typename RowType> void store(RowType *p) const {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+  }
+
+  template <typename RowType> static Avx2Vec shiftUp(Avx2Vec a) {
+    if constexpr (sizeof(RowType) == 2) {
+      return {_mm256_slli_epi16(a.v, 1)};
+    } else if constexpr (sizeof(RowType) == 4) {
+      return {_mm256_slli_epi32(a.v, 1)};
+    } else {
+      return {_mm256_slli_epi64(a.v, 1)};
+    }
+  }
+
+  template <typename RowType> static Avx2Vec shiftDown(Avx2Vec a) {
+    if constexpr (sizeof(RowType) == 2) {
+      return {_mm256_srli_epi16(a.v, 1)};
+    } else if constexpr (sizeof(RowType) == 4) {
+      return {_mm256_srli_epi32(a.v, 1)};
+    } else {
+      return {_mm256_srli_epi64(a.v, 1)};
+    }
+  }
+
+  friend Avx2Vec operator&(Avx2Vec a, Avx2Vec b) {
+    return {_mm256_and_si256(a.v, b.v)};
+  }
+  friend Avx2Vec operator|(Avx2Vec a, Avx2Vec b) {
+    return {_mm256_or_si256(a.v, b.v)};
+  }
+  friend Avx2Vec operator^(Avx2Vec a, Avx2Vec b) {
+    return {_mm256_xor_si256(a.v, b.v)};
+  }
+  friend Avx2Vec operator~(Avx2Vec a) {
+    return {_mm256_xor_si256(a.v, _mm256_set1_epi32(-1))};
+  }
+};
+
+} // namespace
+
+namespace BatchKernel {
+
+template <typename RowType> void stepAvx2(const Rows<RowType> &rows) {
+  stepRows<Avx2Vec>(rows);
+}
+
+} // namespace BatchKernel
+
+#else
+
+#include <stdexcept>
+
+namespace BatchKernel {
+
+// This compiler or target can't build AVX2 code, detectSimdLevel() never
+// reports it on targets without it so getting here is a bug
+template <typename RowType> void stepAvx2(const Rows<RowType> &) {
+  throw std::logic_error("AVX2 batch kernel was not built");
+}
+
+} // namespace BatchKernel
+
+#endif
+
+template void BatchKernel::stepAvx2(const Rows<uint16_t> &);
+template void BatchKernel::stepAvx2(const Rows<uint32_t> &);
+template void BatchKernel::stepAvx2(const Rows<uint64_t> &);
@@ -0,0 +1,95 @@
+// Built with AVX-512 F and BW enabled, see CMakeLists.txt. Nothing in here may
+// run before detectSimdLevel() has said AVX-512 is available.
+#include "BatchKernel.h"
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#include <immintrin.h>
+
+#include "BatchKernelImpl.h"
+
+namespace {
+
+struct Avx512Vec {
+  __m512i v;
+
+  template <typename RowType> static Avx512Vec broadcast(RowType x) {
+    if constexpr (sizeof(RowType) == 2) {
+      return {_mm512_set1_epi16(static_cast<short>(x))};
+    } else if constexpr (sizeof(RowType) == 4) {
+      return {_mm512_set1_epi32(static_cast<int>(x))};
+    } else {
+      return {_mm512_set1_epi64(static_cast<long long>(x))};
+    }
+  }
+
+  template <typename RowType> static Avx512Vec load(const RowType *p) {
+    return {_mm512_loadu_si512(reinterpret_cast<const __m512i *>(p))};
+  }
+
+  template <typename RowType> void store(RowType *p) const {
+    _mm512_storeu_si512(reinterpret_cast<__m512i *>(p), v);
+  }
+
+  template <typename RowType> static Avx512Vec shiftUp(Avx512Vec a) {
+    if constexpr (sizeof(RowType) == 2) {
+      return {_mm512_slli_epi16(a.v, 1)};
+    } else if constexpr (sizeof(RowType) == 4) {
+      return {_mm512_slli_epi32(a.v, 1)};
+    } else {
+      return {_mm512_slli_epi64(a.v, 1)};
+    }
+  }
+
+  template <typename RowType> static Avx512Vec shiftDown(Avx512Vec a) {
+    if constexpr (sizeof(RowType) == 2) {
+      return {_mm512_srli_epi16(a.v, 1)};
+    } else if constexpr (sizeof(RowType) == 4) {
+      return {_mm512_srli_epi32(a.v, 1)};
+    } else {
+      return {_mm512_srli_epi64(a.v, 1)};
+    }
+  }
+
+  friend Avx512Vec operator&(Avx512Vec a, Avx512Vec b) {
+    return {_mm512_and_si512(a.v, b.v)};
+  }
+  friend Avx512Vec operator|(Avx512Vec a, Avx512Vec b) {
+    return {_mm512_or_si512(a.v, b.v)};
+  }
+  friend Avx512Vec operator^(Avx512Vec a, Avx512Vec b) {
+    return {_mm512_xor_si512(a.v, b.v)};
+  }
+  friend Avx512Vec operator~(Avx512Vec a) {
+    return {_mm512_xor_si512(a.v, _mm512_set1_epi32(-1))};
+  }
+};
+
+} // namespace
+
+namespace BatchKernel {
+
+template <typename RowType> void stepAvx512(const Rows<RowType> &rows) {
+  stepRows<Avx512Vec>(rows);
+}
+
+} // namespace BatchKernel
+
+#else
+
+#include <stdexcept>
+
+namespace BatchKernel {
+
+// This compiler or target can't build AVX-512 code, detectSimdLevel() never
+// reports it on targets without it so getting here is a bug
+template <typename RowType> void stepAvx512(const Rows<RowType> &) {
+  throw std::logic_error("AVX-512 batch kernel was not built");
+}
+
+} // namespace BatchKernel
+
+#endif
+
+template void BatchKernel::stepAvx512(const Rows<uint16_t> &);
+template void BatchKernel::stepAvx512(const Rows<uint32_t> &);
+template void BatchKernel::stepAvx512(const Rows<uint64_t> &);
@@ -0,0 +1,67 @@
+#pragma once
+#include "../LifeKernel.h"
+#include "BatchKernel.h"
+
+/**
+ * Shared body of the per instruction set batch kernels. Vec is a small
+ * wrapper around a vector register that provides &, |, ^, ~, load(), store(),
+ * and shiftUp<RowType>()/shiftDown<RowType>() to shift every lane by one bit.
+ *
+ * This is only meant to be included from the BatchKernel*.cpp files, which
+ * are the ones built with the matching compiler flags.
+ */
+namespace BatchKernel {
+
+template <typename Vec, typename RowType, bool SeparateHalo, typename Kernel>
+inline void stepLanes(const Rows<RowType> &b, Kernel nextState) {
+  constexpr int32_t perVec = sizeof(Vec) / sizeof(RowType);
+  const int32_t stride = b.lanes;
+  const Vec dataBits = Vec::broadcast(b.dataBits);
+
+  auto load = [&](int32_t r, int32_t l, Vec &west, Vec &curr, Vec &east) {
+    curr = Vec::load(b.in + r * stride + l);
+    // Shifting right lines the cell to the left up with each cell and
+    // shifting left does the same with the cell to the right
+    west = Vec::template shiftDown<RowType>(curr);
+    east = Vec::template shiftUp<RowType>(curr);
+    if constexpr (SeparateHalo) {
+      west = west | Vec::load(b.haloWest + r * stride + l);
+      east = east | Vec::load(b.haloEast + r * stride + l);
+    }
+  };
+
+  for (int32_t l = 0; l < b.lanes; l += perVec) {
+    Vec topWest, top, topEast, currWest, curr, currEast;
+    load(b.size + 1, l, topWest, top, topEast);
+    load(b.size, l, currWest, curr, currEast);
+
+    for (int32_t y = b.size; y > 0; y--) {
+      Vec botWest, bot, botEast;
+      load(y - 1, l, botWest, bot, botEast);
+
+      Vec next = nextState(topWest, top, topEast, currWest, curr, currEast,
+                           botWest, bot, botEast);
+      (next & dataBits).store(b.out + (y - 1) * stride + l);
+
+      topWest = currWest;
+      top = curr;
+      topEast = currEast;
+      currWest = botWest;
+      curr = bot;
+      currEast = botEast;
+    }
+  }
+}
+
+template <typename Vec, typename RowType>
+inline void stepRows(const Rows<RowType> &b) {
+  LifeKernel::withRule(b.rule, [&](auto kernel) {
+    if (b.haloWest) {
+      stepLanes<Vec, RowType, true>(b, kernel);
+    } else {
+      stepLanes<Vec, RowType, false>(b, kernel);
+    }
+  });
+}
+
+} // namespace BatchKernel
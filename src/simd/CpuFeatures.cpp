@@ -0,0 +1,98 @@
+#include "CpuFeatures.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||           \
+    defined(_M_IX86)
+#define SIMD_X86 1
+#else
+#define SIMD_X86 0
+#endif
+
+#if SIMD_X86
+#ifdef _MSC_VER
+#include <immintrin.h>
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if SIMD_X86
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t (&regs)[4]) {
+#ifdef _MSC_VER
+  int out[4];
+  __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+  for (int i = 0; i < 4; i++) {
+    regs[i] = static_cast<uint32_t>(out[i]);
+  }
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t xgetbv(uint32_t index) {
+#ifdef _MSC_VER
+  return _xgetbv(index);
+#else
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+static SimdLevel queryCpu() {
+#if SIMD_X86
+  uint32_t regs[4];
+
+  cpuid(0, 0, regs);
+  if (regs[0] < 7) {
+    return SimdLevel::SCALAR;
+  }
+
+  // The OS has to save the vector registers on a context switch otherwise
+  // the CPU supporting them doesn't help at all
+  cpuid(1, 0, regs);
+  bool osxsave = regs[2] & (1u << 27);
+  bool avx = regs[2] & (1u << 28);
+  if (!osxsave || !avx) {
+    return SimdLevel::SCALAR;
+  }
+
+  uint64_t xcr0 = xgetbv(0);
+  // XMM and YMM state
+  bool osAvx = (xcr0 & 0x6) == 0x6;
+  // Opmask and both halves of the ZMM state
+  bool osAvx512 = osAvx && (xcr0 & 0xE0) == 0xE0;
+
+  cpuid(7, 0, regs);
+  bool avx2 = regs[1] & (1u << 5);
+  bool avx512f = regs[1] & (1u << 16);
+  bool avx512bw = regs[1] & (1u << 30);
+
+  if (osAvx512 && avx512f && avx512bw) {
+    return SimdLevel::AVX512;
+  }
+
+  if (osAvx && avx2) {
+    return SimdLevel::AVX2;
+  }
+#endif
+
+  return SimdLevel::SCALAR;
+}
+
+SimdLevel detectSimdLevel() {
+  static const SimdLevel level = queryCpu();
+  return level;
+}
+
+const char *simdLevelName(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::AVX512:
+    return "AVX-512";
+  case SimdLevel::AVX2:
+    return "AVX2";
+  default:
+    return "scalar";
+  }
+}
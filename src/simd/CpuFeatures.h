@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Vector instruction sets that the batched chunk stepping knows how to use,
+ * ordered from least to most capable.
+ */
+enum class SimdLevel : uint32_t {
+  SCALAR = 0,
+  AVX2 = 1,
+  AVX512 = 2,
+};
+
+/**
+ * Asks the CPU (through CPUID) and the OS (through XGETBV) which of the
+ * SimdLevels can be used. Only checked once, after that the result is cached.
+ */
+SimdLevel detectSimdLevel();
+
+const char *simdLevelName(SimdLevel level);
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <atomic>
+
+/*
+
+Relaxed atomic access to plain variables. Used for the few values that one
+thread writes while another one may be reading them (chunk rows and flags
+during the border pass of a parallel update). On x86 these are ordinary loads
+and stores, they only stop the compiler from tearing or caching them.
+
+*/
+
+template <typename T> inline T relaxedLoad(const T &value) {
+  return std::atomic_ref<T>(const_cast<T &>(value))
+      .load(std::memory_order_relaxed);
+}
+
+template <typename T> inline void relaxedStore(T &value, T desired) {
+  std::atomic_ref<T>(value).store(desired, std::memory_order_relaxed);
+}
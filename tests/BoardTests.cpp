@@ -0,0 +1,339 @@
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "GameBoard.h"
+#include "Tests.h"
+
+namespace {
+
+/**
+ * Ways to set a board up that should all step the same
+ */
+struct Setup {
+  const char *name;
+  SimdLevel simd;
+  uint32_t threads;
+};
+
+const std::vector<Setup> &setups() {
+  static const std::vector<Setup> s = {
+      {"scalar", SimdLevel::SCALAR, 1},
+      {"simd", detectSimdLevel(), 1},
+      {"threaded", detectSimdLevel(), 4}};
+  return s;
+}
+
+template <typename ChunkT>
+void configure(BasicGameBoard<ChunkT> &board, const Setup &setup) {
+  board.setSimdLevel(setup.simd);
+  board.setThreadCount(setup.threads);
+}
+
+/**
+ * Steps board and reference side by side for generations, checking them
+ * against each other after every one
+ */
+bool runAgainst(LifeEngine &board, Reference &reference,
+                uint32_t generations, const std::string &what) {
+  for (uint32_t generation = 0; generation <= generations; generation++) {
+    if (!reference.matches(board)) {
+      std::cerr << what << " differs from the reference at generation "
+                << generation << '\n';
+      return false;
+    }
+    if (generation == generations) {
+      break;
+    }
+    if (reference.touchesEdge()) {
+      std::cerr << what << " got to the edge of the reference, it needs "
+                << "to be bigger\n";
+      return false;
+    }
+    board.update();
+    reference.step();
+  }
+  return true;
+}
+
+/**
+ * Soups placed so they straddle chunk edges, around the origin where all
+ * four quadrants meet and out in each quadrant on its own
+ */
+template <typename ChunkT> bool soups(const char *name) {
+  constexpr int32_t size = ChunkT::k_size;
+  constexpr int32_t soup = 32;
+  constexpr uint32_t generations = 60;
+  // Nothing moves faster than a cell a generation
+  constexpr int32_t margin = generations + 2;
+
+  const std::vector<std::pair<int32_t, int32_t>> corners = {
+      {-soup / 2, -soup / 2},
+      {-5 * size - 7, -3 * size - 11},
+      {2 * size - 13, -7 * size + 5},
+      {-9 * size + 3, 4 * size - 17},
+      {6 * size + 1, 5 * size - 1}};
+
+  uint32_t seed = 0;
+  for (auto [x, y] : corners) {
+    for (const Setup &setup : setups()) {
+      std::mt19937 rng(++seed);
+      BasicGameBoard<ChunkT> board;
+      configure(board, setup);
+      Reference reference(x - margin, y - margin, soup + 2 * margin,
+                          soup + 2 * margin);
+      fillSoup(board, reference, x, y, soup, soup, 0.2 + 0.1 * (seed % 4),
+               rng);
+
+      if (!runAgainst(board, reference, generations,
+                      std::string(name) + " " + setup.name +
+                          " soup at (" + std::to_string(x) + ", " +
+                          std::to_string(y) + "), seed " +
+                          std::to_string(seed))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <typename ChunkT> bool torus(const char *name) {
+  constexpr int32_t size = ChunkT::k_size;
+  // Three chunks across and two up, and one chunk across so it is its own
+  // left and right neighbour
+  const std::vector<std::pair<int32_t, int32_t>> shapes = {{3, 2}, {1, 3}};
+
+  uint32_t seed = 100;
+  for (auto [across, up] : shapes) {
+    for (const Setup &setup : setups()) {
+      std::mt19937 rng(++seed);
+      int32_t width = across * size, height = up * size;
+      BasicGameBoard<ChunkT> board(LifeEngine::Topology::Torus, width,
+                                   height);
+      configure(board, setup);
+      Reference reference(0, 0, width, height,
+                          LifeEngine::Topology::Torus);
+      fillSoup(board, reference, 0, 0, width, height, 0.35, rng);
+
+      if (!runAgainst(board, reference, 100,
+                      std::string(name) + " " + setup.name + " " +
+                          std::to_string(width) + "x" +
+                          std::to_string(height) + " torus, seed " +
+                          std::to_string(seed))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Sets and clears cells every few generations while a soup runs, the chunks
+ * that were holding still or being played back have to notice
+ */
+template <typename ChunkT> bool edits(const char *name) {
+  constexpr int32_t soup = 40;
+  constexpr int32_t margin = 100;
+
+  uint32_t seed = 200;
+  for (const Setup &setup : setups()) {
+    std::mt19937 rng(++seed);
+    std::uniform_int_distribution<int32_t> where(-soup / 2, soup / 2);
+    std::bernoulli_distribution alive(0.5);
+    BasicGameBoard<ChunkT> board;
+    configure(board, setup);
+    Reference reference(-soup / 2 - margin, -soup / 2 - margin,
+                        soup + 2 * margin, soup + 2 * margin);
+    fillSoup(board, reference, -soup / 2, -soup / 2, soup, soup, 0.3, rng);
+
+    for (uint32_t round = 0; round < 12; round++) {
+      std::string what = std::string(name) + " " + setup.name +
+                         " edited soup, seed " + std::to_string(seed) +
+                         " round " + std::to_string(round);
+      if (!runAgainst(board, reference, 7, what)) {
+        return false;
+      }
+      for (int32_t i = 0; i < 20; i++) {
+        int32_t x = where(rng), y = where(rng);
+        bool cell = alive(rng);
+        board.setPoint(x, y, cell);
+        reference.set(x, y, cell);
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * A glider flying off in each direction for a long time, the chunks it
+ * leaves behind have to be deleted once it is gone
+ */
+template <typename ChunkT> bool cleanup(const char *name) {
+  constexpr uint32_t generations = 10000;
+  // Around the four chunks a glider can be in at once and one more ring for
+  // the ones that haven't been deleted yet
+  constexpr size_t most = 25;
+
+  for (const Setup &setup : setups()) {
+    for (int32_t direction = 0; direction < 4; direction++) {
+      BasicGameBoard<ChunkT> board;
+      configure(board, setup);
+      const std::pair<int32_t, int32_t> glider[] = {
+          {1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+      for (auto [x, y] : glider) {
+        board.setPoint(direction & 1 ? 2 - x : x, direction & 2 ? 2 - y : y,
+                       true);
+      }
+
+      for (uint32_t generation = 1; generation <= generations;
+           generation++) {
+        board.update();
+        if (board.getChunkCount() > most) {
+          std::cerr << name << " " << setup.name << " glider " << direction
+                    << " has " << board.getChunkCount()
+                    << " chunks at generation " << generation << '\n';
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * A block and a blinker left alone long enough that the block is skipped and
+ * the blinker only replayed. They have to keep going right, and a glider
+ * dropped in next to the block later has to get picked up.
+ */
+template <typename ChunkT> bool stillAndBlinking(const char *name) {
+  constexpr int32_t margin = 40;
+
+  for (const Setup &setup : setups()) {
+    BasicGameBoard<ChunkT> board;
+    configure(board, setup);
+    Reference reference(100 - margin, 90 - margin, 100 + 2 * margin,
+                        20 + 2 * margin);
+    auto set = [&](std::initializer_list<std::pair<int32_t, int32_t>> cells,
+                   int32_t x, int32_t y) {
+      for (auto [cx, cy] : cells) {
+        board.setPoint(x + cx, y + cy, true);
+        reference.set(x + cx, y + cy, true);
+      }
+    };
+
+    set({{0, 0}, {1, 0}, {0, 1}, {1, 1}}, 100, 100);
+    set({{0, 0}, {1, 0}, {2, 0}}, 200, 100);
+    if (!runAgainst(board, reference, 100,
+                    std::string(name) + " " + setup.name +
+                        " block and blinker")) {
+      return false;
+    }
+
+    // Heading up and to the right, past the block
+    set({{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}}, 110, 90);
+    if (!runAgainst(board, reference, 40,
+                    std::string(name) + " " + setup.name +
+                        " glider dropped in later")) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Soups on cylinders and tori set through coordinates off the board that
+ * wrap around onto it, and the board never reaching past its edges
+ */
+template <typename ChunkT> bool bounded(const char *name) {
+  using Topology = LifeEngine::Topology;
+  constexpr int32_t size = ChunkT::k_size;
+  const std::vector<std::tuple<Topology, int32_t, int32_t>> boards = {
+      {Topology::Cylinder, 6, 5},
+      {Topology::Cylinder, 1, 3},
+      {Topology::Torus, 6, 5}};
+
+  uint32_t seed = 300;
+  for (auto [topology, across, up] : boards) {
+    for (const Setup &setup : setups()) {
+      std::mt19937 rng(++seed);
+      std::bernoulli_distribution alive(0.35);
+      int32_t width = across * size, height = up * size;
+      bool torus = topology == Topology::Torus;
+      BasicGameBoard<ChunkT> board(topology, width, height);
+      configure(board, setup);
+      Reference reference(0, 0, width, height, topology);
+
+      for (int32_t y = 0; y < height; y++) {
+        for (int32_t x = 0; x < width; x++) {
+          bool cell = alive(rng);
+          board.setPoint(x - width, torus ? y + 2 * height : y, cell);
+          reference.set(x, y, cell);
+        }
+      }
+      // Off the top and bottom of a cylinder nothing happens, on a torus
+      // it lands on the board
+      board.setPoint(3, -1, true);
+      board.setPoint(5, height, true);
+      if (torus) {
+        reference.set(3, height - 1, true);
+        reference.set(5, 0, true);
+      }
+
+      std::string what = std::string(name) + " " + setup.name + " " +
+                         std::to_string(width) + "x" +
+                         std::to_string(height) +
+                         (torus ? " torus" : " cylinder") + ", seed " +
+                         std::to_string(seed);
+      if (!runAgainst(board, reference, 60, what)) {
+        return false;
+      }
+
+      ChunkFrame frame;
+      board.collectChunks(-1000, -1000, 3000, 3000, frame);
+      if (frame.chunks.size() > size_t(across) * up) {
+        std::cerr << what << " collected " << frame.chunks.size()
+                  << " chunks\n";
+        return false;
+      }
+    }
+  }
+
+  try {
+    BasicGameBoard<ChunkT> board(Topology::Torus, size + 1, size);
+    std::cerr << name << " made a torus that isn't whole chunks\n";
+    return false;
+  } catch (const std::invalid_argument &) {
+  }
+  return true;
+}
+
+} // namespace
+
+bool boardSoupTest() {
+  return soups<Chunk8>("Chunk8") && soups<Chunk30>("Chunk30") &&
+         soups<Chunk62>("Chunk62") && soups<Chunk64>("Chunk64");
+}
+
+bool boardTorusTest() {
+  return torus<Chunk8>("Chunk8") && torus<Chunk30>("Chunk30") &&
+         torus<Chunk62>("Chunk62") && torus<Chunk64>("Chunk64");
+}
+
+bool boardEditTest() {
+  return edits<Chunk8>("Chunk8") && edits<Chunk64>("Chunk64");
+}
+
+bool boardCleanupTest() {
+  return cleanup<Chunk8>("Chunk8") && cleanup<Chunk64>("Chunk64");
+}
+
+bool boardActiveSetTest() {
+  return stillAndBlinking<Chunk8>("Chunk8") &&
+         stillAndBlinking<Chunk64>("Chunk64");
+}
+
+bool boardBoundedTest() {
+  return bounded<Chunk8>("Chunk8") && bounded<Chunk30>("Chunk30") &&
+         bounded<Chunk64>("Chunk64");
+}
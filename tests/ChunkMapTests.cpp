@@ -0,0 +1,70 @@
+#include <random>
+#include <unordered_map>
+
+#include "ChunkMap.h"
+#include "Tests.h"
+
+/**
+ * Random inserts, erases and lookups over a small range of keys so the same
+ * ones keep getting hit, checked against std::unordered_map after every one
+ */
+bool chunkMapTest() {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int32_t> coord(-40, 40);
+  std::uniform_int_distribution<int> op(0, 2);
+
+  ChunkMap<uint32_t> map;
+  std::unordered_map<ChunkKey, uint32_t, ChunkKeyHash> reference;
+
+  for (uint32_t i = 0; i < 200000; i++) {
+    ChunkKey key(coord(rng), coord(rng));
+
+    switch (op(rng)) {
+    case 0:
+      map.insert(key, i);
+      reference[key] = i;
+      break;
+    case 1:
+      if (map.erase(key) != (reference.erase(key) == 1)) {
+        std::cerr << "Erasing (" << key.x << ", " << key.y
+                  << ") went wrong at operation " << i << '\n';
+        return false;
+      }
+      break;
+    default: {
+      const uint32_t *value = map.find(key);
+      auto it = reference.find(key);
+      if (it == reference.end() ? value != nullptr
+                                : !value || *value != it->second) {
+        std::cerr << "Finding (" << key.x << ", " << key.y
+                  << ") went wrong at operation " << i << '\n';
+        return false;
+      }
+      break;
+    }
+    }
+  }
+
+  if (map.size() != reference.size()) {
+    std::cerr << "The map has " << map.size() << " entries instead of "
+              << reference.size() << '\n';
+    return false;
+  }
+  for (auto entry : map) {
+    auto it = reference.find(entry.key);
+    if (it == reference.end() || it->second != entry.value) {
+      std::cerr << "Iterating gave (" << entry.key.x << ", " << entry.key.y
+                << ") which shouldn't be there\n";
+      return false;
+    }
+  }
+
+  auto sorted = map.spatialOrder();
+  for (size_t i = 1; i < sorted.size(); i++) {
+    if (Morton::encode(sorted[i - 1].key) >= Morton::encode(sorted[i].key)) {
+      std::cerr << "spatialOrder() isn't sorted at entry " << i << '\n';
+      return false;
+    }
+  }
+  return true;
+}
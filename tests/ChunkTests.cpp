@@ -0,0 +1,200 @@
+#include <array>
+#include <string>
+#include <vector>
+
+#include "Chunk.h"
+#include "Tests.h"
+
+namespace {
+
+/**
+ * A chunk with all eight neighbours around it, laid out top row first like
+ * the neighbour order with the center taken out, and the same cells in a
+ * Reference three chunks wide with its bottom left corner at (0, 0)
+ */
+template <typename ChunkT> struct Neighbourhood {
+  static constexpr int32_t k_size = ChunkT::k_size;
+
+  std::array<ChunkT, 9> grid;
+  Rule rule;
+  Reference reference;
+
+  explicit Neighbourhood(const Rule &rule)
+      : rule(rule), reference(0, 0, 3 * k_size, 3 * k_size,
+                              LifeEngine::Topology::Unbounded, rule) {
+    ChunkT &center = grid[4];
+    for (uint32_t n = 0; n < Neighbour::COUNT; n++) {
+      center.neighbours[n] = n < 4 ? n : n + 1;
+    }
+  }
+
+  /**
+   * Grid index of the chunk at (cx, cy) from the bottom left, both 0 to 2
+   */
+  static uint32_t index(int32_t cx, int32_t cy) { return (2 - cy) * 3 + cx; }
+
+  void set(int32_t x, int32_t y, bool alive) {
+    grid[index(x / k_size, y / k_size)].setCell(x % k_size, y % k_size,
+                                                alive);
+    reference.set(x, y, alive);
+  }
+
+  /**
+   * Steps the center chunk, true if it came out the same as the middle of
+   * the reference
+   */
+  bool step() {
+    ChunkT &center = grid[4];
+    center.readInBorder(grid.data());
+    center.processNextState(rule);
+    reference.step();
+
+    for (int32_t y = 0; y < k_size; y++) {
+      for (int32_t x = 0; x < k_size; x++) {
+        if (center.getCell(x, y) != reference.get(x + k_size, y + k_size)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+const std::vector<Rule> &testRules() {
+  static const std::vector<Rule> rules = {
+      Rules::k_life, Rules::k_highLife, Rules::k_seeds,
+      Rules::k_dayAndNight, Rule::parse("B36/S125"),
+      Rule::parse("B1/S012345678")};
+  return rules;
+}
+
+/**
+ * Random neighbourhoods of every density from nearly empty to nearly full,
+ * every fourth one with an empty center so it is down to whether the
+ * border alone causes a birth
+ */
+template <typename ChunkT> bool chunkSteps(const char *name) {
+  constexpr int32_t size = ChunkT::k_size;
+  constexpr uint32_t rounds = 100;
+
+  for (const Rule &rule : testRules()) {
+    for (uint32_t seed = 0; seed < rounds; seed++) {
+      std::mt19937 rng(seed);
+      std::uniform_real_distribution<double> density(0.01, 0.9);
+      std::bernoulli_distribution alive(density(rng));
+      bool emptyCenter = seed % 4 == 3;
+
+      Neighbourhood<ChunkT> n(rule);
+      for (int32_t y = 0; y < 3 * size; y++) {
+        for (int32_t x = 0; x < 3 * size; x++) {
+          bool inCenter = x >= size && x < 2 * size && y >= size &&
+                          y < 2 * size;
+          n.set(x, y, !(emptyCenter && inCenter) && alive(rng));
+        }
+      }
+
+      if (!n.step()) {
+        std::cerr << name << " stepped differently from the reference with "
+                  << rule.toString() << ", seed " << seed << '\n';
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Steps the center chunk a few times against the reference and checks the
+ * flags it ends up with say the same as its cells
+ */
+template <typename ChunkT> bool chunkFlags(const char *name) {
+  constexpr int32_t size = ChunkT::k_size;
+  using Flags = typename ChunkT::Flags;
+  auto has = [](Flags flags, Flags flag) {
+    return static_cast<uint32_t>(flags & flag) != 0;
+  };
+
+  for (uint32_t seed = 0; seed < 200; seed++) {
+    std::mt19937 rng(seed);
+    std::bernoulli_distribution alive(seed % 2 ? 0.05 : 0.4);
+    Neighbourhood<ChunkT> n(Rules::k_life);
+    for (int32_t y = size; y < 2 * size; y++) {
+      for (int32_t x = size; x < 2 * size; x++) {
+        n.set(x, y, alive(rng));
+      }
+    }
+
+    // Only the center changes so the reference has to be cut back to it
+    // after every step, the neighbours stay empty
+    std::vector<bool> before(size * size);
+    for (int32_t step = 0; step < 3; step++) {
+      for (int32_t y = 0; y < size; y++) {
+        for (int32_t x = 0; x < size; x++) {
+          before[y * size + x] = n.reference.get(x + size, y + size);
+        }
+      }
+      if (!n.step()) {
+        std::cerr << name << " stepped wrong on its own, seed " << seed
+                  << '\n';
+        return false;
+      }
+
+      bool empty = true, changed = false;
+      uint8_t edges = 0;
+      for (int32_t y = 0; y < size; y++) {
+        for (int32_t x = 0; x < size; x++) {
+          bool cell = n.reference.get(x + size, y + size);
+          empty = empty && !cell;
+          if (cell != before[y * size + x]) {
+            changed = true;
+            if (x == 0) {
+              edges |= 1 << Neighbour::LEFT;
+            }
+            if (x == size - 1) {
+              edges |= 1 << Neighbour::RIGHT;
+            }
+            if (y == size - 1) {
+              edges |= 1 << Neighbour::UP;
+            }
+            if (y == 0) {
+              edges |= 1 << Neighbour::DOWN;
+            }
+          }
+        }
+      }
+
+      const ChunkT &center = n.grid[4];
+      Flags flags = n.grid[4].getFlags();
+      if (has(flags, Flags::EMPTY) != empty ||
+          has(flags, Flags::CHANGED) != changed ||
+          (center.getChangedEdges() & edges) != edges) {
+        std::cerr << name << " has the wrong flags after " << step + 1
+                  << " steps, seed " << seed << '\n';
+        return false;
+      }
+
+      for (int32_t y = 0; y < 3 * size; y++) {
+        for (int32_t x = 0; x < 3 * size; x++) {
+          bool inCenter = x >= size && x < 2 * size && y >= size &&
+                          y < 2 * size;
+          if (!inCenter) {
+            n.reference.set(x, y, false);
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+bool chunkStepTest() {
+  return chunkSteps<Chunk8>("Chunk8") && chunkSteps<Chunk30>("Chunk30") &&
+         chunkSteps<Chunk62>("Chunk62") && chunkSteps<Chunk64>("Chunk64");
+}
+
+bool chunkFlagsTest() {
+  return chunkFlags<Chunk8>("Chunk8") && chunkFlags<Chunk30>("Chunk30") &&
+         chunkFlags<Chunk62>("Chunk62") && chunkFlags<Chunk64>("Chunk64");
+}
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "DenseBoard.h"
+#include "Tests.h"
+
+/**
+ * Soups on dense tori and cylinders against the reference, some narrower
+ * than a word and some not a multiple of one, and the region functions
+ * wrapping around the same way getPoint() does
+ */
+bool denseBoardTest() {
+  using Topology = LifeEngine::Topology;
+  const std::vector<std::tuple<Topology, int32_t, int32_t, uint32_t>> boards =
+      {{Topology::Torus, 100, 37, 1},
+       {Topology::Cylinder, 64, 20, 3},
+       {Topology::Torus, 5, 9, 2},
+       {Topology::Cylinder, 130, 1, 1}};
+
+  for (auto [topology, width, height, threads] : boards) {
+    bool torus = topology == Topology::Torus;
+    std::string what = std::to_string(width) + "x" + std::to_string(height) +
+                       (torus ? " torus" : " cylinder") + " on " +
+                       std::to_string(threads) + " threads";
+    DenseBoard board(topology, width, height);
+    board.setThreadCount(threads);
+    Reference reference(0, 0, width, height, topology);
+
+    // A row at a time from off the board, it has to wrap around onto it
+    std::mt19937 rng(width * 17 + height);
+    std::bernoulli_distribution alive(0.35);
+    std::vector<uint64_t> row(LifeEngine::regionStride(width));
+    for (int32_t y = 0; y < height; y++) {
+      std::fill(row.begin(), row.end(), 0);
+      for (int32_t x = 0; x < width; x++) {
+        bool cell = alive(rng);
+        reference.set(x, y, cell);
+        row[x / 64] |= uint64_t(cell) << (x % 64);
+      }
+      board.setRowBits(width * 3, torus ? y - height : y, row.data(), width);
+    }
+    if (board.getPopulation() != reference.population()) {
+      std::cerr << what << " has a population of " << board.getPopulation()
+                << " instead of " << reference.population() << '\n';
+      return false;
+    }
+
+    for (int generation = 0; generation <= 40; generation++) {
+      if (!reference.matches(board)) {
+        std::cerr << what << " differs from the reference at generation "
+                  << generation << '\n';
+        return false;
+      }
+      board.update();
+      reference.step();
+    }
+
+    // A region bigger than the board starting off it
+    int32_t rx = -width - 5, ry = -3, rw = 2 * width + 70, rh = height + 6;
+    size_t stride = LifeEngine::regionStride(rw);
+    std::vector<uint64_t> bits(stride * rh);
+    board.getRegion(rx, ry, rw, rh, bits.data());
+    for (int32_t y = 0; y < rh; y++) {
+      for (int32_t x = 0; x < rw; x++) {
+        bool cell = bits[y * stride + x / 64] >> (x % 64) & 1;
+        if (cell != board.getPoint(rx + x, ry + y)) {
+          std::cerr << what << " region off the board has the wrong cell at ("
+                    << rx + x << ", " << ry + y << ")\n";
+          return false;
+        }
+      }
+    }
+
+    // Written back shifted over by one, every cell should move right
+    board.getRegion(0, 0, width, height, bits.data());
+    DenseBoard shifted(topology, width, height);
+    shifted.setRegion(1, 0, width, height, bits.data());
+    for (int32_t y = 0; y < height; y++) {
+      for (int32_t x = 0; x < width; x++) {
+        if (shifted.getPoint(x + 1, y) != board.getPoint(x, y)) {
+          std::cerr << what << " region written back one over has the wrong "
+                    << "cell at (" << x + 1 << ", " << y << ")\n";
+          return false;
+        }
+      }
+    }
+
+    shifted.setRun(width - 3, 0, 10, true);
+    for (int32_t x = -3; x < 7; x++) {
+      if (!shifted.getPoint(x, 0)) {
+        std::cerr << what << " run past the right edge didn't wrap\n";
+        return false;
+      }
+    }
+  }
+
+  try {
+    DenseBoard board(Topology::Unbounded, 10, 10);
+    std::cerr << "Made an unbounded DenseBoard\n";
+    return false;
+  } catch (const std::invalid_argument &) {
+  }
+  return true;
+}
@@ -0,0 +1,282 @@
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "DenseBoard.h"
+#include "GameBoard.h"
+#include "HashLife.h"
+#include "Tests.h"
+#include "io/Macrocell.h"
+#include "io/Rle.h"
+
+namespace {
+
+/**
+ * Steps a torus of cell states under a Generations rule by looking at every
+ * cell, the same as Reference::step() for two states
+ */
+std::vector<uint8_t> stepGenerations(const std::vector<uint8_t> &states,
+                                     int32_t width, int32_t height,
+                                     const Rule &rule) {
+  std::vector<uint8_t> next(states.size());
+  for (int32_t y = 0; y < height; y++) {
+    for (int32_t x = 0; x < width; x++) {
+      int32_t count = 0;
+      for (int32_t dy = -1; dy <= 1; dy++) {
+        for (int32_t dx = -1; dx <= 1; dx++) {
+          int32_t nx = (x + dx + width) % width;
+          int32_t ny = (y + dy + height) % height;
+          count += (dx != 0 || dy != 0) && states[ny * width + nx] == 1;
+        }
+      }
+
+      uint8_t state = states[y * width + x];
+      uint8_t &out = next[y * width + x];
+      if (state == 0) {
+        out = rule.birth >> count & 1;
+      } else if (state == 1 && rule.survive >> count & 1) {
+        out = 1;
+      } else {
+        out = state + 1 < rule.states ? state + 1 : 0;
+      }
+    }
+  }
+  return next;
+}
+
+bool parses() {
+  if (Rule::parse("B2/S/C3") != Rules::k_briansBrain ||
+      Rule::parse("/2/3") != Rules::k_briansBrain ||
+      Rule::parse("345/2/4") != Rules::k_starWars ||
+      Rule::parse("b2s345c4") != Rules::k_starWars ||
+      Rule::parse("B3/S23/C2") != Rules::k_life ||
+      Rules::k_briansBrain.toString() != "B2/S/C3" ||
+      Rule::parse("B3/S23/C256").states != 256) {
+    std::cerr << "A Generations rule was read or written wrong\n";
+    return false;
+  }
+  for (const char *bad : {"B2/S/C1", "B2/S/C257", "B2/S/C", "/2/3/4",
+                          "B2/C3/S", "C3/B2/S"}) {
+    try {
+      Rule::parse(bad);
+      std::cerr << "Read \"" << bad << "\" as a rule\n";
+      return false;
+    } catch (const std::invalid_argument &) {
+    }
+  }
+  return true;
+}
+
+/**
+ * A soup of every state on tori on one and on four threads, going over to
+ * after part way through
+ */
+bool torus(const Rule &rule, const Rule &after) {
+  using Topology = LifeEngine::Topology;
+  constexpr int32_t size = GenerationsBoard::ChunkType::k_size;
+  constexpr int32_t width = 6 * size, height = 4 * size;
+
+  GenerationsBoard board(Topology::Torus, width, height);
+  GenerationsBoard threaded(Topology::Torus, width, height);
+  threaded.setThreadCount(4);
+  std::vector<GenerationsBoard *> boards = {&board, &threaded};
+
+  std::mt19937 rng(rule.birth * 512 + rule.survive + rule.states);
+  std::uniform_int_distribution<uint32_t> state(0, rule.states - 1);
+  std::bernoulli_distribution empty(0.5);
+  std::vector<uint8_t> cells(size_t(width) * height);
+  for (GenerationsBoard *b : boards) {
+    b->setRule(rule);
+  }
+  for (int32_t y = 0; y < height; y++) {
+    for (int32_t x = 0; x < width; x++) {
+      cells[y * width + x] = empty(rng) ? 0 : state(rng);
+      for (GenerationsBoard *b : boards) {
+        b->setState(x, y, cells[y * width + x]);
+      }
+    }
+  }
+
+  for (int generation = 0; generation < 80; generation++) {
+    Rule now = generation < 30 ? rule : after;
+    if (generation == 30) {
+      for (GenerationsBoard *b : boards) {
+        b->setRule(after);
+      }
+      for (uint8_t &cell : cells) {
+        cell = cell < after.states ? cell : 0;
+      }
+    }
+    for (int32_t y = 0; y < height; y++) {
+      for (int32_t x = 0; x < width; x++) {
+        uint8_t cell = cells[y * width + x];
+        for (GenerationsBoard *b : boards) {
+          if (b->getState(x, y) != cell || b->getPoint(x, y) != (cell == 1)) {
+            std::cerr << rule.toString() << " then " << after.toString()
+                      << (b == &board ? "" : " threaded")
+                      << " has the wrong state at (" << x << ", " << y
+                      << ") in generation " << generation << '\n';
+            return false;
+          }
+        }
+      }
+    }
+    for (GenerationsBoard *b : boards) {
+      b->update();
+    }
+    cells = stepGenerations(cells, width, height, now);
+  }
+  return true;
+}
+
+/**
+ * An unbounded board has to make and delete chunks around a soup, chunks
+ * full of dying cells have to stay until they are dead. The reference torus
+ * is big enough that nothing gets to its edge.
+ */
+bool unbounded() {
+  constexpr int32_t space = 256, soup = 32;
+  GenerationsBoard board;
+  board.setRule(Rules::k_starWars);
+  std::vector<uint8_t> cells(size_t(space) * space);
+  std::mt19937 rng(21);
+  std::uniform_int_distribution<uint32_t> state(0, 3);
+  for (int32_t y = 0; y < soup; y++) {
+    for (int32_t x = 0; x < soup; x++) {
+      uint8_t cell = state(rng);
+      cells[(y + (space - soup) / 2) * space + x + (space - soup) / 2] = cell;
+      board.setState(x - soup / 2, y - soup / 2, cell);
+    }
+  }
+  for (int generation = 0; generation < 60; generation++) {
+    board.update();
+    cells = stepGenerations(cells, space, space, Rules::k_starWars);
+  }
+  for (int32_t y = 0; y < space; y++) {
+    for (int32_t x = 0; x < space; x++) {
+      if (board.getState(x - space / 2, y - space / 2) !=
+          cells[y * space + x]) {
+        std::cerr << "Unbounded Star Wars has the wrong state at ("
+                  << x - space / 2 << ", " << y - space / 2 << ")\n";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Two states is the same as a GameBoard, and engines that only have two
+ * states turn the rules with more down
+ */
+bool twoStates() {
+  GenerationsBoard generations;
+  GameBoard life;
+  for (LifeEngine *engine : {(LifeEngine *)&generations, (LifeEngine *)&life}) {
+    std::mt19937 rng(5);
+    fillSoup(*engine, 0, 0, 48, 48, 0.35, rng);
+    engine->step(5);
+  }
+  if (!sameCells(generations, life, -100, -100, 250, 250)) {
+    std::cerr << "A GenerationsBoard running Life differs from a GameBoard\n";
+    return false;
+  }
+
+  DenseBoard dense(LifeEngine::Topology::Torus, 64, 64);
+  HashLife hashLife;
+  for (LifeEngine *engine :
+       {(LifeEngine *)&life, (LifeEngine *)&dense, (LifeEngine *)&hashLife}) {
+    try {
+      engine->setRule(Rules::k_briansBrain);
+      std::cerr << "An engine with two states took Brian's Brain\n";
+      return false;
+    } catch (const std::invalid_argument &) {
+    }
+    if (engine->getRule().states != 2) {
+      std::cerr << "Turning Brian's Brain down still changed the rule\n";
+      return false;
+    }
+  }
+
+  try {
+    generations.setRule(Rules::k_briansBrain);
+    generations.setState(0, 0, 3);
+    std::cerr << "Set state 3 with a rule of 3 states\n";
+    return false;
+  } catch (const std::invalid_argument &) {
+  }
+  return true;
+}
+
+/**
+ * Snapshots, delta logs and pattern files only have live cells, writing any
+ * of them with dying cells around would lose those
+ */
+bool onlyLiveCellsSaved() {
+  std::string path =
+      (std::filesystem::temp_directory_path() / "gol_generations_test.bin")
+          .string();
+  GenerationsBoard board;
+  board.setRule(Rules::k_briansBrain);
+  board.setState(0, 0, 2);
+
+  std::ostringstream out;
+  std::vector<std::pair<const char *, std::function<void()>>> writes = {
+      {"a snapshot", [&]() { board.saveSnapshot(path); }},
+      {"a delta log", [&]() { board.startDeltaLog(path); }},
+      {"RLE", [&]() { Rle::write(out, board); }},
+      {"a macrocell file", [&]() { Macrocell::write(out, board); }}};
+  for (auto &[what, write] : writes) {
+    try {
+      write();
+      std::cerr << "Wrote " << what << " of Brian's Brain\n";
+      std::remove(path.c_str());
+      return false;
+    } catch (const std::invalid_argument &) {
+    }
+  }
+
+  // With two states it's just Life, and the rule can't go back up while the
+  // log is going
+  board.setRule(Rules::k_life);
+  board.startDeltaLog(path);
+  bool result = true;
+  try {
+    board.setRule(Rules::k_starWars);
+    std::cerr << "Went over to Star Wars with a delta log going\n";
+    result = false;
+  } catch (const std::invalid_argument &) {
+  }
+  board.stopDeltaLog();
+  std::remove(path.c_str());
+  return result && board.getRule() == Rules::k_life;
+}
+
+} // namespace
+
+bool generationsTest() {
+  if (!parses()) {
+    return false;
+  }
+
+  // Rules and what they go over to at generation 30, with 2 to 8 planes of
+  // counters
+  const std::vector<std::pair<Rule, Rule>> rules = {
+      {Rules::k_briansBrain, Rules::k_briansBrain},
+      {Rules::k_starWars, Rules::k_briansBrain},
+      {Rule::parse("B3/S23/C8"), Rule::parse("B3/S23/C8")},
+      {Rule::parse("B34/S034/C6"), Rule::parse("B2/S23/C4")},
+      {Rule::parse("B35/S234/C200"), Rule::parse("B36/S23/C2")}};
+  for (auto [rule, after] : rules) {
+    if (!torus(rule, after)) {
+      return false;
+    }
+  }
+  return unbounded() && twoStates() && onlyLiveCellsSaved();
+}
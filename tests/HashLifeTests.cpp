@@ -0,0 +1,58 @@
+#include <random>
+
+#include "GameBoard.h"
+#include "HashLife.h"
+#include "Tests.h"
+
+/**
+ * A soup on HashLife against the reference one generation at a time, then
+ * against a GameBoard with bigger and bigger steps. The node limit is small
+ * enough that it has to collect along the way.
+ */
+bool hashLifeTest() {
+  constexpr int32_t soup = 64;
+  // Nothing gets further than a cell a generation from the soup
+  constexpr int32_t margin = 140;
+
+  GameBoard board;
+  HashLife hashLife(1 << 14);
+  Reference reference(-margin, -margin, soup + 2 * margin,
+                      soup + 2 * margin);
+  std::mt19937 rng(7);
+  fillSoup(hashLife, reference, 0, 0, soup, soup, 0.35, rng);
+  for (int32_t y = 0; y < soup; y++) {
+    for (int32_t x = 0; x < soup; x++) {
+      board.setPoint(x, y, reference.get(x, y));
+    }
+  }
+
+  for (uint32_t generation = 0; generation < 8; generation++) {
+    if (!reference.matches(hashLife)) {
+      std::cerr << "HashLife differs from the reference at generation "
+                << generation << '\n';
+      return false;
+    }
+    board.update();
+    hashLife.update();
+    reference.step();
+  }
+
+  for (uint32_t k = 1; k <= 6; k++) {
+    board.step(k);
+    hashLife.step(k);
+    if (!sameCells(board, hashLife, -margin, -margin, soup + 2 * margin,
+                   soup + 2 * margin)) {
+      std::cerr << "HashLife differs from a GameBoard after a step of 2^"
+                << k << " generations\n";
+      return false;
+    }
+  }
+
+  HashLife::Stats stats = hashLife.getStats();
+  if (hashLife.getGeneration() != 8 + 126 || stats.collections == 0) {
+    std::cerr << "HashLife is at generation " << hashLife.getGeneration()
+              << " after " << stats.collections << " collections\n";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,78 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "LibFunni/log.h"
+#include "Tests.h"
+
+/**
+ * Logs to a file through the writer thread, with the levels that are off
+ * leaving nothing, a thread logging more than its ring holds getting its
+ * drops reported and loggers made while the writer is going getting their
+ * tags
+ */
+bool loggerTest() {
+  std::string path =
+      (std::filesystem::temp_directory_path() / "gol_logger_test.log")
+          .string();
+
+  // Only logd does anything
+  funni::Logger<true, false, false, false> logger("logtest");
+  if (!logger.Start(path)) {
+    std::cerr << "Couldn't start logging to " << path << '\n';
+    return false;
+  }
+
+  logger.logd("{} + {} = {}", 1, 2.5, "three");
+  logger.logi("info {}", 1);
+  logger.logw("warning {}", 2);
+  logger.logd("{} {} {}", true, 'x', std::string("done"));
+
+  // Lots more than fits in the ring in one go, the writer only comes by
+  // every few milliseconds
+  std::string big(1000, '#');
+  std::thread flood([&]() {
+    for (int i = 0; i < 1000; i++) {
+      logger.logd("{} {}", i, big);
+    }
+  });
+  flood.join();
+
+  // Loggers made on another thread while the writer is going, their tags
+  // are new to it. Few enough that their records all fit in the ring.
+  std::thread tagger([]() {
+    for (int i = 0; i < 1000; i++) {
+      funni::Logger<true, false, false, false> tagged("tag" +
+                                                      std::to_string(i));
+      tagged.logd("tagged {}", i);
+    }
+  });
+  tagger.join();
+  logger.Stop();
+
+  std::ifstream in(path);
+  std::stringstream text;
+  text << in.rdbuf();
+  in.close();
+  std::remove(path.c_str());
+
+  std::string log = text.str();
+  for (const char *line :
+       {"D/logtest: 1 + 2.5 = three\n", "D/logtest: true x done\n",
+        "D/logtest: 0 #", "D/tag999: tagged 999\n",
+        "log records, its ring was full"}) {
+    if (log.find(line) == std::string::npos) {
+      std::cerr << "The log is missing \"" << line << "\"\n";
+      return false;
+    }
+  }
+  if (log.find("info") != std::string::npos ||
+      log.find("warning") != std::string::npos) {
+    std::cerr << "A level that is off still logged\n";
+    return false;
+  }
+  return true;
+}
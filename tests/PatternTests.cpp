@@ -0,0 +1,225 @@
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "GameBoard.h"
+#include "HashLife.h"
+#include "Tests.h"
+#include "io/Macrocell.h"
+#include "io/Rle.h"
+
+namespace {
+
+/**
+ * A pattern that comes back to itself every period generations, moved by
+ * (dx, dy). Rows are top first and y goes up, like on the board.
+ */
+struct Periodic {
+  const char *name;
+  std::vector<std::string> rows;
+  uint32_t period;
+  int32_t dx;
+  int32_t dy;
+};
+
+const std::vector<Periodic> &oscillators() {
+  static const std::vector<Periodic> patterns = {
+      {"blinker", {"ooo"}, 2, 0, 0},
+      {"toad", {".ooo", "ooo."}, 2, 0, 0},
+      {"beacon", {"oo..", "oo..", "..oo", "..oo"}, 2, 0, 0},
+      {"pulsar",
+       {"..ooo...ooo..", ".............", "o....o.o....o", "o....o.o....o",
+        "o....o.o....o", "..ooo...ooo..", ".............", "..ooo...ooo..",
+        "o....o.o....o", "o....o.o....o", "o....o.o....o", ".............",
+        "..ooo...ooo.."},
+       3, 0, 0},
+      {"pentadecathlon",
+       {"..o....o..", "oo.oooo.oo", "..o....o.."},
+       15, 0, 0}};
+  return patterns;
+}
+
+const std::vector<Periodic> &spaceships() {
+  static const std::vector<Periodic> patterns = {
+      {"glider", {".o.", "..o", "ooo"}, 4, 1, -1},
+      {"lwss", {".o..o", "o....", "o...o", "oooo."}, 4, -2, 0}};
+  return patterns;
+}
+
+void place(LifeEngine &engine, const Periodic &p, int32_t x, int32_t y) {
+  for (size_t row = 0; row < p.rows.size(); row++) {
+    for (size_t col = 0; col < p.rows[row].size(); col++) {
+      if (p.rows[row][col] == 'o') {
+        engine.setPoint(x + int32_t(col), y - int32_t(row), true);
+      }
+    }
+  }
+}
+
+/**
+ * True if engine has exactly the pattern with its top left at (x, y)
+ */
+bool hasPattern(LifeEngine &engine, const Periodic &p, int32_t x,
+                int32_t y) {
+  int32_t width = int32_t(p.rows[0].size()), height = int32_t(p.rows.size());
+  Reference expected(x - 2, y - height - 1, width + 4, height + 4);
+  for (int32_t row = 0; row < height; row++) {
+    for (int32_t col = 0; col < width; col++) {
+      expected.set(x + col, y - row, p.rows[row][col] == 'o');
+    }
+  }
+  return expected.matches(engine);
+}
+
+/**
+ * Runs p for laps periods from a few places around chunk edges and in each
+ * quadrant. It has to come back moved by (dx, dy) every period and not be
+ * itself anywhere in between, so the period is the smallest one.
+ */
+template <typename ChunkT> bool periodic(const Periodic &p, uint32_t laps) {
+  constexpr int32_t size = ChunkT::k_size;
+  const std::vector<std::pair<int32_t, int32_t>> corners = {
+      {-2, 2},
+      {size - 3, size + 1},
+      {-size - 2, -size + 3},
+      {3 * size - 1, -2 * size + 2},
+      {-4 * size + 5, 2 * size}};
+
+  for (auto [x, y] : corners) {
+    BasicGameBoard<ChunkT> board;
+    place(board, p, x, y);
+
+    for (uint32_t lap = 1; lap <= laps; lap++) {
+      for (uint32_t generation = 1; generation <= p.period; generation++) {
+        board.update();
+        bool back = hasPattern(board, p, x + p.dx * int32_t(lap),
+                               y + p.dy * int32_t(lap));
+        if (back != (generation == p.period)) {
+          std::cerr << p.name << " from (" << x << ", " << y << ") with "
+                    << size << " cell chunks "
+                    << (back ? "came back early" : "didn't come back")
+                    << " at generation " << (lap - 1) * p.period + generation
+                    << '\n';
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+template <typename ChunkT> bool allPeriodic(const std::vector<Periodic> &ps) {
+  for (const Periodic &p : ps) {
+    // Spaceships go a good few chunks
+    uint32_t laps = p.dx || p.dy ? 40 : 6;
+    if (!periodic<ChunkT>(p, laps)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+bool oscillatorTest() {
+  return allPeriodic<Chunk8>(oscillators()) &&
+         allPeriodic<Chunk30>(oscillators()) &&
+         allPeriodic<Chunk62>(oscillators()) &&
+         allPeriodic<Chunk64>(oscillators());
+}
+
+bool spaceshipTest() {
+  return allPeriodic<Chunk8>(spaceships()) &&
+         allPeriodic<Chunk30>(spaceships()) &&
+         allPeriodic<Chunk62>(spaceships()) &&
+         allPeriodic<Chunk64>(spaceships());
+}
+
+/**
+ * Reads each pattern as RLE with its corner at offsets on both sides of
+ * the origin, negative ones included, and checks the cells land where they
+ * should
+ */
+bool rleOffsetTest() {
+  const std::pair<int32_t, int32_t> offsets[] = {
+      {0, 0}, {-10, 0}, {-1, -1}, {-1000, 5}, {37, -64}, {-70000, -3}};
+
+  for (const auto *patterns : {&oscillators(), &spaceships()}) {
+    for (const Periodic &p : *patterns) {
+      // Every cell spelled out, one row per line
+      std::string rle = "x = " + std::to_string(p.rows[0].size()) +
+                        ", y = " + std::to_string(p.rows.size()) + "\n";
+      for (size_t row = 0; row < p.rows.size(); row++) {
+        for (char c : p.rows[row]) {
+          rle += c == 'o' ? 'o' : 'b';
+        }
+        rle += row + 1 < p.rows.size() ? "$\n" : "!\n";
+      }
+
+      for (auto [x, y] : offsets) {
+        GameBoard board;
+        std::istringstream in(rle);
+        Rle::read(in, board, x, y);
+        if (!hasPattern(board, p, x, y)) {
+          std::cerr << p.name << " read at (" << x << ", " << y
+                    << ") isn't where it should be\n";
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Loads a glider gun from RLE and runs it, then writes it out with a soup
+ * next to it in both formats and reads that back into a GameBoard and into
+ * HashLife
+ */
+bool patternIoTest() {
+  std::istringstream gun(
+      "#N Gosper glider gun\n"
+      "x = 36, y = 9, rule = B3/S23\n"
+      "24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o$2o8bo3bob2o4b\n"
+      "obo$10bo5bo7bo$11bo3bo$12b2o!\n");
+  GameBoard board;
+  Rle::Header header = Rle::read(gun, board, 100, 200);
+  if (header.width != 36 || header.height != 9 || !board.getPoint(124, 200) ||
+      !board.getPoint(100, 196) || board.getPoint(101, 200)) {
+    std::cerr << "The glider gun was read in wrong\n";
+    return false;
+  }
+
+  // After a period there is one more glider
+  for (int i = 0; i < 30; i++) {
+    board.update();
+  }
+  std::mt19937 rng(3);
+  fillSoup(board, 300, 100, 40, 40, 0.35, rng);
+
+  std::stringstream rle, mc;
+  Rle::write(rle, board);
+  Macrocell::write(mc, board);
+
+  HashLife fromRle, fromMc;
+  GameBoard boardFromMc;
+  // RLE puts the top left corner where it's told
+  auto bounds = board.getBounds();
+  Rle::read(rle, fromRle, static_cast<int32_t>(bounds->minX),
+            static_cast<int32_t>(bounds->maxY));
+  Macrocell::read(mc, fromMc);
+  mc.clear();
+  mc.seekg(0);
+  Macrocell::read(mc, boardFromMc);
+
+  for (LifeEngine *engine :
+       {(LifeEngine *)&fromRle, (LifeEngine *)&fromMc,
+        (LifeEngine *)&boardFromMc}) {
+    if (!sameCells(board, *engine, 90, 90, 260, 260) ||
+        engine->getBounds() != bounds) {
+      std::cerr << "A pattern written out and read back in changed\n";
+      return false;
+    }
+  }
+  return true;
+}
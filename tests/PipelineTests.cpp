@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "GameBoard.h"
+#include "SimulationPipeline.h"
+#include "Tests.h"
+
+/**
+ * Runs a soup through the pipeline with both rates capped while reading
+ * frames as a renderer would, every frame has to match the same soup run
+ * without it
+ */
+bool pipelineTest() {
+  GameBoard board, reference;
+  std::mt19937 rng(9);
+  fillSoup(board, 0, 0, 64, 64, 0.35, rng);
+  for (int32_t y = 0; y < 64; y++) {
+    for (int32_t x = 0; x < 64; x++) {
+      reference.setPoint(x, y, board.getPoint(x, y));
+    }
+  }
+
+  SimulationPipeline pipeline(board);
+  pipeline.setViewport(-40, -40, 144, 144);
+  pipeline.setUpdateRate(400);
+  pipeline.setFrameRate(60);
+
+  auto start = std::chrono::steady_clock::now();
+  pipeline.start();
+  std::vector<SimulationPipeline::Frame> frames;
+  for (int i = 0; i < 40; i++) {
+    const SimulationPipeline::Frame &frame = pipeline.acquireFrame();
+    frames.push_back(frame);
+    pipeline.frameDone();
+  }
+  pipeline.stop();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  // Neither side went faster than it was allowed to
+  if (pipeline.getGeneration() > 400 * elapsed.count() + 2 ||
+      frames.size() > 60 * elapsed.count() + 2 ||
+      frames.back().generation <= frames.front().generation) {
+    std::cerr << "The pipeline got to generation "
+              << pipeline.getGeneration() << " and " << frames.size()
+              << " frames in " << elapsed.count() << " s\n";
+    return false;
+  }
+
+  uint64_t generation = 0;
+  for (const SimulationPipeline::Frame &frame : frames) {
+    if (frame.generation < generation) {
+      std::cerr << "Frame of generation " << frame.generation
+                << " came after one of " << generation << '\n';
+      return false;
+    }
+    for (; generation < frame.generation; generation++) {
+      reference.update();
+    }
+    size_t words = LifeEngine::regionStride(frame.width) * frame.height;
+    std::vector<uint64_t> cells(words), expected(words);
+    frame.chunks.getRegion(frame.x, frame.y, frame.width, frame.height,
+                           cells.data());
+    reference.getRegion(frame.x, frame.y, frame.width, frame.height,
+                        expected.data());
+    if (cells != expected) {
+      std::cerr << "Frame of generation " << frame.generation
+                << " has the wrong cells\n";
+      return false;
+    }
+  }
+
+  // A chunk that kept its version from one frame to the next kept its cells
+  for (size_t f = 1; f < frames.size(); f++) {
+    const ChunkFrame &before = frames[f - 1].chunks;
+    const ChunkFrame &after = frames[f].chunks;
+    for (size_t i = 0; i < after.chunks.size(); i++) {
+      for (size_t j = 0; j < before.chunks.size(); j++) {
+        if (before.chunks[j].key == after.chunks[i].key &&
+            before.chunks[j].version == after.chunks[i].version &&
+            !std::equal(after.rowsOf(i), after.rowsOf(i) + after.chunkWords(),
+                        before.rowsOf(j))) {
+          std::cerr << "A chunk in frame " << f
+                    << " changed without a new version\n";
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
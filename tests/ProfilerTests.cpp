@@ -0,0 +1,119 @@
+#include <numeric>
+#include <vector>
+
+#include "GameBoard.h"
+#include "Tests.h"
+#include "UpdateProfiler.h"
+
+namespace {
+
+/**
+ * The ring and histograms of an enabled profiler on their own, whatever
+ * the board was built with
+ */
+bool checkRing() {
+  using Profiler = BasicUpdateProfiler<true>;
+  Profiler profiler;
+  constexpr uint64_t generations = Profiler::k_capacity + 100;
+
+  uint64_t cursor = 0;
+  std::vector<Profiler::Record> records;
+  for (uint64_t g = 1; g <= generations; g++) {
+    uint64_t mark = profiler.begin(g, 2);
+    mark = profiler.lap(UpdatePhase::SPREAD, mark);
+    profiler.threadLap(1, UpdatePhase::STEP, mark);
+    profiler.add(UpdateCounter::DELETED, 2);
+    profiler.end();
+
+    if (g == 10 && (profiler.poll(cursor, records) != 0 ||
+                    records.size() != 10 || records[9].generation != 10)) {
+      std::cerr << "Polling the first 10 generations got "
+                << records.size() << '\n';
+      return false;
+    }
+  }
+
+  // Only the last k_capacity are still there
+  records.clear();
+  uint64_t dropped = profiler.poll(cursor, records);
+  if (dropped != generations - Profiler::k_capacity - 10 ||
+      records.size() != Profiler::k_capacity ||
+      records.front().generation != generations - Profiler::k_capacity + 1 ||
+      records.back().generation != generations || cursor != generations) {
+    std::cerr << "Polling after the ring wrapped dropped " << dropped
+              << " and got " << records.size() << '\n';
+    return false;
+  }
+  for (const Profiler::Record &r : records) {
+    if (r.counters[UpdateCounter::DELETED] != 2 ||
+        r.totalNanos < r.nanos[UpdatePhase::SPREAD]) {
+      std::cerr << "Generation " << r.generation << " came back wrong\n";
+      return false;
+    }
+  }
+
+  for (uint32_t phase = 0; phase <= UpdatePhase::COUNT; phase++) {
+    Profiler::Histogram h = profiler.histogram(phase);
+    if (std::accumulate(h.begin(), h.end(), uint64_t(0)) != generations) {
+      std::cerr << "Histogram of phase " << phase << " is missing updates\n";
+      return false;
+    }
+  }
+  profiler.reset();
+  if (profiler.totals()[UpdatePhase::COUNT] != 0 ||
+      profiler.histogram(UpdatePhase::COUNT)[0] != 0) {
+    std::cerr << "reset() left the histograms\n";
+    return false;
+  }
+  return true;
+}
+
+/**
+ * What a board records against what it actually did
+ */
+bool checkBoard() {
+  GameBoard board;
+  board.setThreadCount(2);
+  Reference reference(-100, -100, 232, 232);
+  std::mt19937 rng(301);
+  fillSoup(board, reference, 0, 0, 32, 32, 0.4, rng);
+
+  uint64_t cursor = 0;
+  std::vector<UpdateProfiler::Record> records;
+  for (uint32_t g = 1; g <= 40; g++) {
+    uint64_t steppedBefore = board.getSteppedChunks();
+    board.update();
+    reference.step();
+    board.getProfiler().poll(cursor, records);
+
+    if constexpr (!UpdateProfiler::k_enabled) {
+      if (!records.empty()) {
+        std::cerr << "A disabled profiler recorded something\n";
+        return false;
+      }
+      continue;
+    }
+
+    const UpdateProfiler::Record &r = records.back();
+    if (records.size() != g || r.generation != board.getGeneration() ||
+        r.counters[UpdateCounter::STEPPED] !=
+            board.getSteppedChunks() - steppedBefore ||
+        r.counters[UpdateCounter::POPULATION] != reference.population()) {
+      std::cerr << "The board recorded generation " << g << " wrong\n";
+      return false;
+    }
+    if (g > 1 && records[g - 2].counters[UpdateCounter::CHUNKS] +
+                         r.counters[UpdateCounter::CREATED] -
+                         r.counters[UpdateCounter::DELETED] !=
+                     r.counters[UpdateCounter::CHUNKS]) {
+      std::cerr << "Chunks made and deleted in generation " << g
+                << " don't add up\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+bool profilerTest() { return checkRing() && checkBoard(); }
@@ -0,0 +1,107 @@
+#include <optional>
+#include <stdexcept>
+
+#include "Reference.h"
+
+Reference::Reference(int32_t x, int32_t y, int32_t width, int32_t height,
+                     LifeEngine::Topology topology, const Rule &rule)
+    : m_x(x), m_y(y), m_width(width), m_height(height), m_topology(topology),
+      m_rule(rule), m_cells(size_t(width) * height, 0) {
+  if (width <= 0 || height <= 0) {
+    throw std::invalid_argument("A reference has to be at least 1x1.");
+  }
+}
+
+bool Reference::get(int32_t x, int32_t y) const {
+  return at(x - m_x, y - m_y);
+}
+
+void Reference::set(int32_t x, int32_t y, bool alive) {
+  int32_t col = x - m_x, row = y - m_y;
+  if (col < 0 || col >= m_width || row < 0 || row >= m_height) {
+    throw std::out_of_range("Cell outside of the reference.");
+  }
+  m_cells[size_t(row) * m_width + col] = alive;
+}
+
+void Reference::step() {
+  std::vector<uint8_t> next(m_cells.size());
+  for (int32_t row = 0; row < m_height; row++) {
+    for (int32_t col = 0; col < m_width; col++) {
+      int32_t neighbours = 0;
+      for (int32_t dy = -1; dy <= 1; dy++) {
+        for (int32_t dx = -1; dx <= 1; dx++) {
+          if (dx != 0 || dy != 0) {
+            neighbours += at(col + dx, row + dy);
+          }
+        }
+      }
+
+      bool alive = at(col, row);
+      uint16_t counts = alive ? m_rule.survive : m_rule.birth;
+      next[size_t(row) * m_width + col] = counts >> neighbours & 1;
+    }
+  }
+  m_cells = std::move(next);
+}
+
+bool Reference::touchesEdge() const {
+  if (m_topology != LifeEngine::Topology::Unbounded) {
+    return false;
+  }
+  for (int32_t col = 0; col < m_width; col++) {
+    if (at(col, 0) || at(col, m_height - 1)) {
+      return true;
+    }
+  }
+  for (int32_t row = 0; row < m_height; row++) {
+    if (at(0, row) || at(m_width - 1, row)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t Reference::population() const {
+  uint64_t count = 0;
+  for (uint8_t cell : m_cells) {
+    count += cell;
+  }
+  return count;
+}
+
+bool Reference::matches(LifeEngine &engine) const {
+  // A row at a time out of the engine, compared cell by cell
+  size_t stride = LifeEngine::regionStride(m_width);
+  std::vector<uint64_t> bits(stride);
+  for (int32_t row = 0; row < m_height; row++) {
+    engine.getRegion(m_x, m_y + row, m_width, 1, bits.data());
+    for (int32_t col = 0; col < m_width; col++) {
+      if ((bits[col / 64] >> (col % 64) & 1) != at(col, row)) {
+        return false;
+      }
+    }
+  }
+
+  // Anything outside would be a cell the reference doesn't have
+  std::optional<LifeEngine::Bounds> bounds = engine.getBounds();
+  if (!bounds) {
+    return population() == 0;
+  }
+  return bounds->minX >= m_x && bounds->minY >= m_y &&
+         bounds->maxX < int64_t(m_x) + m_width &&
+         bounds->maxY < int64_t(m_y) + m_height;
+}
+
+uint8_t Reference::at(int32_t x, int32_t y) const {
+  if (m_topology != LifeEngine::Topology::Unbounded) {
+    x = (x % m_width + m_width) % m_width;
+  }
+  if (m_topology == LifeEngine::Topology::Torus) {
+    y = (y % m_height + m_height) % m_height;
+  }
+  if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
+    return 0;
+  }
+  return m_cells[size_t(y) * m_width + x];
+}
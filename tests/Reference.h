@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "LifeEngine.h"
+#include "Rule.h"
+
+/**
+ * The plainest Life there is to check the real engines against, one byte a
+ * cell in a fixed rectangle and every cell counting its neighbours one by
+ * one each generation. Nothing in it is clever on purpose.
+ *
+ * Everything outside the rectangle is dead, unless the topology wraps it
+ * around the way a torus or cylinder board does. For an unbounded engine
+ * that is only right as long as nothing gets to the edge, which
+ * touchesEdge() says.
+ */
+class Reference {
+public:
+  Reference(int32_t x, int32_t y, int32_t width, int32_t height,
+            LifeEngine::Topology topology = LifeEngine::Topology::Unbounded,
+            const Rule &rule = Rule());
+
+  bool get(int32_t x, int32_t y) const;
+  void set(int32_t x, int32_t y, bool alive);
+  void step();
+  void setRule(const Rule &rule) { m_rule = rule; }
+
+  /**
+   * True if a live cell is on the outermost rows or columns, after that
+   * stepping would miss births outside. A torus or cylinder doesn't have
+   * any.
+   */
+  bool touchesEdge() const;
+  uint64_t population() const;
+
+  int32_t x() const { return m_x; }
+  int32_t y() const { return m_y; }
+  int32_t width() const { return m_width; }
+  int32_t height() const { return m_height; }
+
+  /**
+   * True if engine has exactly the same cells in the rectangle and nothing
+   * outside it
+   */
+  bool matches(LifeEngine &engine) const;
+
+private:
+  int32_t m_x;
+  int32_t m_y;
+  int32_t m_width;
+  int32_t m_height;
+  LifeEngine::Topology m_topology;
+  Rule m_rule;
+  std::vector<uint8_t> m_cells;
+
+  /**
+   * The cell at column x and row y of the rectangle, 0 outside it unless
+   * the topology wraps it
+   */
+  uint8_t at(int32_t x, int32_t y) const;
+};
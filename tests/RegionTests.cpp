@@ -0,0 +1,83 @@
+#include <random>
+#include <vector>
+
+#include "GameBoard.h"
+#include "HashLife.h"
+#include "Tests.h"
+
+namespace {
+
+/**
+ * Writes random regions and cell lists, some of them over negative
+ * coordinates, to a board and to HashLife which only has the cell by cell
+ * versions, then reads them back both ways
+ */
+template <typename ChunkT> bool regions(const char *name, uint32_t seed) {
+  BasicGameBoard<ChunkT> board;
+  HashLife reference;
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int32_t> pos(-150, 100), size(1, 130);
+  std::bernoulli_distribution coin(0.5);
+
+  for (int i = 0; i < 40; i++) {
+    int32_t x = pos(rng), y = pos(rng), w = size(rng), h = size(rng);
+    size_t stride = LifeEngine::regionStride(w);
+
+    if (coin(rng)) {
+      std::vector<uint64_t> bits(h * stride);
+      for (uint64_t &word : bits) {
+        word = rng() | (uint64_t(rng()) << 32);
+      }
+      board.setRegion(x, y, w, h, bits.data());
+      reference.setRegion(x, y, w, h, bits.data());
+    } else {
+      std::vector<LifeEngine::Cell> cells;
+      for (int c = 0; c < w * 4; c++) {
+        cells.push_back({pos(rng), pos(rng)});
+      }
+      bool value = coin(rng);
+      board.setCells(cells, value);
+      reference.setCells(cells, value);
+
+      std::vector<uint64_t> a((cells.size() + 63) / 64), b(a.size());
+      board.getCells(cells, a.data());
+      reference.getCells(cells, b.data());
+      if (a != b) {
+        std::cerr << name << " read a cell list back wrong, seed " << seed
+                  << " round " << i << '\n';
+        return false;
+      }
+    }
+
+    if (!sameCells(board, reference, x - 7, y - 3, w, h)) {
+      std::cerr << name << " read a region back wrong, seed " << seed
+                << " round " << i << '\n';
+      return false;
+    }
+
+    if (i % 8 == 7) {
+      board.update();
+      reference.update();
+    }
+  }
+
+  if (!sameCells(board, reference, -160, -160, 400, 400)) {
+    std::cerr << name << " ended up different from HashLife, seed " << seed
+              << '\n';
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+bool regionTest() {
+  for (uint32_t seed = 0; seed < 4; seed++) {
+    if (!regions<Chunk8>("Chunk8", seed) ||
+        !regions<Chunk30>("Chunk30", seed) ||
+        !regions<Chunk64>("Chunk64", seed)) {
+      return false;
+    }
+  }
+  return true;
+}
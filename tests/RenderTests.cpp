@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "CellRenderer.h"
+#include "GameBoard.h"
+#include "HashLife.h"
+#include "HeadlessContext.h"
+#include "TerminalRenderer.h"
+#include "Tests.h"
+
+namespace {
+
+/**
+ * Checks the density tiles engine gives for the rectangle against counting
+ * the cells of each tile
+ */
+bool densityMatches(LifeEngine &engine, int64_t tileCells) {
+  DensityFrame frame;
+  engine.collectDensity(-200, -130, 400, 300, tileCells, frame);
+  if (frame.tileCells < tileCells ||
+      frame.counts.size() != size_t(frame.width) * frame.height) {
+    std::cerr << "Asking for tiles of " << tileCells << " got ones of "
+              << frame.tileCells << '\n';
+    return false;
+  }
+
+  auto size = static_cast<int32_t>(frame.tileCells);
+  std::vector<uint64_t> cells(LifeEngine::regionStride(size) * size);
+  for (int32_t ty = frame.y; ty < frame.y + frame.height; ty++) {
+    for (int32_t tx = frame.x; tx < frame.x + frame.width; tx++) {
+      engine.getRegion(tx * size, ty * size, size, size, cells.data());
+      uint64_t count = 0;
+      for (uint64_t word : cells) {
+        count += std::popcount(word);
+      }
+      if (frame.getCount(tx, ty) != count) {
+        std::cerr << "Tile (" << tx << ", " << ty << ") of " << size
+                  << " cells counted " << frame.getCount(tx, ty)
+                  << " instead of " << count << '\n';
+        return false;
+      }
+    }
+  }
+
+  std::ostringstream heatmap;
+  frame.writeHeatmap(heatmap);
+  if (heatmap.str().size() != size_t(frame.width + 1) * frame.height) {
+    std::cerr << "The heatmap of tiles of " << size
+              << " cells is the wrong size\n";
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+/**
+ * The density tiles of a GameBoard, which come out of its pyramid, and of
+ * HashLife, which counts them cell by cell, against counting the cells of
+ * each tile as the boards are updated and set
+ */
+bool densityTest() {
+  GameBoard board;
+  HashLife hashLife;
+  std::vector<LifeEngine *> engines = {&board, &hashLife};
+  auto checkAll = [&](const char *when) {
+    for (int64_t tileCells : {1, 20, 100, 1000}) {
+      for (LifeEngine *engine : engines) {
+        if (!densityMatches(*engine, tileCells)) {
+          std::cerr << "That was " << when << " on "
+                    << (engine == &board ? "a GameBoard" : "HashLife")
+                    << '\n';
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  for (LifeEngine *engine : engines) {
+    std::mt19937 rng(13);
+    fillSoup(*engine, -150, -90, 300, 300, 0.35, rng);
+  }
+  if (!checkAll("after filling")) {
+    return false;
+  }
+  for (int i = 0; i < 20; i++) {
+    board.update();
+    hashLife.update();
+  }
+  if (!checkAll("after 20 updates")) {
+    return false;
+  }
+
+  // Set between updates, clearing chunks and making new ones, then a still
+  // life set where nothing else changes
+  for (LifeEngine *engine : engines) {
+    for (int32_t y = -40; y < 40; y++) {
+      engine->setRun(-60, y, 120, false);
+    }
+    engine->setRun(170, 150, 2, true);
+    engine->setRun(170, 151, 2, true);
+  }
+  if (!checkAll("after clearing a square")) {
+    return false;
+  }
+  board.update();
+  hashLife.update();
+  if (!checkAll("after the update after that")) {
+    return false;
+  }
+  for (LifeEngine *engine : engines) {
+    engine->setRun(-190, 150, 2, true);
+    engine->setRun(-190, 151, 2, true);
+    engine->update();
+  }
+  return checkAll("after adding a block");
+}
+
+/**
+ * Draws boards into a headless framebuffer and checks every pixel against
+ * the cell under its centre, and that frames after the first only send the
+ * chunks that changed. Passes without checking anything when there is no
+ * way to get a context.
+ */
+bool rendererTest() {
+  std::unique_ptr<HeadlessContext> context;
+  try {
+    context = std::make_unique<HeadlessContext>(256, 256);
+  } catch (const std::runtime_error &e) {
+    std::cerr << "Skipping the renderer, " << e.what() << '\n';
+    return true;
+  }
+
+  CellRenderer renderer;
+  auto drawsRight = [&](LifeEngine &engine,
+                        const CellRenderer::Camera &camera) {
+    CellRenderer::Camera::Rect view = camera.visibleCells();
+    ChunkFrame frame;
+    engine.collectChunks(view.x, view.y, view.width, view.height, frame);
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    renderer.draw(frame, camera);
+    std::vector<uint8_t> pixels = context->readPixels();
+
+    size_t stride = LifeEngine::regionStride(view.width);
+    std::vector<uint64_t> cells(stride * view.height);
+    engine.getRegion(view.x, view.y, view.width, view.height, cells.data());
+    for (int32_t py = 0; py < camera.height; py++) {
+      for (int32_t px = 0; px < camera.width; px++) {
+        auto cx = static_cast<int32_t>(
+            std::floor(camera.x + (px + 0.5) / camera.cellPixels) - view.x);
+        auto cy = static_cast<int32_t>(
+            std::floor(camera.y + (py + 0.5) / camera.cellPixels) - view.y);
+        bool alive = cells[cy * stride + cx / 64] >> (cx % 64) & 1;
+        if (alive != (pixels[(py * camera.width + px) * 4] > 127)) {
+          std::cerr << "Pixel (" << px << ", " << py << ") doesn't show the "
+                    << "cell under it with the camera at (" << camera.x
+                    << ", " << camera.y << ")\n";
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  CellRenderer::Camera camera;
+  camera.x = -128;
+  camera.y = -128;
+  camera.width = context->getWidth();
+  camera.height = context->getHeight();
+
+  // Blocks around a soup stay the same, only the soup should be sent again
+  GameBoard board;
+  std::mt19937 rng(11);
+  fillSoup(board, -32, -32, 64, 64, 0.35, rng);
+  for (int32_t i = 0; i < 6; i++) {
+    board.setRun(-120 + i * 40, 100, 2, true);
+    board.setRun(-120 + i * 40, 101, 2, true);
+  }
+  if (!drawsRight(board, camera)) {
+    return false;
+  }
+  CellRenderer::Stats first = renderer.getStats();
+  uint64_t uploaded = 0;
+  uint32_t drawn = 0;
+  for (int i = 0; i < 8; i++) {
+    board.update();
+    if (!drawsRight(board, camera)) {
+      return false;
+    }
+    uploaded += renderer.getStats().uploadBytes;
+    drawn += renderer.getStats().drawnChunks;
+  }
+  uint64_t chunkBytes = first.uploadBytes / first.uploadedChunks;
+  if (first.uploadedChunks != first.drawnChunks ||
+      uploaded >= drawn * chunkBytes) {
+    std::cerr << "Sent " << uploaded << " bytes for chunks that were "
+              << drawn * chunkBytes << " bytes\n";
+    return false;
+  }
+
+  // Scaled and off the cell grid, then through the default collectChunks()
+  camera.x = -64.3;
+  camera.y = -40.7;
+  camera.cellPixels = 2;
+  if (!drawsRight(board, camera)) {
+    return false;
+  }
+
+  HashLife hashLife;
+  rng.seed(11);
+  fillSoup(hashLife, -32, -32, 64, 64, 0.35, rng);
+  hashLife.update();
+  if (!drawsRight(hashLife, camera)) {
+    return false;
+  }
+
+  // Zoomed out to a pixel per tile, lit where the tile has anything. The
+  // board can make its tiles bigger than the 8 cells asked for.
+  fillSoup(board, -1000, -1000, 2000, 2000, 0.35, rng);
+  DensityFrame density;
+  board.collectDensity(0, 0, 1, 1, 8, density);
+  int64_t tileCells = density.tileCells;
+  camera.x = -128.0 * tileCells;
+  camera.y = -128.0 * tileCells;
+  camera.cellPixels = 1.0 / tileCells;
+  CellRenderer::Camera::Rect view = camera.visibleCells();
+  board.collectDensity(view.x, view.y, view.width, view.height, tileCells,
+                       density);
+  glClear(GL_COLOR_BUFFER_BIT);
+  renderer.drawDensity(density, camera);
+  std::vector<uint8_t> pixels = context->readPixels();
+  if (tileCells < 8 || density.tileCells != tileCells) {
+    std::cerr << "Asked for tiles of " << tileCells << " cells and got "
+              << density.tileCells << '\n';
+    return false;
+  }
+  for (int32_t py = 0; py < camera.height; py++) {
+    for (int32_t px = 0; px < camera.width; px++) {
+      bool any = density.getCount(-128 + px, -128 + py) > 0;
+      if (any != (pixels[(py * camera.width + px) * 4] > 0)) {
+        std::cerr << "Zoomed out pixel (" << px << ", " << py
+                  << ") doesn't show its tile\n";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Plays what a TerminalRenderer writes on a pretend terminal and checks
+ * every character has the dots of the cells under it, for both kinds of
+ * glyphs
+ */
+bool terminalTest() {
+  constexpr int32_t columns = 70, rows = 20;
+
+  for (auto glyphs : {TerminalRenderer::Glyphs::Braille,
+                      TerminalRenderer::Glyphs::HalfBlock}) {
+    bool braille = glyphs == TerminalRenderer::Glyphs::Braille;
+    // Braille from the board, half blocks from chunks it collected
+    bool fromChunks = !braille;
+    const char *name = braille ? "Braille" : "Half block";
+
+    GameBoard board;
+    std::mt19937 rng(21);
+    fillSoup(board, -30, -20, 90, 90, 0.35, rng);
+    TerminalRenderer terminal(columns, rows, glyphs);
+    int32_t glyphWidth = braille ? 2 : 1, glyphHeight = braille ? 4 : 2;
+    int32_t x = -45, y = -30;
+    if (terminal.getCellWidth() != columns * glyphWidth ||
+        terminal.getCellHeight() != rows * glyphHeight) {
+      std::cerr << name << " terminal covers the wrong number of cells\n";
+      return false;
+    }
+
+    std::vector<std::string> screen(columns * rows, " ");
+    for (int generation = 0; generation < 30; generation++) {
+      const std::string *out;
+      if (fromChunks) {
+        ChunkFrame frame;
+        board.collectChunks(x, y, terminal.getCellWidth(),
+                            terminal.getCellHeight(), frame);
+        out = &terminal.render(frame, x, y);
+      } else {
+        out = &terminal.render(board, x, y);
+      }
+
+      size_t row = 0, column = 0;
+      for (size_t i = 0; i < out->size();) {
+        if (out->compare(i, 4, "\033[2J") == 0) {
+          std::fill(screen.begin(), screen.end(), " ");
+          i += 4;
+        } else if ((*out)[i] == '\033') {
+          size_t semicolon = out->find(';', i), end = out->find('H', i);
+          row = std::stoul(out->substr(i + 2, semicolon - i - 2)) - 1;
+          column = std::stoul(out->substr(semicolon + 1, end - semicolon)) - 1;
+          i = end + 1;
+        } else {
+          size_t length = (*out)[i] & 0x80 ? 3 : 1;
+          if (row >= rows || column >= columns) {
+            std::cerr << name << " terminal wrote off the screen at row "
+                      << row << " column " << column << '\n';
+            return false;
+          }
+          screen[row * columns + column] = out->substr(i, length);
+          column++;
+          i += length;
+        }
+      }
+      if (row != rows || column != 0) {
+        std::cerr << name << " terminal left the cursor at row " << row
+                  << " column " << column << '\n';
+        return false;
+      }
+
+      // Braille dots are numbered down the left column then the right one,
+      // with the bottom row added on at the end
+      const uint32_t brailleDots[2][4] = {{0x01, 0x02, 0x04, 0x40},
+                                          {0x08, 0x10, 0x20, 0x80}};
+      const std::string halfBlocks[4] = {" ", "▀", "▄", "█"};
+      for (int32_t r = 0; r < rows; r++) {
+        for (int32_t c = 0; c < columns; c++) {
+          uint32_t dots = 0;
+          for (int32_t dy = 0; dy < glyphHeight; dy++) {
+            for (int32_t dx = 0; dx < glyphWidth; dx++) {
+              int32_t cellY =
+                  y + terminal.getCellHeight() - 1 - r * glyphHeight - dy;
+              if (board.getPoint(x + c * glyphWidth + dx, cellY)) {
+                dots |= braille ? brailleDots[dx][dy] : 1 << dy;
+              }
+            }
+          }
+          std::string expected = " ";
+          if (!braille) {
+            expected = halfBlocks[dots];
+          } else if (dots != 0) {
+            expected = {char(0xe2), char(0xa0 | dots >> 6),
+                        char(0x80 | (dots & 0x3f))};
+          }
+          if (screen[r * columns + c] != expected) {
+            std::cerr << name << " terminal shows the wrong glyph at row "
+                      << r << " column " << c << " in generation "
+                      << generation << '\n';
+            return false;
+          }
+        }
+      }
+
+      board.update();
+    }
+
+    // Nothing changed, only the cursor moves
+    terminal.render(board, x, y);
+    terminal.render(board, x, y);
+    if (terminal.getStats().changedGlyphs != 0 ||
+        terminal.getStats().spans != 0) {
+      std::cerr << name << " terminal sent glyphs that didn't change\n";
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,181 @@
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "DenseBoard.h"
+#include "GameBoard.h"
+#include "HashLife.h"
+#include "Tests.h"
+#include "io/Macrocell.h"
+#include "io/Rle.h"
+
+namespace {
+
+bool parses() {
+  if (Rule::parse("B36/S23") != Rules::k_highLife ||
+      Rule::parse("s23 / b36") != Rules::k_highLife ||
+      Rule::parse("23/36") != Rules::k_highLife ||
+      Rule::parse("b3s23") != Rules::k_life ||
+      Rule::parse("B2/S") != Rules::k_seeds ||
+      Rules::k_dayAndNight.toString() != "B3678/S34678") {
+    std::cerr << "A rule was read or written wrong\n";
+    return false;
+  }
+  for (const char *bad : {"B0/S23", "B3/S9", "B3", "3/23/x", "life", ""}) {
+    try {
+      Rule::parse(bad);
+      std::cerr << "Read \"" << bad << "\" as a rule\n";
+      return false;
+    } catch (const std::invalid_argument &) {
+    }
+  }
+  return true;
+}
+
+/**
+ * Soups on tori of every engine that runs whole rows, Life first for long
+ * enough that most of it is holding still or blinking and then going over
+ * to rule
+ */
+bool switchesTo(const Rule &rule) {
+  using Topology = LifeEngine::Topology;
+  constexpr int32_t size = GameBoard::ChunkType::k_size;
+  constexpr int32_t width = 6 * size, height = 4 * size;
+
+  // The chunks are stepped in vector lanes on one board and one by one on
+  // the other
+  GameBoard board(Topology::Torus, width, height);
+  GameBoard scalar(Topology::Torus, width, height);
+  scalar.setSimdLevel(SimdLevel::SCALAR);
+  DenseBoard dense(Topology::Torus, width, height);
+  std::vector<LifeEngine *> engines = {&board, &scalar, &dense};
+  const char *names[] = {"GameBoard", "scalar GameBoard", "DenseBoard"};
+
+  Reference reference(0, 0, width, height, Topology::Torus);
+  std::mt19937 rng(rule.birth * 512 + rule.survive);
+  std::bernoulli_distribution alive(0.3);
+  for (int32_t y = 0; y < height; y++) {
+    for (int32_t x = 0; x < width; x++) {
+      bool cell = alive(rng);
+      reference.set(x, y, cell);
+      for (LifeEngine *engine : engines) {
+        engine->setPoint(x, y, cell);
+      }
+    }
+  }
+
+  for (int generation = 0; generation < 80; generation++) {
+    if (generation == 30) {
+      reference.setRule(rule);
+      for (LifeEngine *engine : engines) {
+        engine->setRule(rule);
+      }
+    }
+    for (size_t e = 0; e < engines.size(); e++) {
+      if (!reference.matches(*engines[e])) {
+        std::cerr << names[e] << " going over to " << rule.toString()
+                  << " differs from the reference at generation "
+                  << generation << '\n';
+        return false;
+      }
+    }
+    for (LifeEngine *engine : engines) {
+      engine->update();
+    }
+    reference.step();
+  }
+
+  if (board.getRule() != rule || dense.getRule() != rule) {
+    std::cerr << "The engines don't say they run " << rule.toString()
+              << '\n';
+    return false;
+  }
+  return true;
+}
+
+/**
+ * An unbounded board against HashLife, which has results it remembered
+ * from Life that it has to forget
+ */
+bool unboundedSwitchesTo(const Rule &rule) {
+  GameBoard board;
+  HashLife hashLife(1 << 14);
+  for (LifeEngine *engine : {(LifeEngine *)&board, (LifeEngine *)&hashLife}) {
+    std::mt19937 rng(11);
+    fillSoup(*engine, 0, 0, 48, 48, 0.35, rng);
+    engine->step(3);
+    engine->setRule(rule);
+    for (uint32_t k = 0; k <= 4; k++) {
+      engine->step(k);
+    }
+  }
+  if (!sameCells(board, hashLife, -100, -100, 250, 250)) {
+    std::cerr << "HashLife going over to " << rule.toString()
+              << " differs from a GameBoard\n";
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Patterns carry their rule with them, and one that can't be run is turned
+ * down
+ */
+bool patternsKeepRule() {
+  GameBoard highLife;
+  highLife.setRule(Rules::k_highLife);
+  std::mt19937 rng(2);
+  fillSoup(highLife, 0, 0, 20, 20, 0.35, rng);
+  std::stringstream rle, mc;
+  Rle::write(rle, highLife);
+  Macrocell::write(mc, highLife);
+  GameBoard fromRle;
+  HashLife fromMc;
+  Rle::read(rle, fromRle);
+  Macrocell::read(mc, fromMc);
+  if (rle.str().find("rule = B36/S23") == std::string::npos ||
+      fromRle.getRule() != Rules::k_highLife ||
+      fromMc.getRule() != Rules::k_highLife) {
+    std::cerr << "HighLife didn't come back from a pattern file\n";
+    return false;
+  }
+
+  std::istringstream b0("x = 1, y = 1, rule = B0/S8\no!\n");
+  try {
+    Rle::read(b0, fromRle);
+    std::cerr << "Read a pattern with B0\n";
+    return false;
+  } catch (const std::invalid_argument &) {
+  }
+  return true;
+}
+
+} // namespace
+
+/**
+ * The kernels themselves are checked against the reference for these rules
+ * in chunkStepTest(), this is about the engines switching over to them
+ */
+bool ruleTest() {
+  if (!parses()) {
+    return false;
+  }
+
+  // The ones with kernels of their own and a few that go through AnyRule
+  for (const Rule &rule :
+       {Rules::k_life, Rules::k_highLife, Rules::k_seeds,
+        Rules::k_dayAndNight, Rule::parse("B36/S125"),
+        Rule::parse("B3/S012345678"), Rule::parse("B1/S1")}) {
+    if (!switchesTo(rule)) {
+      return false;
+    }
+  }
+  for (const Rule &rule : {Rules::k_highLife, Rule::parse("B36/S125")}) {
+    if (!unboundedSwitchesTo(rule)) {
+      return false;
+    }
+  }
+  return patternsKeepRule();
+}
@@ -0,0 +1,192 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "GameBoard.h"
+#include "Tests.h"
+#include "io/DeltaLog.h"
+#include "io/Snapshot.h"
+
+namespace {
+
+std::string tempPath(const char *name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+/**
+ * Saves a board that has been running for a bit and loads it back eagerly
+ * and lazily, the copies have to look the same and keep running the same
+ */
+template <typename ChunkT>
+bool snapshots(const char *name, const std::string &path) {
+  BasicGameBoard<ChunkT> board;
+  std::mt19937 rng(11);
+  fillSoup(board, -90, -40, 120, 120, 0.35, rng);
+  for (int i = 0; i < 5; i++) {
+    board.update();
+  }
+  board.saveSnapshot(path);
+
+  BasicGameBoard<ChunkT> eager, lazy;
+  eager.loadSnapshot(path);
+  lazy.loadSnapshot(path, true);
+
+  // Bounds and a region come out of the lazy board before the rest of it is
+  // loaded in
+  auto bounds = board.getBounds();
+  if (bounds != lazy.getBounds() || bounds != eager.getBounds() ||
+      !sameCells(board, lazy, -60, -30, 100, 100)) {
+    std::cerr << name << " snapshot loaded back with different cells\n";
+    return false;
+  }
+
+  for (int i = 0; i < 10; i++) {
+    if (!sameCells(board, eager, -150, -100, 260, 260) ||
+        !sameCells(board, lazy, -150, -100, 260, 260)) {
+      std::cerr << name << " snapshot stepped differently " << i
+                << " generations after loading\n";
+      return false;
+    }
+    board.update();
+    eager.update();
+    lazy.update();
+  }
+  return true;
+}
+
+} // namespace
+
+bool snapshotTest() {
+  std::string path = tempPath("gol_snapshot_test.bin");
+  bool result = snapshots<Chunk8>("Chunk8", path) &&
+                snapshots<Chunk30>("Chunk30", path) &&
+                snapshots<Chunk64>("Chunk64", path);
+
+  // Chunks of another size can't be loaded
+  try {
+    BasicGameBoard<Chunk62> other;
+    other.loadSnapshot(path);
+    std::cerr << "A snapshot of 64 cell chunks loaded into 62 cell ones\n";
+    result = false;
+  } catch (const std::runtime_error &) {
+  }
+
+  // A chunk count big enough that its size wraps around to a small one
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    uint64_t count = uint64_t(1) << 61;
+    file.seekp(offsetof(Snapshot::Header, chunkCount));
+    file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  }
+  try {
+    BasicGameBoard<Chunk64> corrupt;
+    corrupt.loadSnapshot(path);
+    std::cerr << "Loaded a snapshot with a chunk count it doesn't have\n";
+    result = false;
+  } catch (const std::runtime_error &) {
+  }
+  std::remove(path.c_str());
+  return result;
+}
+
+/**
+ * Runs a board with cells being set along the way while logging it in two
+ * pieces, compacts the first piece and then plays the logs back from both
+ * snapshots
+ */
+bool deltaLogTest() {
+  std::string base = tempPath("gol_delta_base.bin");
+  std::string compacted = tempPath("gol_delta_compacted.bin");
+  std::string log0 = tempPath("gol_delta_0.log");
+  std::string log1 = tempPath("gol_delta_1.log");
+  auto removeAll = [&]() {
+    for (const std::string &path : {base, compacted, log0, log1}) {
+      std::remove(path.c_str());
+    }
+  };
+
+  constexpr int32_t lo = -200, size = 400;
+  auto cells = [&](GameBoard &board) {
+    std::vector<uint64_t> bits(size * LifeEngine::regionStride(size));
+    board.getRegion(lo, lo, size, size, bits.data());
+    return bits;
+  };
+
+  GameBoard board;
+  std::mt19937 rng(5);
+  fillSoup(board, -50, -50, 100, 100, 0.35, rng);
+  board.saveSnapshot(base);
+  board.startDeltaLog(log0);
+  board.setPoint(-60, -60, true);
+
+  std::vector<uint64_t> at10, at20;
+  std::future<uint64_t> compacting;
+  for (int i = 1; i <= 30; i++) {
+    board.update();
+    if (i == 10) {
+      at10 = cells(board);
+    }
+    if (i == 15) {
+      board.startDeltaLog(log1);
+      compacting = DeltaLog::compactAsync(base, log0, compacted);
+    }
+    if (i == 12 || i == 20) {
+      fillSoup(board, 30, -80, 30, 30, 0.35, rng);
+    }
+    if (i == 20) {
+      at20 = cells(board);
+    }
+  }
+  board.stopDeltaLog();
+
+  // A record at the end asking for far more than the file has is the same
+  // as one cut short
+  {
+    std::ofstream out(log1, std::ios::binary | std::ios::app);
+    DeltaLog::RecordHeader huge{31, UINT32_MAX, 0, UINT32_MAX, 0};
+    out.write(reinterpret_cast<const char *>(&huge), sizeof(huge));
+  }
+
+  uint64_t compactedTo = compacting.get();
+  if (compactedTo != 15) {
+    std::cerr << "Compacting the first log got to generation "
+              << compactedTo << " instead of 15\n";
+    removeAll();
+    return false;
+  }
+
+  GameBoard from0;
+  from0.loadSnapshot(base);
+  from0.replayDeltaLog(log0, 10);
+
+  GameBoard from15, lazy;
+  from15.loadSnapshot(compacted);
+  from15.replayDeltaLog(log1, 30);
+  lazy.loadSnapshot(compacted, true);
+  lazy.replayDeltaLog(log1, 20);
+  removeAll();
+
+  if (cells(from0) != at10 || from15.getGeneration() != 30 ||
+      cells(from15) != cells(board) || cells(lazy) != at20) {
+    std::cerr << "Playing the logs back didn't get the same cells\n";
+    return false;
+  }
+
+  // And they keep going the same
+  for (int i = 0; i < 5; i++) {
+    board.update();
+    from15.update();
+  }
+  if (cells(from15) != cells(board)) {
+    std::cerr << "The board played back stepped differently\n";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "LifeEngine.h"
+#include "Reference.h"
+
+/**
+ * The tests run by tests/main.cpp. Each one returns true if it passed and
+ * says what went wrong on std::cerr if it didn't, with the seed so it can
+ * be run again.
+ */
+
+// ChunkTests.cpp
+bool chunkStepTest();
+bool chunkFlagsTest();
+
+// ChunkMapTests.cpp
+bool chunkMapTest();
+
+// BoardTests.cpp
+bool boardSoupTest();
+bool boardTorusTest();
+bool boardEditTest();
+bool boardCleanupTest();
+bool boardActiveSetTest();
+bool boardBoundedTest();
+
+// RegionTests.cpp
+bool regionTest();
+
+// PatternTests.cpp
+bool oscillatorTest();
+bool spaceshipTest();
+bool rleOffsetTest();
+bool patternIoTest();
+
+// HashLifeTests.cpp
+bool hashLifeTest();
+
+// SnapshotTests.cpp
+bool snapshotTest();
+bool deltaLogTest();
+
+// DenseBoardTests.cpp
+bool denseBoardTest();
+
+// RuleTests.cpp
+bool ruleTest();
+
+// GenerationsTests.cpp
+bool generationsTest();
+
+// PipelineTests.cpp
+bool pipelineTest();
+
+// RenderTests.cpp
+bool densityTest();
+bool rendererTest();
+bool terminalTest();
+
+// ProfilerTests.cpp
+bool profilerTest();
+
+// LoggerTests.cpp
+bool loggerTest();
+
+/**
+ * Fills a width x height rectangle with its bottom left corner at (x, y)
+ * with cells that are alive with chance density
+ */
+inline void fillSoup(LifeEngine &engine, int32_t x, int32_t y, int32_t width,
+                     int32_t height, double density, std::mt19937 &rng) {
+  std::bernoulli_distribution alive(density);
+  for (int32_t row = 0; row < height; row++) {
+    for (int32_t col = 0; col < width; col++) {
+      engine.setPoint(x + col, y + row, alive(rng));
+    }
+  }
+}
+
+/**
+ * Fills a width x height rectangle with its bottom left corner at (x, y)
+ * with cells that are alive with chance density, on the engine and the
+ * reference both
+ */
+inline void fillSoup(LifeEngine &engine, Reference &reference, int32_t x,
+                     int32_t y, int32_t width, int32_t height,
+                     double density, std::mt19937 &rng) {
+  std::bernoulli_distribution alive(density);
+  for (int32_t row = 0; row < height; row++) {
+    for (int32_t col = 0; col < width; col++) {
+      bool cell = alive(rng);
+      engine.setPoint(x + col, y + row, cell);
+      reference.set(x + col, y + row, cell);
+    }
+  }
+}
+
+/**
+ * True if both engines have the same cells in the width x height rectangle
+ * with its bottom left corner at (x, y)
+ */
+inline bool sameCells(LifeEngine &a, LifeEngine &b, int32_t x, int32_t y,
+                      int32_t width, int32_t height) {
+  size_t words = LifeEngine::regionStride(width) * height;
+  std::vector<uint64_t> aBits(words), bBits(words);
+  a.getRegion(x, y, width, height, aBits.data());
+  b.getRegion(x, y, width, height, bBits.data());
+  return aBits == bBits;
+}
@@ -0,0 +1,69 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "Tests.h"
+
+namespace {
+
+struct Test {
+  const char *name;
+  bool (*run)();
+};
+
+constexpr Test k_tests[] = {
+    {"chunk step", chunkStepTest},
+    {"chunk flags", chunkFlagsTest},
+    {"chunk map", chunkMapTest},
+    {"board soups", boardSoupTest},
+    {"board torus", boardTorusTest},
+    {"board edits", boardEditTest},
+    {"board cleanup", boardCleanupTest},
+    {"board active set", boardActiveSetTest},
+    {"board bounded", boardBoundedTest},
+    {"regions", regionTest},
+    {"oscillators", oscillatorTest},
+    {"spaceships", spaceshipTest},
+    {"rle offsets", rleOffsetTest},
+    {"pattern io", patternIoTest},
+    {"hashlife", hashLifeTest},
+    {"snapshots", snapshotTest},
+    {"delta log", deltaLogTest},
+    {"dense board", denseBoardTest},
+    {"rules", ruleTest},
+    {"generations", generationsTest},
+    {"pipeline", pipelineTest},
+    {"density", densityTest},
+    {"renderer", rendererTest},
+    {"terminal", terminalTest},
+    {"profiler", profilerTest},
+    {"logger", loggerTest},
+};
+
+} // namespace
+
+/**
+ * Runs every test, or only the ones with a name containing the first
+ * argument, and exits with 1 if any of them failed
+ */
+int main(int argc, char **argv) {
+  std::string filter = argc > 1 ? argv[1] : "";
+  int failed = 0;
+
+  for (const Test &test : k_tests) {
+    if (std::string(test.name).find(filter) == std::string::npos) {
+      continue;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool result = test.run();
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << test.name << ": " << (result ? "success" : "failed") << " ("
+              << elapsed.count() << " ms)" << std::endl;
+    failed += !result;
+  }
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}